@@ -34,12 +34,12 @@
 
 #include "ApproximateCoplanarFilter.hpp"
 
-#include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
 #include <Eigen/Dense>
 
+#include "private/Neighborhoods.hpp"
+
 #include <string>
 #include <vector>
 
@@ -79,15 +79,13 @@ void ApproximateCoplanarFilter::filter(PointView& view)
 {
     using namespace Eigen;
 
-    KD3Index& kdi = view.build3dIndex();
-
-    for (PointId i = 0; i < view.size(); ++i)
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn);
+    hoods.run({ m_coplanar },
+        [this, &hoods](const Neighborhood& n, double *values)
     {
-        // find the k-nearest neighbors
-        auto ids = kdi.neighbors(i, m_knn);
-
         // compute covariance of the neighborhood
-        auto B = computeCovariance(view, ids);
+        auto B = hoods.covariance(n);
 
         // perform the eigen decomposition
         SelfAdjointEigenSolver<Matrix3d> solver(B);
@@ -96,11 +94,8 @@ void ApproximateCoplanarFilter::filter(PointView& view)
         auto ev = solver.eigenvalues();
 
         // test eigenvalues to label points that are approximately coplanar
-        if ((ev[1] > m_thresh1 * ev[0]) && (m_thresh2 * ev[1] > ev[2]))
-            view.setField(m_coplanar, i, 1u);
-        else
-            view.setField(m_coplanar, i, 0u);
-    }
+        values[0] = (ev[1] > m_thresh1 * ev[0]) && (m_thresh2 * ev[1] > ev[2]);
+    });
 }
 
 } // namespace pdal
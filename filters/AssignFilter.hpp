@@ -49,6 +49,8 @@ public:
     ~AssignFilter();
 
     std::string getName() const { return "filters.assign"; }
+    virtual bool reentrant() const
+        { return true; }
 
 private:
     virtual void addArgs(ProgramArgs& args);
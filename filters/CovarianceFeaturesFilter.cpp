@@ -38,12 +38,12 @@
 
 #include "CovarianceFeaturesFilter.hpp"
 
-#include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
 #include <Eigen/Dense>
 
+#include "private/Neighborhoods.hpp"
+
 #include <string>
 #include <vector>
 #include <cmath>
@@ -68,7 +68,6 @@ std::string CovarianceFeaturesFilter::getName() const
 void CovarianceFeaturesFilter::addArgs(ProgramArgs& args)
 {
     args.add("knn", "k-Nearest neighbors", m_knn, 10);
-    args.add("threads", "Number of threads used to run this filter", m_threads, 1);
     args.add("feature_set", "Set of features to be computed", m_featureSet, "Dimensionality");
     args.add("stride", "Compute features on strided neighbors", m_stride, size_t(1));
 }
@@ -84,34 +83,21 @@ void CovarianceFeaturesFilter::addDimensions(PointLayoutPtr layout)
 
 void CovarianceFeaturesFilter::filter(PointView& view)
 {
-
-    KD3Index& kdi = view.build3dIndex();
-
-    point_count_t nloops = view.size();
-    std::vector<std::thread> threadList(m_threads);
-    for(int t = 0;t<m_threads;t++)
-    {
-        threadList[t] = std::thread(std::bind(
-                [&](const PointId start, const PointId end)
-                {
-                    for(PointId i = start;i<end;i++)
-                        setDimensionality(view, i, kdi);
-                },
-                t*nloops/m_threads,(t+1)==m_threads?nloops:(t+1)*nloops/m_threads));
-    }
-    for (auto &t: threadList)
-        t.join();
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn + 1, m_stride);
+    hoods.run({ m_extraDims["Linearity"], m_extraDims["Planarity"],
+        m_extraDims["Scattering"], m_extraDims["Verticality"] },
+        [this, &hoods](const Neighborhood& n, double *values)
+        { setDimensionality(hoods, n, values); });
 }
 
-void CovarianceFeaturesFilter::setDimensionality(PointView &view, const PointId &id, const KD3Index &kid)
+void CovarianceFeaturesFilter::setDimensionality(const Neighborhoods& hoods,
+    const Neighborhood& n, double *values)
 {
     using namespace Eigen;
 
-    // find the k-nearest neighbors
-    auto ids = kid.neighbors(id, m_knn + 1, m_stride);
-
     // compute covariance of the neighborhood
-    auto B = computeCovariance(view, ids);
+    auto B = hoods.covariance(n);
 
     // perform the eigen decomposition
     SelfAdjointEigenSolver<Matrix3d> solver(B);
@@ -139,9 +125,9 @@ void CovarianceFeaturesFilter::setDimensionality(PointView &view, const PointId
     double linearity  = (sqrt(lambda[0]) - sqrt(lambda[1])) / sqrt(lambda[0]);
     double planarity  = (sqrt(lambda[1]) - sqrt(lambda[2])) / sqrt(lambda[0]);
     double scattering =  sqrt(lambda[2]) / sqrt(lambda[0]);
-    view.setField(m_extraDims["Linearity"], id, linearity);
-    view.setField(m_extraDims["Planarity"], id, planarity);
-    view.setField(m_extraDims["Scattering"], id, scattering);
+    values[0] = linearity;
+    values[1] = planarity;
+    values[2] = scattering;
 
     std::vector<double> unary_vector(3);
     double norm = 0;
@@ -151,6 +137,6 @@ void CovarianceFeaturesFilter::setDimensionality(PointView &view, const PointId
         norm += unary_vector[i] * unary_vector[i];
     }
     norm = sqrt(norm);
-    view.setField(m_extraDims["Verticality"], id, unary_vector[2] / norm);
+    values[3] = unary_vector[2] / norm;
 }
 }
@@ -34,12 +34,13 @@
 
 #pragma once
 
-#include <thread>
-
 #include <pdal/Filter.hpp>
 
 namespace pdal {
 
+class Neighborhoods;
+struct Neighborhood;
+
 class PDAL_DLL CovarianceFeaturesFilter: public Filter
 {
 public:
@@ -52,7 +53,6 @@ public:
 private:
 
     int m_knn;
-    int m_threads;
     std::string m_featureSet;
     std::map<std::string,Dimension::Id> m_extraDims;
     size_t m_stride;
@@ -61,7 +61,8 @@ private:
     virtual void addArgs(ProgramArgs &args);
     virtual void filter(PointView &view);
 
-    void setDimensionality(PointView &view, const PointId &id, const KD3Index &kid);
+    void setDimensionality(const Neighborhoods& hoods, const Neighborhood& n,
+        double *values);
 };
 }
 
@@ -105,6 +105,15 @@ void CropFilter::addArgs(ProgramArgs& args)
 }
 
 
+bool CropFilter::usedDimensions(StringList& dims) const
+{
+    dims.push_back("X");
+    dims.push_back("Y");
+    dims.push_back("Z");
+    return true;
+}
+
+
 void CropFilter::initialize()
 {
     // Set geometry from polygons.
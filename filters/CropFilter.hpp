@@ -80,6 +80,7 @@ private:
 
     void addArgs(ProgramArgs& args);
     virtual void initialize();
+    virtual bool usedDimensions(StringList& dims) const;
 
     virtual void ready(PointTableRef table);
     virtual void spatialReferenceChanged(const SpatialReference& srs);
@@ -58,6 +58,8 @@ private:
     virtual void addArgs(ProgramArgs& args);
     void ready(PointTableRef table)
         { m_index = 0; }
+    bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
     bool processOne(PointRef& point);
     PointViewSet run(PointViewPtr view);
     void decimate(PointView& input, PointView& output);
@@ -34,10 +34,10 @@
 
 #include "EigenvaluesFilter.hpp"
 
-#include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include "private/Neighborhoods.hpp"
+
 #include <Eigen/Dense>
 
 #include <string>
@@ -79,15 +79,13 @@ void EigenvaluesFilter::filter(PointView& view)
 {
     using namespace Eigen;
 
-    KD3Index& kdi = view.build3dIndex();
-
-    for (PointId i = 0; i < view.size(); ++i)
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn);
+    hoods.run({ m_e0, m_e1, m_e2 },
+        [this, &hoods](const Neighborhood& n, double *values)
     {
-        // find the k-nearest neighbors
-        auto ids = kdi.neighbors(i, m_knn);
-
         // compute covariance of the neighborhood
-        auto B = computeCovariance(view, ids);
+        auto B = hoods.covariance(n);
 
         // perform the eigen decomposition
         SelfAdjointEigenSolver<Matrix3d> solver(B);
@@ -101,10 +99,10 @@ void EigenvaluesFilter::filter(PointView& view)
             ev /= sum;
         }
 
-        view.setField(m_e0, i, ev[0]);
-        view.setField(m_e1, i, ev[1]);
-        view.setField(m_e2, i, ev[2]);
-    }
+        values[0] = ev[0];
+        values[1] = ev[1];
+        values[2] = ev[2];
+    });
 }
 
 } // namespace pdal
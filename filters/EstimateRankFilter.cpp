@@ -34,10 +34,12 @@
 
 #include "EstimateRankFilter.hpp"
 
-#include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include <Eigen/Dense>
+
+#include "private/Neighborhoods.hpp"
+
 #include <string>
 #include <vector>
 
@@ -73,15 +75,15 @@ void EstimateRankFilter::addDimensions(PointLayoutPtr layout)
 
 void EstimateRankFilter::filter(PointView& view)
 {
-    KD3Index& kdi = view.build3dIndex();
-
-    for (PointId i = 0; i < view.size(); ++i)
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn);
+    hoods.run({ m_rank }, [this, &hoods](const Neighborhood& n, double *values)
     {
-        // find the k-nearest neighbors
-        auto ids = kdi.neighbors(i, m_knn);
-
-        view.setField(m_rank, i, computeRank(view, ids, m_thresh));
-    }
+        // Estimate the rank as computeRank() does.
+        Eigen::JacobiSVD<Eigen::Matrix3d> svd(hoods.covariance(n));
+        svd.setThreshold((float)m_thresh);
+        values[0] = svd.rank();
+    });
 }
 
 } // namespace pdal
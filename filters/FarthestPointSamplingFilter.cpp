@@ -34,10 +34,11 @@
 
 #include "FarthestPointSamplingFilter.hpp"
 
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/private/Executor.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <numeric>
 #include <string>
@@ -51,6 +52,264 @@ static PluginInfo const s_info{"filters.fps", "Farthest point sampling filter",
 
 CREATE_STATIC_STAGE(FarthestPointSamplingFilter, s_info)
 
+namespace
+{
+
+// Points held in a tree of boxes, each of which records the largest
+// distance of its points to the nearest sample.  A new sample only moves
+// points closer to it than their current distance, so boxes farther from
+// the sample than their largest distance are skipped.  As samples are
+// added, distances shrink and most of the tree is skipped.  Subtrees near
+// the top of the tree are updated in parallel.
+class SampleTree
+{
+public:
+    SampleTree(const PointView& view);
+
+    // Position of the farthest point from all samples.
+    size_t farthest() const
+        { return m_nodes[0].m_far; }
+    PointId id(size_t pos) const
+        { return m_ids[pos]; }
+    double distance(size_t pos) const
+        { return m_dists[pos]; }
+    size_t position(PointId id) const;
+
+    void addSample(size_t pos);
+
+private:
+    static const size_t LeafSize = 256;
+
+    struct Node
+    {
+        size_t m_begin;
+        size_t m_end;
+        double m_min[3];
+        double m_max[3];
+        size_t m_far;      // Position of the point farthest from samples.
+        size_t m_left;     // Zero for leaves.
+        size_t m_right;
+    };
+
+    void build();
+    void update(size_t n, const double *s);
+    void updateLeaf(Node& node, const double *s);
+    void merge(Node& node);
+    bool farther(size_t a, size_t b) const;
+    double boxDistance(const Node& node, const double *s) const;
+    double farDistance(const Node& node) const
+        { return m_dists[node.m_far]; }
+
+    std::vector<double> m_pos;
+    std::vector<double> m_dists;
+    PointIdList m_ids;
+    std::vector<Node> m_nodes;
+    // Roots of the subtrees updated in parallel and the nodes above them,
+    // parents first.
+    std::vector<size_t> m_tasks;
+    std::vector<size_t> m_upper;
+    std::vector<size_t> m_visit;
+};
+
+
+SampleTree::SampleTree(const PointView& view)
+{
+    const point_count_t count = view.size();
+    std::vector<double> vals(count);
+
+    m_pos.resize(count * 3);
+    const Dimension::Id dims[] =
+        { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+    for (size_t d = 0; d < 3; ++d)
+    {
+        view.getFieldArray(dims[d], 0, count, vals.data());
+        for (PointId i = 0; i < count; ++i)
+            m_pos[i * 3 + d] = vals[i];
+    }
+    m_ids.resize(count);
+    std::iota(m_ids.begin(), m_ids.end(), 0);
+    m_dists.assign(count, (std::numeric_limits<double>::max)());
+    build();
+}
+
+
+// Split the points at the median of the longest side of their box until
+// boxes hold few enough points.  Children always follow their parent in
+// the list of nodes.  Points are then stored in the order of the leaves.
+void SampleTree::build()
+{
+    const size_t count = m_ids.size();
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+
+    const size_t numTasks = Executor::global().threads() * 8;
+    m_nodes.push_back(Node { 0, count, {}, {}, 0, 0, 0 });
+    std::vector<std::pair<size_t, size_t>> stack { { 0, 0 } };
+    size_t taskDepth = 0;
+    while ((size_t)1 << taskDepth < numTasks && count > 65536)
+        taskDepth++;
+
+    while (stack.size())
+    {
+        const size_t n = stack.back().first;
+        const size_t depth = stack.back().second;
+        stack.pop_back();
+
+        Node node = m_nodes[n];
+        for (size_t d = 0; d < 3; ++d)
+        {
+            node.m_min[d] = (std::numeric_limits<double>::max)();
+            node.m_max[d] = std::numeric_limits<double>::lowest();
+        }
+        for (size_t i = node.m_begin; i < node.m_end; ++i)
+            for (size_t d = 0; d < 3; ++d)
+            {
+                const double v = m_pos[order[i] * 3 + d];
+                node.m_min[d] = (std::min)(node.m_min[d], v);
+                node.m_max[d] = (std::max)(node.m_max[d], v);
+            }
+        node.m_far = node.m_begin;
+
+        if (depth == taskDepth ||
+            (depth < taskDepth && node.m_end - node.m_begin <= LeafSize))
+            m_tasks.push_back(n);
+        else if (depth < taskDepth)
+            m_upper.push_back(n);
+
+        if (node.m_end - node.m_begin > LeafSize)
+        {
+            size_t axis = 0;
+            for (size_t d = 1; d < 3; ++d)
+                if (node.m_max[d] - node.m_min[d] >
+                        node.m_max[axis] - node.m_min[axis])
+                    axis = d;
+
+            const size_t mid = node.m_begin + (node.m_end - node.m_begin) / 2;
+            std::nth_element(order.begin() + node.m_begin,
+                order.begin() + mid, order.begin() + node.m_end,
+                [this, axis](size_t a, size_t b)
+                { return m_pos[a * 3 + axis] < m_pos[b * 3 + axis]; });
+
+            node.m_left = m_nodes.size();
+            node.m_right = node.m_left + 1;
+            m_nodes.push_back(Node { node.m_begin, mid, {}, {}, 0, 0, 0 });
+            m_nodes.push_back(Node { mid, node.m_end, {}, {}, 0, 0, 0 });
+            stack.push_back({ node.m_right, depth + 1 });
+            stack.push_back({ node.m_left, depth + 1 });
+        }
+        m_nodes[n] = node;
+    }
+    std::sort(m_upper.begin(), m_upper.end());
+
+    std::vector<double> pos(m_pos.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::copy(m_pos.begin() + order[i] * 3,
+            m_pos.begin() + order[i] * 3 + 3, pos.begin() + i * 3);
+        m_ids[i] = order[i];
+    }
+    m_pos.swap(pos);
+}
+
+
+size_t SampleTree::position(PointId id) const
+{
+    return std::find(m_ids.begin(), m_ids.end(), id) - m_ids.begin();
+}
+
+
+// Points are farther when their distance is larger.  Ties go to the lowest
+// point ID so that samples don't depend on the order of the tree.
+bool SampleTree::farther(size_t a, size_t b) const
+{
+    return m_dists[a] > m_dists[b] ||
+        (m_dists[a] == m_dists[b] && m_ids[a] < m_ids[b]);
+}
+
+
+double SampleTree::boxDistance(const Node& node, const double *s) const
+{
+    double dist = 0;
+    for (size_t d = 0; d < 3; ++d)
+    {
+        double delta = (std::max)((std::max)(node.m_min[d] - s[d], 0.0),
+            s[d] - node.m_max[d]);
+        dist += delta * delta;
+    }
+    return dist;
+}
+
+
+void SampleTree::updateLeaf(Node& node, const double *s)
+{
+    size_t far = node.m_begin;
+    for (size_t i = node.m_begin; i < node.m_end; ++i)
+    {
+        const double *p = m_pos.data() + i * 3;
+        const double dx = p[0] - s[0];
+        const double dy = p[1] - s[1];
+        const double dz = p[2] - s[2];
+        const double dist = dx * dx + dy * dy + dz * dz;
+        if (dist < m_dists[i])
+            m_dists[i] = dist;
+        if (farther(i, far))
+            far = i;
+    }
+    node.m_far = far;
+}
+
+
+void SampleTree::merge(Node& node)
+{
+    const size_t left = m_nodes[node.m_left].m_far;
+    const size_t right = m_nodes[node.m_right].m_far;
+    node.m_far = farther(right, left) ? right : left;
+}
+
+
+void SampleTree::update(size_t n, const double *s)
+{
+    Node& node = m_nodes[n];
+    if (boxDistance(node, s) >= farDistance(node))
+        return;
+    if (node.m_left)
+    {
+        update(node.m_left, s);
+        update(node.m_right, s);
+        merge(node);
+    }
+    else
+        updateLeaf(node, s);
+}
+
+
+// Subtrees that the sample may change are updated in parallel, after which
+// the nodes above them are brought up to date, children first.
+void SampleTree::addSample(size_t pos)
+{
+    const double s[3] = { m_pos[pos * 3], m_pos[pos * 3 + 1],
+        m_pos[pos * 3 + 2] };
+
+    m_visit.clear();
+    for (size_t n : m_tasks)
+        if (boxDistance(m_nodes[n], s) < farDistance(m_nodes[n]))
+            m_visit.push_back(n);
+
+    if (m_visit.size() == 1)
+        update(m_visit.front(), s);
+    else if (m_visit.size() > 1)
+        parallelFor(0, m_visit.size(), 1, [this, &s](size_t b, size_t e)
+        {
+            for (size_t i = b; i < e; ++i)
+                update(m_visit[i], s);
+        });
+
+    for (auto it = m_upper.rbegin(); it != m_upper.rend(); ++it)
+        merge(m_nodes[*it]);
+}
+
+} // unnamed namespace
+
 std::string FarthestPointSamplingFilter::getName() const
 {
     return s_info.name;
@@ -76,48 +335,33 @@ PointViewSet FarthestPointSamplingFilter::run(PointViewPtr inView)
     // Otherwise, make a new output PointView.
     PointViewPtr outView = inView->makeNew();
 
-    // Construct a KD-tree of the input view.
-    KD3Index& kdi = inView->build3dIndex();
+    // Sort the points of the input view into a tree of boxes.
+    SampleTree tree(*inView);
 
-    // Seed the output view with the first point in the current sorting.
+    // Seed the output view with the first point in the current sorting and
+    // compute the distances from it to all other points.
     PointId seedId(0);
     outView->appendPoint(*inView, seedId);
-
-    // Compute distances from seedId to all other points.
-    PointIdList indices(inView->size());
-    std::vector<double> sqr_dists(inView->size());
-    kdi.knnSearch(seedId, inView->size(), &indices, &sqr_dists);
-
-    // Sort distances by PointId.
-    std::vector<double> min_dists(inView->size());
-    for (PointId i = 0; i < inView->size(); ++i)
-        min_dists[indices[i]] = sqr_dists[i];
+    tree.addSample(tree.position(seedId));
 
     // Proceed until we have m_count points in the output PointView.
     for (PointId i = 1; i < m_count; ++i)
     {
-        // Find the max distance in min_dists, this is the farthest point from
-        // any point currently in the output PointView.
-        auto it = std::max_element(min_dists.begin(), min_dists.end());
+        // The farthest point from any point currently in the output
+        // PointView.
+        size_t pos = tree.farthest();
 
         // Record the PointId of the farthest point and add it to the output
         // PointView.
-        PointId idx(it - min_dists.begin());
+        PointId idx = tree.id(pos);
         outView->appendPoint(*inView, idx);
 
         log()->get(LogLevel::Debug)
             << "Adding PointId " << idx << " with distance "
-            << std::sqrt(min_dists[idx]) << std::endl;
-
-        // Compute distances from idx to all other points.
-        kdi.knnSearch(idx, inView->size(), &indices, &sqr_dists);
+            << std::sqrt(tree.distance(pos)) << std::endl;
 
         // Update distances.
-        for (PointId j = 0; j < inView->size(); ++j)
-        {
-            if (sqr_dists[j] < min_dists[indices[j]])
-                min_dists[indices[j]] = sqr_dists[j];
-        }
+        tree.addSample(pos);
     }
 
     viewSet.insert(outView);
@@ -63,6 +63,8 @@ public:
     {}
 
     std::string getName() const;
+    virtual bool reentrant() const
+        { return true; }
 
 private:
     virtual void addArgs(ProgramArgs& args);
@@ -63,6 +63,9 @@ private:
     }
 
 
+    bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
+
     PointViewSet run(PointViewPtr view)
     {
         if (m_count > view->size())
@@ -35,7 +35,12 @@
 #include "LOFFilter.hpp"
 
 #include <pdal/KDIndex.hpp>
+#include <pdal/private/Executor.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -79,16 +84,38 @@ void LOFFilter::filter(PointView& view)
     // the neighbors along with the query point.
     m_minpts++;
 
+    // Neighbors are found for a block of points at a time to bound the
+    // size of the results.  Each pass calls 'fn' with the neighbors of
+    // each point in the view.
+    typedef std::function<void(PointId, const PointId *, const double *,
+        size_t)> NeighborFunc;
+    auto eachNeighborhood = [this, &view, &index](const NeighborFunc& fn)
+    {
+        const int threads = (int)Executor::global().threads();
+        const point_count_t blockSize = 65536;
+        PointIdList ids;
+        for (PointId start = 0; start < view.size(); start += blockSize)
+        {
+            point_count_t count = (std::min)(blockSize, view.size() - start);
+            ids.resize(count);
+            std::iota(ids.begin(), ids.end(), start);
+
+            NeighborResults res = index.knnSearch(ids, m_minpts, threads);
+            for (size_t i = 0; i < count; ++i)
+                fn(ids[i], res.neighbors(i), res.distances(i), res.count(i));
+        }
+    };
+
     // First pass: Compute the k-distance for each point.
     // The k-distance is the Euclidean distance to k-th nearest neighbor.
     log()->get(LogLevel::Debug) << "Computing k-distances...\n";
-    for (PointId i = 0; i < view.size(); ++i)
+    eachNeighborhood([this, &view](PointId i, const PointId *,
+        const double *sqr_dists, size_t count)
     {
-        PointIdList indices(m_minpts);
-        std::vector<double> sqr_dists(m_minpts);
-        index.knnSearch(i, m_minpts, &indices, &sqr_dists);
-        view.setField(m_kdist, i, std::sqrt(sqr_dists[m_minpts-1]));
-    }
+        double kdist = (count == (size_t)m_minpts) ?
+            std::sqrt(sqr_dists[m_minpts - 1]) : 0.0;
+        view.setField(m_kdist, i, kdist);
+    });
 
     // Second pass: Compute the local reachability distance for each point.
     // For each neighbor point, the reachability distance is the maximum value
@@ -96,39 +123,34 @@ void LOFFilter::filter(PointView& view)
     // the current point. The lrd is the inverse of the mean of the reachability
     // distances.
     log()->get(LogLevel::Debug) << "Computing lrd...\n";
-    for (PointId i = 0; i < view.size(); ++i)
+    eachNeighborhood([this, &view](PointId i, const PointId *indices,
+        const double *sqr_dists, size_t count)
     {
-        PointIdList indices(m_minpts);
-        std::vector<double> sqr_dists(m_minpts);
-        index.knnSearch(i, m_minpts, &indices, &sqr_dists);
         double M1 = 0.0;
         point_count_t n = 0;
-        for (PointId j = 0; j < indices.size(); ++j)
+        for (size_t j = 0; j < count; ++j)
         {
             double k = view.getFieldAs<double>(m_kdist, indices[j]);
             double reachdist = (std::max)(k, std::sqrt(sqr_dists[j]));
             M1 += (reachdist - M1) / ++n;
         }
         view.setField(m_lrd, i, 1.0 / M1);
-    }
+    });
 
     // Third pass: Compute the local outlier factor for each point.
     // The LOF is the average of the lrd's for a neighborhood of points.
     log()->get(LogLevel::Debug) << "Computing LOF...\n";
-    for (PointId i = 0; i < view.size(); ++i)
+    eachNeighborhood([this, &view](PointId i, const PointId *indices,
+        const double *, size_t count)
     {
         double lrdp = view.getFieldAs<double>(m_lrd, i);
-        PointIdList indices(m_minpts);
-        std::vector<double> sqr_dists(m_minpts);
-        index.knnSearch(i, m_minpts, &indices, &sqr_dists);
         double M1 = 0.0;
         point_count_t n = 0;
-        for (auto const& j : indices)
-        {
-            M1 += (view.getFieldAs<double>(m_lrd, j) / lrdp - M1) / ++n;
-        }
+        for (size_t j = 0; j < count; ++j)
+            M1 += (view.getFieldAs<double>(m_lrd, indices[j]) / lrdp - M1) /
+                ++n;
         view.setField(m_lof, i, M1);
-    }
+    });
 }
 
 } // namespace pdal
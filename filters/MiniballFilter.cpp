@@ -39,14 +39,13 @@
 
 #include "MiniballFilter.hpp"
 
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include "private/Neighborhoods.hpp"
 #include "private/miniball/Seb.h"
 
 #include <cmath>
 #include <string>
-#include <thread>
 #include <vector>
 
 namespace pdal
@@ -71,8 +70,6 @@ std::string MiniballFilter::getName() const
 void MiniballFilter::addArgs(ProgramArgs& args)
 {
     args.add("knn", "k-Nearest neighbors", m_knn, 8);
-    args.add("threads", "Number of threads used to run this filter", m_threads,
-             1);
 }
 
 void MiniballFilter::addDimensions(PointLayoutPtr layout)
@@ -83,49 +80,33 @@ void MiniballFilter::addDimensions(PointLayoutPtr layout)
 
 void MiniballFilter::filter(PointView& view)
 {
-    KD3Index& kdi = view.build3dIndex();
-
-    point_count_t nloops = view.size();
-    std::vector<std::thread> threadList(m_threads);
-    for (int t = 0; t < m_threads; t++)
-    {
-        threadList[t] = std::thread(std::bind(
-            [&](const PointId start, const PointId end) {
-                for (PointId i = start; i < end; i++)
-                    setMiniball(view, i, kdi);
-            },
-            t * nloops / m_threads,
-            (t + 1) == m_threads ? nloops : (t + 1) * nloops / m_threads));
-    }
-    for (auto& t : threadList)
-        t.join();
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn + 1);
+    hoods.run({ m_miniball },
+        [this, &hoods](const Neighborhood& n, double *values)
+        { values[0] = miniball(hoods, n); });
 }
 
-void MiniballFilter::setMiniball(PointView& view, const PointId& i,
-                                 const KD3Index& kdi)
+double MiniballFilter::miniball(const Neighborhoods& hoods,
+                                const Neighborhood& n)
 {
     typedef double FT;
     typedef Seb::Point<FT> Point;
     typedef std::vector<Point> PointVector;
     typedef Seb::Smallest_enclosing_ball<FT> Miniball;
 
-    double X = view.getFieldAs<double>(Dimension::Id::X, i);
-    double Y = view.getFieldAs<double>(Dimension::Id::Y, i);
-    double Z = view.getFieldAs<double>(Dimension::Id::Z, i);
-
-    // Find k-nearest neighbors of i.
-    auto ni = kdi.neighbors(i, m_knn + 1);
+    const PointId i = n.id;
+    const double *p = hoods.coords(i);
+    double X = p[0];
+    double Y = p[1];
+    double Z = p[2];
 
     PointVector S;
-    std::vector<double> coords(3);
-    for (auto const& j : ni)
+    for (auto const& j : n)
     {
         if (j == i)
             continue;
-        coords[0] = view.getFieldAs<double>(Dimension::Id::X, j);
-        coords[1] = view.getFieldAs<double>(Dimension::Id::Y, j);
-        coords[2] = view.getFieldAs<double>(Dimension::Id::Z, j);
-        S.push_back(Point(3, coords.begin()));
+        S.push_back(Point(3, hoods.coords(j)));
     }
 
     // add neighbors to Miniball mb(3, S)
@@ -144,8 +125,7 @@ void MiniballFilter::setMiniball(PointView& view, const PointId& i,
     double d =
         std::sqrt((X - x) * (X - x) + (Y - y) * (Y - y) + (Z - z) * (Z - z));
 
-    double miniball = d / (d + 2 * radius / (std::sqrt(3)));
-    view.setField(m_miniball, i, miniball);
+    return d / (d + 2 * radius / (std::sqrt(3)));
 }
 
 } // namespace pdal
@@ -42,6 +42,9 @@
 namespace pdal
 {
 
+class Neighborhoods;
+struct Neighborhood;
+
 class PDAL_DLL MiniballFilter : public Filter
 {
 public:
@@ -54,14 +57,13 @@ public:
 
 private:
     int m_knn;
-    int m_threads;
     Dimension::Id m_miniball;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void filter(PointView& view);
 
-    void setMiniball(PointView& view, const PointId& i, const KD3Index& kdi);
+    double miniball(const Neighborhoods& hoods, const Neighborhood& n);
 };
 
 } // namespace pdal
@@ -34,10 +34,14 @@
 
 #include "NNDistanceFilter.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <string>
 #include <vector>
 
 #include <pdal/KDIndex.hpp>
+#include <pdal/private/Executor.hpp>
 
 namespace pdal
 {
@@ -115,26 +119,40 @@ void NNDistanceFilter::filter(PointView& view)
     size_t k = m_k + 1;
 
     // Compute the k-distance for each point. The k-distance is the Euclidean
-    // distance to k-th nearest neighbor.
+    // distance to k-th nearest neighbor.  Queries are made for a block of
+    // points at a time to bound the size of the results.
     log()->get(LogLevel::Debug) << "Computing k-distances...\n";
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    const int threads = (int)Executor::global().threads();
+    const point_count_t blockSize = 65536;
+    PointIdList ids;
+    for (PointId start = 0; start < view.size(); start += blockSize)
     {
-        PointIdList indices(k);
-        std::vector<double> sqr_dists(k);
-        index.knnSearch(idx, k, &indices, &sqr_dists);
-        double val;
-        if (m_mode == Mode::Kth)
-            val = std::sqrt(sqr_dists[k - 1]);
-        else // m_mode == Mode::Average
-        {
-            val = 0;
+        point_count_t count = (std::min)(blockSize, view.size() - start);
+        ids.resize(count);
+        std::iota(ids.begin(), ids.end(), start);
 
-            // We start at 1 since index 0 is the test point.
-            for (size_t i = 1; i < k; ++i)
-                val += std::sqrt(sqr_dists[i]);
-            val /= (k - 1);
+        NeighborResults res = index.knnSearch(ids, k, threads);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Fewer than k neighbors are found when the view is small.
+            // Missing neighbors count as zero distance.
+            const double *sqr_dists = res.distances(i);
+            size_t found = res.count(i);
+            double val = 0;
+            if (m_mode == Mode::Kth)
+            {
+                if (found == k)
+                    val = std::sqrt(sqr_dists[k - 1]);
+            }
+            else // m_mode == Mode::Average
+            {
+                // We start at 1 since index 0 is the test point.
+                for (size_t j = 1; j < found; ++j)
+                    val += std::sqrt(sqr_dists[j]);
+                val /= (k - 1);
+            }
+            view.setField(Dimension::Id::NNDistance, ids[i], val);
         }
-        view.setField(Dimension::Id::NNDistance, idx, val);
     }
 }
 
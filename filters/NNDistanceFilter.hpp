@@ -52,6 +52,8 @@ public:
     NNDistanceFilter(const NNDistanceFilter&) = delete;
 
     std::string getName() const;
+    virtual bool reentrant() const
+        { return true; }
 
 private:
     enum class Mode
@@ -41,6 +41,7 @@
 // [2] https://github.com/CloudCompare/CloudCompare.
 
 #include "NormalFilter.hpp"
+#include "private/Neighborhoods.hpp"
 #include "private/Point.hpp"
 
 #include <pdal/EigenUtils.hpp>
@@ -49,6 +50,7 @@
 
 #include <Eigen/Dense>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -72,7 +74,7 @@ struct NormalArgs
     bool m_refine;
 };
 
-NormalFilter::NormalFilter() : m_args(new NormalArgs), m_count(0) {}
+NormalFilter::NormalFilter() : m_args(new NormalArgs) {}
 
 NormalFilter::~NormalFilter() {}
 
@@ -124,66 +126,74 @@ void NormalFilter::prepared(PointTableRef table)
     ++m_args->m_knn;
 }
 
-void NormalFilter::compute(PointView& view, KD3Index& kdi)
+void NormalFilter::compute(PointView& view)
 {
     log()->get(LogLevel::Debug) << "Computing normal vectors\n";
-    for (auto&& p : view)
-    {
-        // Perform eigen decomposition of covariance matrix computed from
-        // neighborhood composed of k-nearest neighbors.
-        PointIdList neighbors = kdi.neighbors(p.pointId(), m_args->m_knn);
-        auto B = computeCovariance(view, neighbors);
-        SelfAdjointEigenSolver<Matrix3d> solver(B);
-        if (solver.info() != Success)
-            throwError("Cannot perform eigen decomposition.");
-
-        // The curvature is computed as the ratio of the first (smallest)
-        // eigenvalue to the sum of all eigenvalues.
-        auto eval = solver.eigenvalues();
-        double sum = eval[0] + eval[1] + eval[2];
-        double curvature = sum ? std::fabs(eval[0] / sum) : 0;
-
-        // The normal is defined by the eigenvector corresponding to the
-        // smallest eigenvalue.
-        Vector3d normal = solver.eigenvectors().col(0);
-
-        if (m_viewpointArg->set())
-        {
-            // If a viewpoint has been specified, orient the normals to face the
-            // viewpoint by taking the dot product of the vector connecting the
-            // point with the viewpoint and the normal. Flip the normal, where
-            // the dot product is negative.
-            double dx = m_args->m_viewpoint.x() - p.getFieldAs<double>(Id::X);
-            double dy = m_args->m_viewpoint.y() - p.getFieldAs<double>(Id::Y);
-            double dz = m_args->m_viewpoint.z() - p.getFieldAs<double>(Id::Z);
-            Vector3d vp(dx, dy, dz);
-            if (vp.dot(normal) < 0)
-                normal *= -1.0;
-        }
-        else if (m_args->m_up)
-        {
-            // If normals are expected to be upward facing, invert them when the
-            // Z component is negative.
-            if (normal[2] < 0)
-                normal *= -1.0;
-        }
 
-        // Set the computed normal and curvature dimensions.
-        p.setField(Id::NormalX, normal[0]);
-        p.setField(Id::NormalY, normal[1]);
-        p.setField(Id::NormalZ, normal[2]);
-        p.setField(Id::Curvature, curvature);
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_args->m_knn);
+    hoods.run({ Id::NormalX, Id::NormalY, Id::NormalZ, Id::Curvature },
+        [this, &hoods](const Neighborhood& n, double *values)
+        { computeNormal(hoods, n, values); });
+}
+
+void NormalFilter::computeNormal(const Neighborhoods& hoods,
+    const Neighborhood& n, double *values)
+{
+    // Perform eigen decomposition of covariance matrix computed from
+    // neighborhood composed of k-nearest neighbors.
+    auto B = hoods.covariance(n);
+    SelfAdjointEigenSolver<Matrix3d> solver(B);
+    if (solver.info() != Success)
+        throwError("Cannot perform eigen decomposition.");
+
+    // The curvature is computed as the ratio of the first (smallest)
+    // eigenvalue to the sum of all eigenvalues.
+    auto eval = solver.eigenvalues();
+    double sum = eval[0] + eval[1] + eval[2];
+    double curvature = sum ? std::fabs(eval[0] / sum) : 0;
+
+    // The normal is defined by the eigenvector corresponding to the
+    // smallest eigenvalue.
+    Vector3d normal = solver.eigenvectors().col(0);
+
+    if (m_viewpointArg->set())
+    {
+        // If a viewpoint has been specified, orient the normals to face the
+        // viewpoint by taking the dot product of the vector connecting the
+        // point with the viewpoint and the normal. Flip the normal, where
+        // the dot product is negative.
+        const double *p = hoods.coords(n.id);
+        double dx = m_args->m_viewpoint.x() - p[0];
+        double dy = m_args->m_viewpoint.y() - p[1];
+        double dz = m_args->m_viewpoint.z() - p[2];
+        Vector3d vp(dx, dy, dz);
+        if (vp.dot(normal) < 0)
+            normal *= -1.0;
+    }
+    else if (m_args->m_up)
+    {
+        // If normals are expected to be upward facing, invert them when the
+        // Z component is negative.
+        if (normal[2] < 0)
+            normal *= -1.0;
     }
+
+    // Set the computed normal and curvature dimensions.
+    values[0] = normal[0];
+    values[1] = normal[1];
+    values[2] = normal[2];
+    values[3] = curvature;
 }
 
 void NormalFilter::update(
     PointView& view, KD3Index& kdi, std::vector<bool> inMST,
     std::priority_queue<Edge, EdgeList, CompareEdgeWeight> edge_queue,
-    PointId updateIdx)
+    PointId updateIdx, point_count_t& count)
 {
     // Add the current PointId to the minimum spanning tree.
     inMST[updateIdx] = true;
-    ++m_count;
+    ++count;
 
     // Consider neighbors of the newly added PointId, adding them to
     // the edge queue if they are not already part of the minimum
@@ -218,18 +228,19 @@ void NormalFilter::refine(PointView& view, KD3Index& kdi)
     std::priority_queue<Edge, EdgeList, CompareEdgeWeight> edge_queue;
     std::vector<bool> inMST(view.size(), false);
     PointId nextIdx(0);
-    while (m_count < view.size())
+    point_count_t count(0);
+    while (count < view.size())
     {
         // Find the PointId of the next point not currently part of the minimum
         // spanning tree.
         while (inMST[nextIdx])
             ++nextIdx;
 
-        update(view, kdi, inMST, edge_queue, nextIdx);
+        update(view, kdi, inMST, edge_queue, nextIdx, count);
 
         // Iterate on the edge queue until empty (or all points have been added
         // to the minimum spanning tree).
-        while (!edge_queue.empty() && (m_count < view.size()))
+        while (!edge_queue.empty() && (count < view.size()))
         {
             // Retrieve the edge with the smallest weight.
             Edge edge(edge_queue.top());
@@ -270,22 +281,20 @@ void NormalFilter::refine(PointView& view, KD3Index& kdi)
                 view.setField(Id::NormalZ, newIdx, normal(2));
             }
 
-            update(view, kdi, inMST, edge_queue, newIdx);
+            update(view, kdi, inMST, edge_queue, newIdx, count);
         }
     }
 }
 
 void NormalFilter::filter(PointView& view)
 {
-    KD3Index& kdi = view.build3dIndex();
-
     // Compute the normal/curvature and optionally orient toward viewpoint or
     // positive Z.
-    compute(view, kdi);
+    compute(view);
 
     // If requested, refine normals through minimum spanning tree propagation.
     if (m_args->m_refine)
-        refine(view, kdi);
+        refine(view, view.build3dIndex());
 }
 
 } // namespace pdal
@@ -46,6 +46,8 @@ namespace pdal
 class Options;
 class PointLayout;
 class PointView;
+class Neighborhoods;
+struct Neighborhood;
 struct NormalArgs;
 
 struct Edge
@@ -82,18 +84,21 @@ public:
     void doFilter(PointView& view, int knn = 8);
 
     std::string getName() const;
+    virtual bool reentrant() const
+        { return true; }
 
 private:
     std::unique_ptr<NormalArgs> m_args;
-    point_count_t m_count;
     Arg* m_viewpointArg;
 
-    void compute(PointView& view, KD3Index& kdi);
+    void compute(PointView& view);
+    void computeNormal(const Neighborhoods& hoods, const Neighborhood& n,
+        double *values);
     void refine(PointView& view, KD3Index& kdi);
     void
     update(PointView& view, KD3Index& kdi, std::vector<bool> inMST,
            std::priority_queue<Edge, EdgeList, CompareEdgeWeight> edge_queue,
-           PointId updateIdx);
+           PointId updateIdx, point_count_t& count);
 
     virtual void addArgs(ProgramArgs& args);
     virtual void addDimensions(PointLayoutPtr layout);
@@ -35,9 +35,13 @@
 #include "OutlierFilter.hpp"
 
 #include <pdal/KDIndex.hpp>
+#include <pdal/private/Executor.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 #include <pdal/util/Utils.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -83,13 +87,23 @@ Indices OutlierFilter::processRadius(PointViewPtr inView)
 
     PointIdList inliers, outliers;
 
-    for (PointId i = 0; i < np; ++i)
+    // Query a block of points at a time to bound the size of the results.
+    const int threads = (int)Executor::global().threads();
+    const point_count_t blockSize = 65536;
+    PointIdList ids;
+    for (PointId start = 0; start < np; start += blockSize)
     {
-        auto ids = index.radius(i, m_radius);
-        if (ids.size() > size_t(m_minK))
-            inliers.push_back(i);
-        else
-            outliers.push_back(i);
+        ids.resize((std::min)(blockSize, np - start));
+        std::iota(ids.begin(), ids.end(), start);
+
+        NeighborResults res = index.radius(ids, m_radius, threads);
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (res.count(i) > size_t(m_minK))
+                inliers.push_back(ids[i]);
+            else
+                outliers.push_back(ids[i]);
+        }
     }
 
     return Indices{inliers, outliers};
@@ -109,20 +123,30 @@ Indices OutlierFilter::processStatistical(PointViewPtr inView)
     // we increase the count by one because the query point itself will
     // be included with a distance of 0
     point_count_t count = m_meanK + 1;
-    PointIdList indices(count);
-    std::vector<double> sqr_dists(count);
-    for (PointId i = 0; i < np; ++i)
-    {
 
-        index.knnSearch(i, count, &indices, &sqr_dists);
+    // Query a block of points at a time to bound the size of the results.
+    const int threads = (int)Executor::global().threads();
+    const point_count_t blockSize = 65536;
+    PointIdList ids;
+    for (PointId start = 0; start < np; start += blockSize)
+    {
+        ids.resize((std::min)(blockSize, np - start));
+        std::iota(ids.begin(), ids.end(), start);
 
-        for (size_t j = 1; j < count; ++j)
+        NeighborResults res = index.knnSearch(ids, count, threads);
+        for (size_t i = 0; i < ids.size(); ++i)
         {
-            double delta = std::sqrt(sqr_dists[j]) - distances[i];
-            distances[i] += (delta / j);
+            // Neighbors beyond the number of points in the view count as
+            // zero distance.
+            const double *sqr_dists = res.distances(i);
+            size_t found = res.count(i);
+            double& dist = distances[ids[i]];
+            for (size_t j = 1; j < count; ++j)
+            {
+                double d = (j < found) ? std::sqrt(sqr_dists[j]) : 0.0;
+                dist += ((d - dist) / j);
+            }
         }
-        indices.clear(); indices.resize(count);
-        sqr_dists.clear(); sqr_dists.resize(count);
     }
 
     size_t n(0);
@@ -39,14 +39,13 @@
 
 #include "PlaneFitFilter.hpp"
 
-#include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
 #include <Eigen/Dense>
 
+#include "private/Neighborhoods.hpp"
+
 #include <string>
-#include <thread>
 #include <vector>
 
 namespace pdal
@@ -71,8 +70,6 @@ std::string PlaneFitFilter::getName() const
 void PlaneFitFilter::addArgs(ProgramArgs& args)
 {
     args.add("knn", "k-Nearest neighbors", m_knn, 8);
-    args.add("threads", "Number of threads used to run this filter", m_threads,
-             1);
 }
 
 void PlaneFitFilter::addDimensions(PointLayoutPtr layout)
@@ -83,53 +80,37 @@ void PlaneFitFilter::addDimensions(PointLayoutPtr layout)
 
 void PlaneFitFilter::filter(PointView& view)
 {
-    KD3Index& kdi = view.build3dIndex();
-
-    point_count_t nloops = view.size();
-    std::vector<std::thread> threadList(m_threads);
-    for (int t = 0; t < m_threads; t++)
-    {
-        threadList[t] = std::thread(std::bind(
-            [&](const PointId start, const PointId end) {
-                for (PointId i = start; i < end; i++)
-                    setPlaneFit(view, i, kdi);
-            },
-            t * nloops / m_threads,
-            (t + 1) == m_threads ? nloops : (t + 1) * nloops / m_threads));
-    }
-    for (auto& t : threadList)
-        t.join();
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn + 1);
+    hoods.run({ m_planefit },
+        [this, &hoods](const Neighborhood& n, double *values)
+        { values[0] = planeFit(hoods, n); });
 }
 
-double PlaneFitFilter::absDistance(PointView& view, const PointId& i,
-                                   Eigen::Vector3d& centroid,
-                                   Eigen::Vector3d& normal)
+double PlaneFitFilter::absDistance(const double *pos,
+                                   const Eigen::Vector3d& centroid,
+                                   const Eigen::Vector3d& normal)
 {
-    double x = view.getFieldAs<double>(Dimension::Id::X, i);
-    double y = view.getFieldAs<double>(Dimension::Id::Y, i);
-    double z = view.getFieldAs<double>(Dimension::Id::Z, i);
     Eigen::Vector3d p;
-    p << x - centroid[0], y - centroid[1], z - centroid[2];
+    p << pos[0] - centroid[0], pos[1] - centroid[1], pos[2] - centroid[2];
     double d = normal.dot(p);
     return std::fabs(d);
 }
 
-void PlaneFitFilter::setPlaneFit(PointView& view, const PointId& i,
-                                 const KD3Index& kdi)
+double PlaneFitFilter::planeFit(const Neighborhoods& hoods,
+                                const Neighborhood& n)
 {
-    // Find k-nearest neighbors of i.
-    PointIdList ni = kdi.neighbors(i, m_knn + 1);
-
     // Normal based only on neighbors, so exclude first point.
-    PointIdList neighbors(ni.begin() + 1, ni.end());
+    const PointId *neighbors = n.ids + 1;
+    const point_count_t count = n.count - 1;
 
     // Covariance and normal are based off demeaned coordinates, so we record
     // the centroid to properly offset the coordinates when computing point to
     // plance distance.
-    auto centroid = computeCentroid(view, neighbors);
+    auto centroid = hoods.centroid(neighbors, count);
 
     // Compute covariance of the neighbors.
-    auto B = computeCovariance(view, neighbors);
+    auto B = hoods.covariance(neighbors, count);
 
     // Perform the eigen decomposition, using the eigenvector of the smallest
     // eigenvalue as the normal.
@@ -139,18 +120,18 @@ void PlaneFitFilter::setPlaneFit(PointView& view, const PointId& i,
     Eigen::Vector3d normal = solver.eigenvectors().col(0);
 
     // Compute point to plane distance of the query point.
-    double d = absDistance(view, i, centroid, normal);
+    double d = absDistance(hoods.coords(n.id), centroid, normal);
 
     // Compute mean point to plane distance of neighbors.
     double d_sum(0.0);
-    for (auto const& j : neighbors)
+    for (point_count_t j = 0; j < count; ++j)
     {
-        d_sum += absDistance(view, j, centroid, normal);
+        d_sum += absDistance(hoods.coords(neighbors[j]), centroid, normal);
     }
     double d_bar(d_sum / m_knn);
 
-    // Compute and set the plane fit criterion.
-    view.setField(m_planefit, i, d / (d + d_bar));
+    // Compute the plane fit criterion.
+    return d / (d + d_bar);
 }
 
 } // namespace pdal
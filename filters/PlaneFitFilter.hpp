@@ -44,6 +44,9 @@
 namespace pdal
 {
 
+class Neighborhoods;
+struct Neighborhood;
+
 class PDAL_DLL PlaneFitFilter : public Filter
 {
 public:
@@ -57,16 +60,15 @@ public:
 
 private:
     int m_knn;
-    int m_threads;
     Dimension::Id m_planefit;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void filter(PointView& view);
 
-    void setPlaneFit(PointView& view, const PointId& i, const KD3Index& kdi);
-    double absDistance(PointView& view, const PointId& i,
-                       Eigen::Vector3d& centroid, Eigen::Vector3d& normal);
+    double planeFit(const Neighborhoods& hoods, const Neighborhood& n);
+    double absDistance(const double *pos, const Eigen::Vector3d& centroid,
+                       const Eigen::Vector3d& normal);
 };
 
 } // namespace pdal
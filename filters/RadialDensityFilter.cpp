@@ -34,7 +34,7 @@
 
 #include "RadialDensityFilter.hpp"
 
-#include <pdal/KDIndex.hpp>
+#include "private/Neighborhoods.hpp"
 
 #include <string>
 #include <vector>
@@ -71,19 +71,16 @@ void RadialDensityFilter::filter(PointView& view)
 {
     using namespace Dimension;
 
-    // Build the 3D KD-tree.
-    KD3Index& index = view.build3dIndex();
+    Neighborhoods hoods(view);
+    hoods.setRadius(m_rad);
 
     // Search for neighboring points within the specified radius. The number of
     // neighbors (which includes the query point) is normalized by the volume
     // of the search sphere and recorded as the density.
     log()->get(LogLevel::Debug) << "Computing densities...\n";
     double factor = 1.0 / ((4.0 / 3.0) * 3.14159 * (m_rad * m_rad * m_rad));
-    for (PointId i = 0; i < view.size(); ++i)
-    {
-        PointIdList pts = index.radius(i, m_rad);
-        view.setField(m_rdens, i, pts.size() * factor);
-    }
+    hoods.run({ m_rdens }, [factor](const Neighborhood& n, double *values)
+        { values[0] = n.count * factor; });
 }
 
 } // namespace pdal
@@ -77,6 +77,14 @@ void RangeFilter::addArgs(ProgramArgs& args)
 }
 
 
+bool RangeFilter::usedDimensions(StringList& dims) const
+{
+    for (const DimRange& r : m_ranges)
+        dims.push_back(r.m_name);
+    return true;
+}
+
+
 void RangeFilter::prepared(PointTableRef table)
 {
     const PointLayoutPtr layout(table.layout());
@@ -53,11 +53,14 @@ public:
     ~RangeFilter();
 
     std::string getName() const;
+    virtual bool reentrant() const
+        { return true; }
 
 private:
     std::vector<DimRange> m_ranges;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void prepared(PointTableRef table);
     virtual bool processOne(PointRef& point);
     virtual PointViewSet run(PointViewPtr view);
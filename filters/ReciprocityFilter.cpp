@@ -42,8 +42,9 @@
 #include <pdal/KDIndex.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include "private/Neighborhoods.hpp"
+
 #include <string>
-#include <thread>
 #include <vector>
 
 namespace pdal
@@ -67,8 +68,6 @@ std::string ReciprocityFilter::getName() const
 void ReciprocityFilter::addArgs(ProgramArgs& args)
 {
     args.add("knn", "k-Nearest neighbors", m_knn, 8);
-    args.add("threads", "Number of threads used to run this filter", m_threads,
-             1);
 }
 
 void ReciprocityFilter::addDimensions(PointLayoutPtr layout)
@@ -79,36 +78,24 @@ void ReciprocityFilter::addDimensions(PointLayoutPtr layout)
 
 void ReciprocityFilter::filter(PointView& view)
 {
-    KD3Index& kdi = view.build3dIndex();
-
-    point_count_t nloops = view.size();
-    std::vector<std::thread> threadList(m_threads);
-    for (int t = 0; t < m_threads; t++)
-    {
-        threadList[t] = std::thread(std::bind(
-            [&](const PointId start, const PointId end) {
-                for (PointId i = start; i < end; i++)
-                    setReciprocity(view, i, kdi);
-            },
-            t * nloops / m_threads,
-            (t + 1) == m_threads ? nloops : (t + 1) * nloops / m_threads));
-    }
-    for (auto& t : threadList)
-        t.join();
+    Neighborhoods hoods(view);
+    hoods.setKnn(m_knn + 1);
+    hoods.run({ m_reciprocity },
+        [this, &hoods](const Neighborhood& n, double *values)
+        { values[0] = reciprocity(hoods.index(), n); });
 }
 
-void ReciprocityFilter::setReciprocity(PointView& view, const PointId& i,
-                                       const KD3Index& kdi)
+double ReciprocityFilter::reciprocity(const KD3Index& kdi,
+                                      const Neighborhood& n)
 {
-    // Find k-nearest neighbors of i.
-    auto ni = kdi.neighbors(i, m_knn + 1);
+    const PointId i = n.id;
 
     // Initialize number of unidirectional neighbors to 0.
     point_count_t uni(0);
 
     // Visit each neighbor of i, finding its k-nearest neighbors. If i is
     // not a nearest neighbor of one of its neighbors, increment uni.
-    for (auto const& j : ni)
+    for (auto const& j : n)
     {
         // The query point itself will always show up as a neighbor and can
         // be skipped.
@@ -125,8 +112,7 @@ void ReciprocityFilter::setReciprocity(PointView& view, const PointId& i,
 
     // Compute reciprocity as percentage of neighbors that do NOT contain
     // id as a neighbor.
-    double reciprocity = 100.0 * uni / m_knn;
-    view.setField(m_reciprocity, i, reciprocity);
+    return 100.0 * uni / m_knn;
 }
 
 } // namespace pdal
@@ -46,6 +46,7 @@ namespace pdal
 class Options;
 class PointLayout;
 class PointView;
+struct Neighborhood;
 
 class PDAL_DLL ReciprocityFilter : public Filter
 {
@@ -59,15 +60,13 @@ public:
 
 private:
     int m_knn;
-    int m_threads;
     Dimension::Id m_reciprocity;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
     virtual void filter(PointView& view);
 
-    void setReciprocity(PointView& view, const PointId& i,
-                        const KD3Index& kdi);
+    double reciprocity(const KD3Index& kdi, const Neighborhood& n);
 };
 
 } // namespace pdal
@@ -56,6 +56,12 @@ void SortFilter::addArgs(ProgramArgs& args)
         SortOrder::ASC);
 }
 
+bool SortFilter::usedDimensions(StringList& dims) const
+{
+    dims.push_back(m_dimName);
+    return true;
+}
+
 void SortFilter::prepared(PointTableRef table)
 {
     m_dim = table.layout()->findDim(m_dimName);
@@ -57,6 +57,8 @@ public:
     {}
 
     std::string getName() const;
+    virtual bool reentrant() const
+        { return true; }
 
 private:
     // Dimension on which to sort.
@@ -68,6 +70,7 @@ private:
     SortOrder m_order;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void prepared(PointTableRef table);
     virtual void filter(PointView& view);
 
@@ -34,8 +34,10 @@
 
 #include "StatsFilter.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <unordered_map>
+#include <vector>
 
 #include <pdal/Options.hpp>
 #include <pdal/Polygon.hpp>
@@ -147,11 +149,21 @@ bool StatsFilter::processOne(PointRef& point)
 
 void StatsFilter::filter(PointView& view)
 {
-    PointRef point(view, 0);
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    // Fetch values a block at a time for each dimension rather than
+    // converting them point by point.
+    const point_count_t blockSize = 4096;
+    std::vector<double> values(blockSize);
+
+    for (PointId start = 0; start < view.size(); start += blockSize)
     {
-        point.setPointId(idx);
-        processOne(point);
+        point_count_t count = (std::min)(blockSize, view.size() - start);
+        for (auto p = m_stats.begin(); p != m_stats.end(); ++p)
+        {
+            Summary& c = p->second;
+            view.getFieldArray(p->first, start, count, values.data());
+            for (point_count_t i = 0; i < count; ++i)
+                c.insert(values[i]);
+        }
     }
 }
 
@@ -175,6 +187,17 @@ void StatsFilter::addArgs(ProgramArgs& args)
 }
 
 
+// Without an explicit list of dimensions, statistics are computed for all
+// dimensions.  The other dimension options must name listed dimensions.
+bool StatsFilter::usedDimensions(StringList& dims) const
+{
+    if (m_dimNames.empty())
+        return false;
+    dims.insert(dims.end(), m_dimNames.begin(), m_dimNames.end());
+    return true;
+}
+
+
 void StatsFilter::prepared(PointTableRef table)
 {
     PointLayoutPtr layout(table.layout());
@@ -62,6 +62,9 @@ private:
             "at the end to drop.", m_invert);
     }
 
+    bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
+
     PointViewSet run(PointViewPtr view)
     {
         if (m_count > view->size())
@@ -55,6 +55,8 @@ public:
     TransformationFilter(const TransformationFilter&) = delete;
 
     std::string getName() const override;
+    bool reentrant() const override
+        { return true; }
     void doFilter(PointView& view, const Transform& matrix);
 
 private:
@@ -0,0 +1,178 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "Neighborhoods.hpp"
+
+#include <numeric>
+#include <vector>
+
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/private/Executor.hpp>
+
+namespace pdal
+{
+
+Neighborhoods::Neighborhoods(PointView& view) : m_view(view),
+    m_index(view.build3dIndex()), m_knn(8), m_stride(1), m_useRadius(false),
+    m_radius(0)
+{}
+
+
+void Neighborhoods::setKnn(point_count_t k, size_t stride)
+{
+    m_knn = k;
+    m_stride = (std::max)(stride, (size_t)1);
+    m_useRadius = false;
+}
+
+
+void Neighborhoods::setRadius(double radius)
+{
+    m_radius = radius;
+    m_stride = 1;
+    m_useRadius = true;
+}
+
+
+const double *Neighborhoods::coords(PointId id) const
+{
+    return m_index.coords(id);
+}
+
+
+// Blocks are large enough to give each thread plenty of work but bound the
+// memory used by the neighbors of a block.  Neighbors are found for the
+// whole block first, then the points of the block are split into ranges
+// that threads take as they become idle, which balances out neighborhoods
+// of uneven cost.
+void Neighborhoods::run(const Dimension::IdList& dims, const Func& f)
+{
+    Executor& executor = Executor::global();
+    const int threads = (int)executor.threads();
+    const point_count_t numPoints = m_view.size();
+    const point_count_t blockSize =
+        (std::max)((point_count_t)65536, (point_count_t)threads * 16384);
+    const size_t numDims = dims.size();
+
+    PointIdList ids;
+    std::vector<double> values;
+    std::vector<double> column;
+    for (PointId start = 0; start < numPoints; start += blockSize)
+    {
+        const point_count_t count = (std::min)(blockSize, numPoints - start);
+        ids.resize(count);
+        std::iota(ids.begin(), ids.end(), start);
+
+        NeighborResults res = m_useRadius ?
+            m_index.radius(ids, m_radius, threads) :
+            m_index.knnSearch(ids, m_knn * m_stride, threads);
+
+        values.resize(count * numDims);
+        parallelFor(0, count, 256, [&](size_t first, size_t last)
+        {
+            PointIdList strided;
+            std::vector<double> stridedDists;
+            for (size_t i = first; i < last; ++i)
+            {
+                Neighborhood n { start + i, res.neighbors(i),
+                    res.distances(i), res.count(i) };
+                if (m_stride > 1)
+                {
+                    strided.clear();
+                    stridedDists.clear();
+                    for (point_count_t j = 0;
+                        j < n.count && strided.size() < m_knn; j += m_stride)
+                    {
+                        strided.push_back(n.ids[j]);
+                        stridedDists.push_back(n.sqrDists[j]);
+                    }
+                    n.ids = strided.data();
+                    n.sqrDists = stridedDists.data();
+                    n.count = strided.size();
+                }
+                f(n, values.data() + i * numDims);
+            }
+        }, executor);
+
+        column.resize(count);
+        for (size_t d = 0; d < numDims; ++d)
+        {
+            for (point_count_t i = 0; i < count; ++i)
+                column[i] = values[i * numDims + d];
+            m_view.setFieldArray(dims[d], start, count, column.data());
+        }
+    }
+}
+
+
+Eigen::Vector3d Neighborhoods::centroid(const PointId *ids,
+    point_count_t count) const
+{
+    // Running mean, as computeCentroid() does.
+    double mean[3] = { 0, 0, 0 };
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        const double *p = coords(ids[i]);
+        for (int k = 0; k < 3; ++k)
+            mean[k] += (p[k] - mean[k]) / (i + 1);
+    }
+    return Eigen::Vector3d(mean[0], mean[1], mean[2]);
+}
+
+
+Eigen::Matrix3d Neighborhoods::covariance(const PointId *ids,
+    point_count_t count) const
+{
+    const Eigen::Vector3d c = centroid(ids, count);
+
+    // Deviations are rounded to float as computeCovariance() does.
+    Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        const double *p = coords(ids[i]);
+        double d[3];
+        for (int k = 0; k < 3; ++k)
+            d[k] = static_cast<float>(p[k] - c[k]);
+        for (int a = 0; a < 3; ++a)
+            for (int b = a; b < 3; ++b)
+                cov(a, b) += d[a] * d[b];
+    }
+    for (int a = 0; a < 3; ++a)
+        for (int b = 0; b < a; ++b)
+            cov(a, b) = cov(b, a);
+    return cov / (double)(count - 1);
+}
+
+} // namespace pdal
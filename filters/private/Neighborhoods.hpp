@@ -0,0 +1,113 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <functional>
+
+#include <Eigen/Dense>
+
+#include <pdal/Dimension.hpp>
+#include <pdal/pdal_export.hpp>
+#include <pdal/pdal_types.hpp>
+
+namespace pdal
+{
+
+class KD3Index;
+class PointView;
+
+// The neighbors of a point, nearest first, and their square distances.  A
+// point is its own nearest neighbor.
+struct Neighborhood
+{
+    PointId id;
+    const PointId *ids;
+    const double *sqrDists;
+    point_count_t count;
+
+    const PointId *begin() const
+        { return ids; }
+    const PointId *end() const
+        { return ids + count; }
+};
+
+// Runs a function over the neighborhood of each point of a view.
+// Neighborhoods are found for blocks of points at a time and held in a
+// single array for the block.  The function is run for the points of a
+// block in parallel on the shared executor and the values it computes are
+// written to the view on the calling thread, so the function only needs to
+// be safe to call from several threads at once.
+class PDAL_DLL Neighborhoods
+{
+public:
+    // Compute the values of the output dimensions for a neighborhood.
+    typedef std::function<void(const Neighborhood& n, double *values)> Func;
+
+    Neighborhoods(PointView& view);
+
+    // Use the k nearest neighbors of each point.  With a stride, only
+    // every stride'th of the k * stride nearest neighbors is used.
+    void setKnn(point_count_t k, size_t stride = 1);
+
+    // Use the neighbors within a radius of each point.
+    void setRadius(double radius);
+
+    // Call f for the neighborhood of each point of the view.  f sets one
+    // value for each of 'dims', which are then set for the point.
+    void run(const Dimension::IdList& dims, const Func& f);
+
+    const KD3Index& index() const
+        { return m_index; }
+
+    // Position of a point as stored in the index.
+    const double *coords(PointId id) const;
+
+    // Centroid and covariance of the positions of a list of points,
+    // computed as computeCentroid() and computeCovariance() do.
+    Eigen::Vector3d centroid(const PointId *ids, point_count_t count) const;
+    Eigen::Matrix3d covariance(const PointId *ids, point_count_t count) const;
+    Eigen::Matrix3d covariance(const Neighborhood& n) const
+        { return covariance(n.ids, n.count); }
+
+private:
+    PointView& m_view;
+    KD3Index& m_index;
+    point_count_t m_knn;
+    size_t m_stride;
+    bool m_useRadius;
+    double m_radius;
+};
+
+} // namespace pdal
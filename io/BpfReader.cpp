@@ -35,9 +35,12 @@
 #include "BpfReader.hpp"
 
 #include <climits>
+#include <cstring>
 
 #include <pdal/Options.hpp>
 #include <pdal/pdal_features.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/portable_endian.hpp>
 
 #ifdef PDAL_HAVE_ZLIB
 #include <zlib.h>
@@ -60,6 +63,12 @@ CREATE_STATIC_STAGE(BpfReader, s_info)
 
 std::string BpfReader::getName() const { return s_info.name; }
 
+void BpfReader::addArgs(ProgramArgs& args)
+{
+    args.add("use_mmap", "Memory-map uncompressed point data", m_useMmap);
+}
+
+
 QuickInfo BpfReader::inspect()
 {
     QuickInfo qi;
@@ -198,11 +207,16 @@ void BpfReader::initialize()
 
 void BpfReader::addDimensions(PointLayoutPtr layout)
 {
+    // Dimensions that aren't registered keep an ID of Unknown and are
+    // skipped when reading.
     for (size_t i = 0; i < m_dims.size(); ++i)
     {
         BpfDimension& dim = m_dims[i];
-        dim.m_id = layout->registerOrAssignDim(dim.m_label,
-            Dimension::Type::Float);
+        if (dimUsed(dim.m_label))
+            dim.m_id = layout->registerOrAssignDim(dim.m_label,
+                Dimension::Type::Float);
+        else
+            dim.m_id = Dimension::Id::Unknown;
     }
 }
 
@@ -273,6 +287,9 @@ void BpfReader::ready(PointTableRef)
     m_stream.seek(m_header.m_len);
     m_index = 0;
     m_start = m_stream.position();
+    m_mapData = nullptr;
+    if (m_useMmap && !m_header.m_compression)
+        initMap();
 #ifdef PDAL_HAVE_ZLIB
     if (m_header.m_compression)
     {
@@ -293,6 +310,8 @@ void BpfReader::ready(PointTableRef)
 
 void BpfReader::done(PointTableRef)
 {
+    FileUtils::unmapFile(m_map);
+    m_mapData = nullptr;
     if (auto s = m_stream.popStream())
         delete s;
     m_stream.close();
@@ -305,6 +324,12 @@ bool BpfReader::processOne(PointRef& point)
     if (eof() || m_index >= m_count)
         return false;
 
+    if (m_mapData)
+    {
+        readMapped(point);
+        return true;
+    }
+
     switch (m_header.m_pointFormat)
     {
     case BpfFormat::PointMajor:
@@ -323,6 +348,9 @@ bool BpfReader::processOne(PointRef& point)
 
 point_count_t BpfReader::read(PointViewPtr data, point_count_t count)
 {
+    if (m_mapData)
+        return readMapped(data, count);
+
     switch (m_header.m_pointFormat)
     {
     case BpfFormat::PointMajor:
@@ -481,6 +509,8 @@ point_count_t BpfReader::readDimMajor(PointViewPtr data, point_count_t count)
     point_count_t numRead = 0;
     for (size_t d = 0; d < m_dims.size(); ++d)
     {
+        if (m_dims[d].m_id == Dimension::Id::Unknown)
+            continue;
         idx = m_index;
         PointId nextId = startId;
         numRead = 0;
@@ -527,6 +557,8 @@ void BpfReader::readByteMajor(PointRef& point)
 
     for (size_t dim = 0; dim < m_dims.size(); ++dim)
     {
+        if (m_dims[dim].m_id == Dimension::Id::Unknown)
+            continue;
         u.u32 = 0;
         for (size_t b = 0; b < sizeof(float); ++b)
         {
@@ -571,6 +603,8 @@ point_count_t BpfReader::readByteMajor(PointViewPtr data, point_count_t count)
 
     for (size_t d = 0; d < m_dims.size(); ++d)
     {
+        if (m_dims[d].m_id == Dimension::Id::Unknown)
+            continue;
         for (size_t b = 0; b < sizeof(float); ++b)
         {
             idx = m_index;
@@ -617,6 +651,112 @@ point_count_t BpfReader::readByteMajor(PointViewPtr data, point_count_t count)
 }
 
 
+// Map the file so that points can be decoded in place rather than read
+// through the stream.  If the file can't be mapped, m_mapData is left null
+// and points are read from the stream.
+void BpfReader::initMap()
+{
+    m_map = FileUtils::mapFile(m_filename);
+    if (!m_map.addr())
+    {
+        log()->get(LogLevel::Debug) << m_map.what() <<
+            " Reading points from stream." << std::endl;
+        return;
+    }
+
+    uintmax_t size = (uintmax_t)numPoints() * m_dims.size() * sizeof(float);
+    if ((uintmax_t)m_start + size > m_map.size())
+    {
+        log()->get(LogLevel::Debug) << "Point data extends beyond end of "
+            "file.  Reading points from stream." << std::endl;
+        FileUtils::unmapFile(m_map);
+        return;
+    }
+    m_mapData = m_map.addr() + m_start;
+}
+
+
+// Get the value of a dimension of a point from mapped data, before the
+// dimension offset is applied.
+float BpfReader::mappedValue(size_t dimIdx, PointId ptIdx) const
+{
+    const size_t numDims = m_dims.size();
+    uint32_t u(0);
+
+    switch (m_header.m_pointFormat)
+    {
+    case BpfFormat::PointMajor:
+        std::memcpy(&u, m_mapData + (ptIdx * numDims + dimIdx) * sizeof(float),
+            sizeof(u));
+        u = le32toh(u);
+        break;
+    case BpfFormat::DimMajor:
+        std::memcpy(&u,
+            m_mapData + (dimIdx * numPoints() + ptIdx) * sizeof(float),
+            sizeof(u));
+        u = le32toh(u);
+        break;
+    case BpfFormat::ByteMajor:
+    {
+        const char *pos = m_mapData + dimIdx * numPoints() * sizeof(float) +
+            ptIdx;
+        for (size_t b = 0; b < sizeof(float); ++b)
+            u |= (uint32_t)(uint8_t)pos[b * numPoints()] << (b * CHAR_BIT);
+        break;
+    }
+    }
+
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+
+void BpfReader::readMapped(PointRef& point)
+{
+    double x(0), y(0), z(0);
+
+    for (size_t dim = 0; dim < m_dims.size(); ++dim)
+    {
+        if (m_dims[dim].m_id == Dimension::Id::Unknown)
+            continue;
+        double d = mappedValue(dim, m_index) + m_dims[dim].m_offset;
+        if (m_dims[dim].m_id == Dimension::Id::X)
+            x = d;
+        else if (m_dims[dim].m_id == Dimension::Id::Y)
+            y = d;
+        else if (m_dims[dim].m_id == Dimension::Id::Z)
+            z = d;
+        else
+            point.setField(m_dims[dim].m_id, d);
+    }
+
+    m_header.m_xform.apply(x, y, z);
+    point.setField(Dimension::Id::X, x);
+    point.setField(Dimension::Id::Y, y);
+    point.setField(Dimension::Id::Z, z);
+    m_index++;
+}
+
+
+point_count_t BpfReader::readMapped(PointViewPtr view, point_count_t count)
+{
+    PointId nextId = view->size();
+    point_count_t numRead = 0;
+    PointRef point(*view, nextId);
+    while (numRead < count && m_index < numPoints())
+    {
+        point.setPointId(nextId);
+        readMapped(point);
+        if (m_cb)
+            m_cb(*view, nextId);
+        numRead++;
+        nextId++;
+    }
+    return numRead;
+}
+
+
 void BpfReader::seekPointMajor(PointId ptIdx)
 {
     std::streamoff offset = ptIdx * sizeof(float) * m_dims.size();
@@ -42,6 +42,7 @@
 #include <pdal/Reader.hpp>
 #include <pdal/Streamable.hpp>
 #include <pdal/util/Charbuf.hpp>
+#include <pdal/util/FileUtils.hpp>
 #include <pdal/util/IStream.hpp>
 #include <pdal/pdal_export.hpp>
 
@@ -84,6 +85,13 @@ private:
     std::vector<std::unique_ptr<ILeStream>> m_streams;
     std::vector<std::unique_ptr<Charbuf>> m_charbufs;
 
+    // Memory-mapped reads of uncompressed data.  m_mapData is null when
+    // points are read from the stream.
+    bool m_useMmap;
+    FileUtils::MapContext m_map;
+    const char *m_mapData;
+
+    virtual void addArgs(ProgramArgs& args);
     virtual QuickInfo inspect();
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr Layout);
@@ -102,6 +110,10 @@ private:
     point_count_t readDimMajor(PointViewPtr data, point_count_t count);
     void readByteMajor(PointRef& point);
     point_count_t readByteMajor(PointViewPtr data, point_count_t count);
+    void initMap();
+    float mappedValue(size_t dimIdx, PointId ptIdx) const;
+    void readMapped(PointRef& point);
+    point_count_t readMapped(PointViewPtr data, point_count_t count);
     size_t readBlock(std::vector<char>& outBuf, size_t index);
     bool eof();
     int inflate(char *inbuf, uint32_t insize, char *outbuf, uint32_t outsize);
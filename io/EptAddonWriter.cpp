@@ -39,6 +39,8 @@
 #include <arbiter/arbiter.hpp>
 #include <nlohmann/json.hpp>
 
+#include <pdal/private/ThreadPool.hpp>
+
 #include "private/EptSupport.hpp"
 
 namespace pdal
@@ -96,7 +98,7 @@ void EptAddonWriter::prepared(PointTableRef table)
         log()->get(LogLevel::Warning) << "Using a large thread count: " <<
             threads << " threads" << std::endl;
     }
-    m_pool.reset(new Pool(threads));
+    m_pool.reset(new ThreadPool(threads, 1, log()));
 
     const PointLayout& layout(*table.layout());
     for (auto it : m_args->m_addons.items())
@@ -36,6 +36,7 @@
 
 #include <limits>
 
+#include "private/EptCache.hpp"
 #include "private/EptSupport.hpp"
 
 #include "LasReader.hpp"
@@ -46,6 +47,7 @@
 #include <pdal/GDALUtils.hpp>
 #include <pdal/SrsBounds.hpp>
 #include <pdal/compression/ZstdCompression.hpp>
+#include <pdal/private/ThreadPool.hpp>
 #include <pdal/util/Algorithm.hpp>
 #include "../filters/CropFilter.hpp"
 
@@ -143,6 +145,12 @@ public:
     NL::json m_query;
     NL::json m_headers;
     NL::json m_ogr;
+
+    std::string m_cacheDir;
+    uint64_t m_cacheSize = 1024;
+
+    uint64_t m_lookahead = 256;
+    bool m_ordered = false;
 };
 
 EptReader::EptReader() : m_args(new EptReader::Args)
@@ -170,29 +178,76 @@ void EptReader::addArgs(ProgramArgs& args)
         m_args->m_query);
     args.add("ogr", "OGR filter geometries",
         m_args->m_ogr);
+    args.add("cache_dir", "Directory in which to cache fetched EPT files",
+        m_args->m_cacheDir);
+    args.add("cache_size", "Maximum size of the cache directory in MB",
+        m_args->m_cacheSize, (uint64_t)1024);
+    args.add("lookahead", "Maximum size in MB of nodes read ahead when "
+        "streaming", m_args->m_lookahead, (uint64_t)256);
+    args.add("ordered", "Stream nodes in hierarchy order", m_args->m_ordered);
 }
 
 
 std::string EptReader::get(const std::string path) const
 {
-    if (m_ep->isLocal())
-        return m_ep->get(path);
-    else
-        return m_ep->get(path, m_headers, m_query);
+    return get(*m_ep, path);
+}
+
+
+std::string EptReader::get(const arbiter::Endpoint& ep,
+    const std::string path) const
+{
+    auto fetch = [this, &ep, &path]()
+    {
+        if (&ep != m_ep.get() || ep.isLocal())
+            return ep.get(path);
+        else
+            return ep.get(path, m_headers, m_query);
+    };
+
+    if (m_cache)
+        return m_cache->get(ep.prefixedRoot() + path, fetch);
+    return fetch();
 }
 
 
 std::vector<char> EptReader::getBinary(const std::string path) const
 {
-    if (m_ep->isLocal())
-        return m_ep->getBinary(path);
-    else
-        return m_ep->getBinary(path, m_headers, m_query);
+    return getBinary(*m_ep, path);
+}
+
+
+std::vector<char> EptReader::getBinary(const arbiter::Endpoint& ep,
+    const std::string path) const
+{
+    auto fetch = [this, &ep, &path]()
+    {
+        if (&ep != m_ep.get() || ep.isLocal())
+            return ep.getBinary(path);
+        else
+            return ep.getBinary(path, m_headers, m_query);
+    };
+
+    if (m_cache)
+        return m_cache->getBinary(ep.prefixedRoot() + path, fetch);
+    return fetch();
 }
 
 
 arbiter::LocalHandle EptReader::getLocalHandle(const std::string path) const
 {
+    // A cached file is already local and stays in the cache.
+    if (m_cache)
+        return arbiter::LocalHandle(m_cache->localPath(
+            m_ep->prefixedRoot() + path,
+            [this, &path]()
+            {
+                if (m_ep->isLocal())
+                    return m_ep->getBinary(path);
+                else
+                    return m_ep->getBinary(path, m_headers, m_query);
+            }), false);
+
     if (m_ep->isLocal())
         return m_ep->getLocalHandle(path);
     else
@@ -225,13 +280,28 @@ void EptReader::initialize()
     m_arbiter.reset(new arbiter::Arbiter());
     m_ep.reset(new arbiter::Endpoint(m_arbiter->getEndpoint(m_root)));
 
+    m_cache.reset();
+    if (m_args->m_cacheDir.size())
+    {
+        try
+        {
+            m_cache.reset(new EptCache(m_args->m_cacheDir,
+                m_args->m_cacheSize * 1024 * 1024));
+        }
+        catch (std::exception& e)
+        {
+            throwError(e.what());
+        }
+        debug << "Cache: " << m_args->m_cacheDir << std::endl;
+    }
+
     const std::size_t threads((std::max)(m_args->m_threads, size_t(4)));
     if (threads > 100)
     {
         log()->get(LogLevel::Warning) << "Using a large thread count: " <<
             threads << " threads" << std::endl;
     }
-    m_pool.reset(new Pool(threads));
+    m_pool.reset(new ThreadPool(threads, 1, log()));
 
     debug << "Endpoint: " << m_ep->prefixedRoot() << std::endl;
     try
@@ -478,18 +548,32 @@ void EptReader::addDimensions(PointLayoutPtr layout)
         const Dimension::Type remoteType = getRemoteType(el);
         const Dimension::Type coercedType = getCoercedType(el);
 
+        m_remoteLayout->registerOrAssignFixedDim(name, remoteType);
+        if (!dimUsed(name))
+            continue;
+
         log()->get(LogLevel::Debug) << "Registering dim " << name << ": " <<
             Dimension::interpretationName(coercedType) << std::endl;
 
         layout->registerOrAssignDim(name, coercedType);
-        m_remoteLayout->registerOrAssignFixedDim(name, remoteType);
     }
 
     m_remoteLayout->finalize();
 
     using D = Dimension::Id;
 
-    m_dimTypes = m_remoteLayout->dimTypes();
+    // Only dimensions registered in the public layout are extracted from
+    // the remote data.
+    m_dimTypes.clear();
+    m_dimIds.clear();
+    for (const DimType& dt : m_remoteLayout->dimTypes())
+    {
+        const std::string name(m_remoteLayout->dimName(dt.m_id));
+        if (!dimUsed(name))
+            continue;
+        m_dimTypes.push_back(dt);
+        m_dimIds.push_back(layout->findDim(name));
+    }
     for (DimType& dt : m_dimTypes)
     {
         const NL::json dim(m_info->dim(m_remoteLayout->dimName(dt.m_id)));
@@ -515,6 +599,8 @@ void EptReader::addDimensions(PointLayoutPtr layout)
         for (auto it : m_args->m_addons.items())
         {
             std::string dimName = it.key();
+            if (!dimUsed(dimName))
+                continue;
             const NL::json& val = it.value();
             std::string root(val.get<std::string>());
             if (Utils::endsWith(root, addonFilename))
@@ -613,7 +699,7 @@ void EptReader::overlaps()
         NL::json j;
         try
         {
-            j = NL::json::parse(get(file));
+            j = NL::json::parse(get(ep, file));
         }
         catch (NL::json::parse_error&)
         {
@@ -683,7 +769,7 @@ void EptReader::overlaps(const arbiter::Endpoint& ep,
         // hierarchy subtree corresponding to this root.
         m_pool->add([this, &ep, &target, key]()
         {
-            const auto subRoot(parse(ep.get(
+            const auto subRoot(parse(get(ep,
                             "ept-hierarchy/" + key.toString() + ".json")));
             overlaps(ep, target, subRoot, key);
         });
@@ -823,7 +909,7 @@ PointId EptReader::readBinary(PointView& dst, const Key& key,
 uint64_t EptReader::readZstandard(PointView& dst, const Key& key,
         const uint64_t nodeId) const
 {
-    auto compressed(m_ep->getBinary("ept-data/" + key.toString() + ".zst"));
+    auto compressed(getBinary("ept-data/" + key.toString() + ".zst"));
     std::vector<char> data;
     pdal::ZstdDecompressor dec([&data](char* pos, std::size_t size)
     {
@@ -869,14 +955,15 @@ void EptReader::process(PointView& dst, PointRef& pr, const uint64_t nodeId,
         dst.setField(Dimension::Id::Y, dstId, y);
         dst.setField(Dimension::Id::Z, dstId, z);
 
-        for (const DimType& dt : m_dimTypes)
+        for (size_t i = 0; i < m_dimTypes.size(); ++i)
         {
+            const DimType& dt = m_dimTypes[i];
             if (dt.m_id != D::X && dt.m_id != D::Y && dt.m_id != D::Z)
             {
                 const double d = pr.getFieldAs<double>(dt.m_id) *
                     dt.m_xform.m_scale.m_val + dt.m_xform.m_offset.m_val;
 
-                dst.setField(dt.m_id, dstId, d);
+                dst.setField(m_dimIds[i], dstId, d);
             }
         }
 
@@ -917,7 +1004,7 @@ void EptReader::readAddon(PointView& dst, const Key& key, const Addon& addon,
     if (np != m_overlaps.at(key))
         throwError("Invalid addon hierarchy");
 
-    const auto data(addon.ep().getBinary(
+    const auto data(getBinary(addon.ep(),
                 "ept-data/" + key.toString() + ".bin"));
     const size_t dimSize(Dimension::size(addon.type()));
 
@@ -948,19 +1035,39 @@ Dimension::Type EptReader::getCoercedTypeTest(const NL::json& j)
 
 struct EptReader::NodeBuffer
 {
-    NodeBuffer(PointLayout& layout) : table(layout), view(table) { }
+    NodeBuffer(PointLayout& layout) : table(layout), view(new PointView(table))
+    { }
+
+    // Prepare a used buffer for another node, keeping its memory.
+    void reset()
+    {
+        table.clear();
+        view.reset(new PointView(table));
+    }
+
     VectorPointTable table;
-    PointView view;
+    std::unique_ptr<PointView> view;
+    uint64_t bytes = 0;     // Size counted against the lookahead budget.
 };
 
 void EptReader::load()
 {
     // Asynchronously trigger the fetching and point-view execution of
-    // a lookahead buffer of nodes.
-    while (
-        m_upcomingNodeBuffers.size() < m_pool->size() &&
-        m_overlapIt != m_overlaps.end())
+    // a lookahead buffer of nodes.  Nodes are dispatched while a thread is
+    // free for them and the nodes that haven't been consumed fit in the
+    // memory budget.  One node is always allowed so that a node larger than
+    // the budget can still be read.
+    const uint64_t budget(m_args->m_lookahead * 1024 * 1024);
+    const uint64_t pointSize(m_userLayout->pointSize());
+    while (m_overlapIt != m_overlaps.end())
     {
+        const uint64_t bytes(m_overlapIt->second * pointSize);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_loadingNodes >= m_pool->size())
+            break;
+        if (m_lookaheadBytes && m_lookaheadBytes + bytes > budget)
+            break;
+
         const auto nodeId(m_nodeId++);
         const auto key(m_overlapIt->first);
         ++m_overlapIt;
@@ -969,33 +1076,51 @@ void EptReader::load()
             std::endl;
 
         // Insert an empty placeholder node to keep track of the outstanding
-        // nodes that are currently being fetched/executed.
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_upcomingNodeBuffers.emplace_front();
-        auto& loadingBuffer = m_upcomingNodeBuffers.front();
+        // nodes that are currently being fetched/executed.  Nodes are added
+        // at the back so that the list is in hierarchy order.
+        m_upcomingNodeBuffers.emplace_back();
+        auto& loadingBuffer = m_upcomingNodeBuffers.back();
+        ++m_loadingNodes;
+        m_lookaheadBytes += bytes;
+
+        // Reuse the memory of a node that has been consumed if we can.
+        std::unique_ptr<NodeBuffer> nodeBuffer;
+        if (m_freeNodeBuffers.size())
+        {
+            nodeBuffer = std::move(m_freeNodeBuffers.back());
+            m_freeNodeBuffers.pop_back();
+        }
         lock.unlock();
 
-        m_pool->add([this, &loadingBuffer, nodeId, key]()
+        if (!nodeBuffer)
+            nodeBuffer.reset(new NodeBuffer(*m_userLayout));
+        nodeBuffer->bytes = bytes;
+
+        // The task must be copyable, so it takes the raw buffer.
+        NodeBuffer* buf = nodeBuffer.release();
+        m_pool->add([this, &loadingBuffer, buf, nodeId, key]()
         {
-            std::unique_ptr<NodeBuffer> nodeBuffer(
-                new NodeBuffer(*m_userLayout));
+            std::unique_ptr<NodeBuffer> nodeBuffer(buf);
+            nodeBuffer->table.reserve(nodeBuffer->bytes);
+            PointView& view(*nodeBuffer->view);
 
             if (m_info->dataType() == EptInfo::DataType::Laszip)
-                readLaszip(nodeBuffer->view, key, nodeId);
+                readLaszip(view, key, nodeId);
 #ifdef PDAL_HAVE_ZSTD
             else if (m_info->dataType() == EptInfo::DataType::Zstandard)
-                readZstandard(nodeBuffer->view, key, nodeId);
+                readZstandard(view, key, nodeId);
 #endif
             else if (m_info->dataType() == EptInfo::DataType::Binary)
-                readBinary(nodeBuffer->view, key, nodeId);
+                readBinary(view, key, nodeId);
             else
                 throw ept_error("Unrecognized EPT dataType");
 
             for (const auto& addon : m_addons)
-                readAddon(nodeBuffer->view, key, *addon);
+                readAddon(view, key, *addon);
 
             std::unique_lock<std::mutex> lock(m_mutex);
             loadingBuffer = std::move(nodeBuffer);
+            --m_loadingNodes;
             lock.unlock();
 
             // A node has been populated - notify our consumer thread.
@@ -1006,6 +1131,16 @@ void EptReader::load()
 
 EptReader::NodeBufferIt EptReader::findBuffer()
 {
+    // In order, only the next node in the hierarchy will do.  Otherwise take
+    // whichever node is ready so that a slow fetch doesn't hold up the rest.
+    if (m_args->m_ordered)
+    {
+        auto it = m_upcomingNodeBuffers.begin();
+        if (it != m_upcomingNodeBuffers.end() && !*it)
+            it = m_upcomingNodeBuffers.end();
+        return it;
+    }
+
     return std::find_if(
         m_upcomingNodeBuffers.begin(),
         m_upcomingNodeBuffers.end(),
@@ -1040,6 +1175,19 @@ bool EptReader::next()
     return true;
 }
 
+void EptReader::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lookaheadBytes -= m_currentNodeBuffer->bytes;
+    if (m_freeNodeBuffers.size() < m_pool->size())
+    {
+        m_currentNodeBuffer->reset();
+        m_freeNodeBuffers.push_back(std::move(m_currentNodeBuffer));
+    }
+    else
+        m_currentNodeBuffer.reset();
+}
+
 bool EptReader::processOne(PointRef& point)
 {
     while (!m_currentNodeBuffer)
@@ -1050,10 +1198,10 @@ bool EptReader::processOne(PointRef& point)
         // octree bounds of a node overlaps the query, but this node contains
         // no matching points for the query.  So we may have a zero point
         // buffer which we have to handle.
-        if (m_currentNodeBuffer->view.empty()) m_currentNodeBuffer.reset();
+        if (m_currentNodeBuffer->view->empty()) release();
     }
 
-    auto& sourceView(m_currentNodeBuffer->view);
+    auto& sourceView(*m_currentNodeBuffer->view);
     const auto& layout(*m_currentNodeBuffer->table.layout());
 
     for (const auto& id : layout.dims())
@@ -1064,7 +1212,7 @@ bool EptReader::processOne(PointRef& point)
             sourceView.getPoint(m_pointId) + layout.dimOffset(id));
     }
 
-    if (++m_pointId == sourceView.size()) m_currentNodeBuffer.reset();
+    if (++m_pointId == sourceView.size()) release();
 
     return true;
 }
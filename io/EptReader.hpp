@@ -60,10 +60,11 @@ namespace arbiter
 }
 
 class Addon;
+class EptCache;
 class EptInfo;
 class FixedPointLayout;
 class Key;
-class Pool;
+class ThreadPool;
 class VectorPointTable;
 
 class PDAL_DLL EptReader : public Reader, public Streamable
@@ -124,11 +125,16 @@ private:
     virtual bool processOne(PointRef& point) override;
     void load();    // Asynchronously fetch EPT nodes for streaming use.
     bool next();    // Acquire an already-fetched node for processing.
+    void release(); // Done with the current node, keep it for reuse.
     NodeBufferIt findBuffer();  // Find a fully acquired node.
 
-    // Data fetching - these forward user-specified query/header params.
+    // Data fetching - these forward user-specified query/header params to
+    // our endpoint and go through the node cache if one is configured.
     std::string get(std::string path) const;
+    std::string get(const arbiter::Endpoint& ep, std::string path) const;
     std::vector<char> getBinary(std::string path) const;
+    std::vector<char> getBinary(const arbiter::Endpoint& ep,
+        std::string path) const;
     arbiter::LocalHandle getLocalHandle(std::string path) const;
 
     std::string m_root;
@@ -136,6 +142,7 @@ private:
     std::unique_ptr<arbiter::Arbiter> m_arbiter;
     std::unique_ptr<arbiter::Endpoint> m_ep;
     std::unique_ptr<EptInfo> m_info;
+    std::unique_ptr<EptCache> m_cache;
 
     struct Args;
 
@@ -143,7 +150,7 @@ private:
 
     BOX3D m_queryBounds;
     int64_t m_queryOriginId = -1;
-    std::unique_ptr<Pool> m_pool;
+    std::unique_ptr<ThreadPool> m_pool;
     std::vector<std::unique_ptr<Addon>> m_addons;
 
     using StringMap = std::map<std::string, std::string>;
@@ -160,6 +167,8 @@ private:
 
     std::unique_ptr<FixedPointLayout> m_remoteLayout;
     DimTypeList m_dimTypes;
+    // IDs in the public layout of the dimensions in m_dimTypes.
+    Dimension::IdList m_dimIds;
     std::array<XForm, 3> m_xyzTransforms;
 
     Dimension::Id m_nodeIdDim = Dimension::Id::Unknown;
@@ -178,6 +187,12 @@ private:
     // current buffer.
     std::unique_ptr<NodeBuffer> m_currentNodeBuffer;
 
+    // Consumed nodes whose memory can be reused, the number of nodes being
+    // fetched and the estimated size of the nodes not yet consumed.
+    std::vector<std::unique_ptr<NodeBuffer>> m_freeNodeBuffers;
+    std::size_t m_loadingNodes = 0;
+    uint64_t m_lookaheadBytes = 0;
+
     // The below represent our current state in streaming operation - in normal
     // mode we use local variables for these.
     Overlaps::const_iterator m_overlapIt;
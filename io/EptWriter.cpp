@@ -0,0 +1,473 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "EptWriter.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <random>
+
+#include <arbiter/arbiter.hpp>
+#include <nlohmann/json.hpp>
+
+#include <io/BufferReader.hpp>
+#include <io/LasWriter.hpp>
+#include <pdal/private/Executor.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#ifdef PDAL_HAVE_ZSTD
+#include <pdal/compression/ZstdCompression.hpp>
+#endif
+
+#include "private/EptSupport.hpp"
+#include "private/LasOctree.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+    const StaticPluginInfo s_info
+    {
+        "writers.ept",
+        "EPT Writer",
+        "http://pdal.io/stages/writers.ept.html",
+        { "ept" }
+    };
+
+    std::string typeString(Dimension::Type t)
+    {
+        const auto base(Dimension::base(t));
+        if (base == Dimension::BaseType::Signed)
+            return "signed";
+        else if (base == Dimension::BaseType::Unsigned)
+            return "unsigned";
+        return "float";
+    }
+}
+
+CREATE_STATIC_STAGE(EptWriter, s_info)
+
+struct EptWriter::Args
+{
+    std::string m_filename;
+    std::string m_dataType;
+    point_count_t m_memoryPoints;
+    double m_scale;
+    uint64_t m_hierarchyStep;
+};
+
+EptWriter::EptWriter() : m_args(new Args), m_haveOffset(false),
+    m_numPoints(0)
+{}
+
+EptWriter::~EptWriter()
+{}
+
+std::string EptWriter::getName() const { return s_info.name; }
+
+void EptWriter::addArgs(ProgramArgs& args)
+{
+    args.add("filename", "Output directory", m_args->m_filename).
+        setPositional();
+    args.add("data_type", "Format of the point data: 'laszip', 'binary' or "
+        "'zstandard'", m_args->m_dataType, "binary");
+    args.add("memory_points", "Maximum number of points held in memory "
+        "before points are spooled to disk", m_args->m_memoryPoints,
+        (point_count_t)10000000);
+    args.add("scale", "Scale of the X, Y and Z values", m_args->m_scale, .01);
+    args.add("hierarchy_step", "Depth interval at which the hierarchy is "
+        "split into separate files", m_args->m_hierarchyStep);
+}
+
+void EptWriter::initialize()
+{
+    if (m_args->m_dataType != "laszip" && m_args->m_dataType != "binary" &&
+            m_args->m_dataType != "zstandard")
+        throwError("Invalid data_type '" + m_args->m_dataType + "'.");
+#ifndef PDAL_HAVE_ZSTD
+    if (m_args->m_dataType == "zstandard")
+        throwError("Can't write zstandard data: PDAL was built without "
+            "Zstandard support.");
+#endif
+    if (m_args->m_scale <= 0)
+        throwError("Option 'scale' must be positive.");
+
+    std::string filename(arbiter::expandTilde(m_args->m_filename));
+    if (Utils::endsWith(filename, "/ept.json"))
+        filename = filename.substr(0, filename.size() - 9);
+
+    m_arbiter.reset(new arbiter::Arbiter());
+    m_ep.reset(new arbiter::Endpoint(m_arbiter->getEndpoint(filename)));
+}
+
+void EptWriter::ready(PointTableRef table)
+{
+    using D = Dimension::Id;
+
+    const PointLayoutPtr layout(table.layout());
+    m_dims.clear();
+    m_dimNames.clear();
+    size_t pointLen = 3 * sizeof(int32_t);
+    for (const DimType& dt : layout->dimTypes())
+    {
+        const std::string name(layout->dimName(dt.m_id));
+        if (dt.m_id == D::X || dt.m_id == D::Y || dt.m_id == D::Z ||
+                name == "EptNodeId" || name == "EptPointId")
+            continue;
+        m_dims.push_back(dt);
+        m_dimNames.push_back(name);
+        pointLen += Dimension::size(dt.m_type);
+    }
+    m_point.resize(pointLen);
+
+    m_builder.reset(new LasOctreeBuilder(pointLen,
+        Executor::global().threads(), m_args->m_memoryPoints));
+    m_haveOffset = false;
+    m_offset[0] = m_offset[1] = m_offset[2] = 0;
+    m_bounds = BOX3D();
+    m_numPoints = 0;
+    m_hierarchy.clear();
+    m_srs = getSpatialReference().empty() ? table.anySpatialReference() :
+        getSpatialReference();
+}
+
+// In standard mode the X, Y and Z values are stored relative to the center
+// of the points.  In stream mode we don't know the points ahead of time, so
+// the offset is zero.
+void EptWriter::write(const PointViewPtr view)
+{
+    if (!m_haveOffset && view->size())
+    {
+        BOX3D b;
+        view->calculateBounds(b);
+        m_offset[0] = std::round(b.minx + (b.maxx - b.minx) / 2);
+        m_offset[1] = std::round(b.miny + (b.maxy - b.miny) / 2);
+        m_offset[2] = std::round(b.minz + (b.maxz - b.minz) / 2);
+        m_haveOffset = true;
+    }
+
+    PointRef point(*view, 0);
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        point.setPointId(idx);
+        processOne(point);
+    }
+}
+
+bool EptWriter::processOne(PointRef& point)
+{
+    using D = Dimension::Id;
+
+    m_haveOffset = true;
+    const double xyz[3] { point.getFieldAs<double>(D::X),
+        point.getFieldAs<double>(D::Y), point.getFieldAs<double>(D::Z) };
+    m_bounds.grow(xyz[0], xyz[1], xyz[2]);
+
+    char *pos = m_point.data();
+    for (int i = 0; i < 3; ++i)
+    {
+        const double d = std::round((xyz[i] - m_offset[i]) / m_args->m_scale);
+        if (d < (std::numeric_limits<int32_t>::lowest)() ||
+                d > (std::numeric_limits<int32_t>::max)())
+            throwError("Scaled value of point is out of range.  Use a "
+                "larger 'scale'.");
+        const int32_t v = (int32_t)d;
+        std::memcpy(pos, &v, sizeof(v));
+        pos += sizeof(v);
+    }
+    point.getPackedData(m_dims, pos);
+
+    m_builder->add(m_point.data(), 1);
+    m_numPoints++;
+    return true;
+}
+
+void EptWriter::spatialReferenceChanged(const SpatialReference& srs)
+{
+    if (getSpatialReference().empty())
+        m_srs = srs;
+}
+
+void EptWriter::done(PointTableRef table)
+{
+    const arbiter::Endpoint dataEp(m_ep->getSubEndpoint("ept-data"));
+    const arbiter::Endpoint hierEp(m_ep->getSubEndpoint("ept-hierarchy"));
+    if (m_ep->isLocal())
+    {
+        arbiter::mkdirp(dataEp.root());
+        arbiter::mkdirp(hierEp.root());
+    }
+
+    std::string ext(".bin");
+    if (m_args->m_dataType == "laszip")
+        ext = ".laz";
+    else if (m_args->m_dataType == "zstandard")
+        ext = ".zst";
+
+    // Nodes are encoded on the executor as the builder passes them on and
+    // written from this thread in the same order.  At most a few nodes per
+    // thread of the executor wait to be written.
+    const size_t pointLen(m_point.size());
+    Executor& executor = Executor::global();
+    typedef std::pair<Key, std::future<std::vector<char>>> Encoding;
+    std::deque<Encoding> pending;
+    auto writeNext = [&]()
+    {
+        Encoding& e = pending.front();
+        executor.wait(e.second);
+        std::vector<char> data(e.second.get());
+        const Key key(e.first);
+        pending.pop_front();
+        dataEp.put(key.toString() + ext, data);
+    };
+
+    // Encodings still running use our state, so they're waited for if
+    // building or writing throws.
+    BOX3D cube;
+    try
+    {
+        cube = m_builder->build([&](const Key& key, char *buf,
+            point_count_t count)
+        {
+            if (!count)
+                return;
+            m_hierarchy[key] = count;
+            if (pending.size() >= 2 * executor.threads())
+                writeNext();
+            std::shared_ptr<std::vector<char>> points(
+                new std::vector<char>(buf, buf + count * pointLen));
+            pending.emplace_back(key, executor.async([this, key, points]()
+            {
+                if (m_args->m_dataType == "laszip")
+                    return encodeLaszip(key, *points);
+                return encode(*points);
+            }));
+        });
+        while (pending.size())
+            writeNext();
+    }
+    catch (...)
+    {
+        for (auto& e : pending)
+            executor.wait(e.second);
+        throw;
+    }
+    m_builder.reset();
+    if (!m_numPoints)
+        cube = BOX3D(0, 0, 0, 0, 0, 0);
+
+    // The octree is built in the scaled coordinates of the points.
+    const double scale(m_args->m_scale);
+    const BOX3D bounds(cube.minx * scale + m_offset[0],
+        cube.miny * scale + m_offset[1], cube.minz * scale + m_offset[2],
+        cube.maxx * scale + m_offset[0], cube.maxy * scale + m_offset[1],
+        cube.maxz * scale + m_offset[2]);
+
+    Key root;
+    if (m_hierarchy.size())
+    {
+        NL::json h;
+        writeHierarchy(h, root, hierEp);
+        hierEp.put(root.toString() + ".json", h.dump());
+    }
+    else
+        hierEp.put(root.toString() + ".json", "{}");
+
+    NL::json info;
+    info["bounds"] = { bounds.minx, bounds.miny, bounds.minz,
+        bounds.maxx, bounds.maxy, bounds.maxz };
+    if (m_numPoints)
+        info["boundsConforming"] = { m_bounds.minx, m_bounds.miny,
+            m_bounds.minz, m_bounds.maxx, m_bounds.maxy, m_bounds.maxz };
+    else
+        info["boundsConforming"] = info["bounds"];
+    info["dataType"] = m_args->m_dataType;
+    info["hierarchyType"] = "json";
+    info["points"] = m_numPoints;
+    info["schema"] = schema();
+    info["span"] = LasOctree::GridSize;
+    if (m_srs.valid())
+        info["srs"] = { { "wkt", m_srs.getWKT() } };
+    else
+        info["srs"] = NL::json::object();
+    info["version"] = "1.0.0";
+    m_ep->put("ept.json", info.dump(2));
+}
+
+NL::json EptWriter::schema() const
+{
+    NL::json schema = NL::json::array();
+    const char *xyz[] { "X", "Y", "Z" };
+    for (int i = 0; i < 3; ++i)
+        schema.push_back({ { "name", xyz[i] }, { "type", "signed" },
+            { "size", 4 }, { "scale", m_args->m_scale },
+            { "offset", m_offset[i] } });
+    for (size_t i = 0; i < m_dims.size(); ++i)
+        schema.push_back({ { "name", m_dimNames[i] },
+            { "type", typeString(m_dims[i].m_type) },
+            { "size", Dimension::size(m_dims[i].m_type) } });
+    return schema;
+}
+
+// Binary data is the packed points.  Zstandard data is the same,
+// compressed.
+std::vector<char> EptWriter::encode(const std::vector<char>& points) const
+{
+    if (m_args->m_dataType == "binary")
+        return points;
+
+    std::vector<char> data;
+#ifdef PDAL_HAVE_ZSTD
+    ZstdCompressor comp([&data](char *pos, std::size_t size)
+    {
+        data.insert(data.end(), pos, pos + size);
+    });
+    comp.compress(points.data(), points.size());
+    comp.done();
+#endif
+    return data;
+}
+
+// LAZ data is written as LAS 1.2, point format 3, with the dimensions that
+// the format lacks as extra bytes.  The LAS writer needs a file, so the
+// data is written to a temporary file and read back.
+std::vector<char> EptWriter::encodeLaszip(const Key& key,
+    const std::vector<char>& points) const
+{
+    using D = Dimension::Id;
+
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(D::X);
+    layout->registerDim(D::Y);
+    layout->registerDim(D::Z);
+    DimTypeList dims;
+    for (size_t i = 0; i < m_dims.size(); ++i)
+        dims.emplace_back(layout->registerOrAssignDim(m_dimNames[i],
+            m_dims[i].m_type), m_dims[i].m_type);
+
+    PointViewPtr view(new PointView(table));
+    const size_t pointLen(m_point.size());
+    const point_count_t count(points.size() / pointLen);
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        const char *pos = points.data() + idx * pointLen;
+        int32_t xyz[3];
+        std::memcpy(xyz, pos, sizeof(xyz));
+        view->setField(D::X, idx, xyz[0] * m_args->m_scale + m_offset[0]);
+        view->setField(D::Y, idx, xyz[1] * m_args->m_scale + m_offset[1]);
+        view->setField(D::Z, idx, xyz[2] * m_args->m_scale + m_offset[2]);
+        view->setPackedPoint(dims, idx, pos + sizeof(xyz));
+    }
+
+    static std::mt19937_64 random(std::random_device{}());
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const std::string filename(arbiter::getTempPath() + "pdal-ept-" +
+        key.toString() + "-" + std::to_string(random()) + ".laz");
+    lock.unlock();
+
+    Options opts;
+    opts.add("filename", filename);
+    opts.add("minor_version", 2);
+    opts.add("dataformat_id", 3);
+    opts.add("extra_dims", "all");
+    opts.add("scale_x", m_args->m_scale);
+    opts.add("scale_y", m_args->m_scale);
+    opts.add("scale_z", m_args->m_scale);
+    opts.add("offset_x", m_offset[0]);
+    opts.add("offset_y", m_offset[1]);
+    opts.add("offset_z", m_offset[2]);
+
+    BufferReader reader;
+    reader.addView(view);
+    LasWriter writer;
+    writer.setOptions(opts);
+    writer.setInput(reader);
+
+    lock.lock();
+    writer.prepare(table);  // Geotiff SRS initialization is not thread-safe.
+    lock.unlock();
+    writer.execute(table);
+
+    std::vector<char> data;
+    std::istream *in = FileUtils::openFile(filename, true);
+    if (in)
+    {
+        data.assign(std::istreambuf_iterator<char>(*in),
+            std::istreambuf_iterator<char>());
+        FileUtils::closeFile(in);
+    }
+    FileUtils::deleteFile(filename);
+    if (data.empty())
+        throwError("Unable to write LAZ data for node " + key.toString() +
+            ".");
+    return data;
+}
+
+void EptWriter::writeHierarchy(NL::json& curr, const Key& key,
+        const arbiter::Endpoint& hierEp) const
+{
+    auto it = m_hierarchy.find(key);
+    if (it == m_hierarchy.end())
+        return;
+
+    const std::string keyName(key.toString());
+    const uint64_t np(it->second);
+    const uint64_t step(m_args->m_hierarchyStep);
+    if (step && key.d && (key.d % step == 0))
+    {
+        curr[keyName] = -1;
+
+        // Create a new hierarchy subtree.
+        NL::json next {{ keyName, np }};
+
+        for (uint64_t dir(0); dir < 8; ++dir)
+            writeHierarchy(next, key.bisect(dir), hierEp);
+
+        hierEp.put(keyName + ".json", next.dump());
+    }
+    else
+    {
+        curr[keyName] = np;
+        for (uint64_t dir(0); dir < 8; ++dir)
+            writeHierarchy(curr, key.bisect(dir), hierEp);
+    }
+}
+
+} // namespace pdal
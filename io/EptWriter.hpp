@@ -0,0 +1,105 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <pdal/JsonFwd.hpp>
+#include <pdal/Streamable.hpp>
+#include <pdal/Writer.hpp>
+
+namespace pdal
+{
+
+namespace arbiter
+{
+    class Arbiter;
+    class Endpoint;
+}
+
+class Key;
+class LasOctreeBuilder;
+
+class PDAL_DLL EptWriter : public Writer, public Streamable
+{
+public:
+    EptWriter();
+    virtual ~EptWriter();
+
+    std::string getName() const override;
+
+private:
+    struct Args;
+    std::unique_ptr<Args> m_args;
+
+    virtual void addArgs(ProgramArgs& args) override;
+    virtual void initialize() override;
+    virtual void ready(PointTableRef table) override;
+    virtual void write(const PointViewPtr view) override;
+    virtual bool processOne(PointRef& point) override;
+    virtual void done(PointTableRef table) override;
+    virtual void spatialReferenceChanged(const SpatialReference& srs)
+        override;
+
+    // Encode the packed points of a node in the output data type.
+    std::vector<char> encode(const std::vector<char>& points) const;
+    std::vector<char> encodeLaszip(const Key& key,
+        const std::vector<char>& points) const;
+    void writeHierarchy(NL::json& curr, const Key& key,
+        const arbiter::Endpoint& hierEp) const;
+    NL::json schema() const;
+
+    std::unique_ptr<arbiter::Arbiter> m_arbiter;
+    std::unique_ptr<arbiter::Endpoint> m_ep;
+    std::unique_ptr<LasOctreeBuilder> m_builder;
+
+    // Points are packed as the scaled X, Y and Z as 32-bit integers,
+    // followed by the other dimensions in their own types.
+    DimTypeList m_dims;
+    std::vector<std::string> m_dimNames;
+    std::vector<char> m_point;
+    double m_offset[3];
+    bool m_haveOffset;
+    BOX3D m_bounds;
+    point_count_t m_numPoints;
+    SpatialReference m_srs;
+    std::map<Key, uint64_t> m_hierarchy;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace pdal
@@ -33,7 +33,9 @@
 
 #include "GDALWriter.hpp"
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include <pdal/EigenUtils.hpp>
 #include <pdal/GDALUtils.hpp>
@@ -92,6 +94,15 @@ void GDALWriter::addArgs(ProgramArgs& args)
 }
 
 
+bool GDALWriter::usedDimensions(StringList& dims) const
+{
+    dims.push_back("X");
+    dims.push_back("Y");
+    dims.push_back(m_interpDimString);
+    return true;
+}
+
+
 void GDALWriter::initialize()
 {
     for (auto& ts : m_outputTypeString)
@@ -263,11 +274,18 @@ void GDALWriter::writeView(const PointViewPtr view)
             expandGrid(bounds);
     }
 
-    PointRef point(*view, 0);
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    const point_count_t blockSize = 4096;
+    std::vector<double> x(blockSize);
+    std::vector<double> y(blockSize);
+    std::vector<double> z(blockSize);
+    for (PointId start = 0; start < view->size(); start += blockSize)
     {
-        point.setPointId(idx);
-        processOne(point);
+        point_count_t count = (std::min)(blockSize, view->size() - start);
+        view->getFieldArray(Dimension::Id::X, start, count, x.data());
+        view->getFieldArray(Dimension::Id::Y, start, count, y.data());
+        view->getFieldArray(m_interpDim, start, count, z.data());
+        for (point_count_t i = 0; i < count; ++i)
+            writePoint(x[i], y[i], z[i]);
     }
 }
 
@@ -278,6 +296,13 @@ bool GDALWriter::processOne(PointRef& point)
     double y = point.getFieldAs<double>(Dimension::Id::Y);
     double z = point.getFieldAs<double>(m_interpDim);
 
+    writePoint(x, y, z);
+    return true;
+}
+
+
+void GDALWriter::writePoint(double x, double y, double z)
+{
     if (m_expandByPoint)
     {
         Cell c = cell(x, y);
@@ -291,7 +316,6 @@ bool GDALWriter::processOne(PointRef& point)
     y -= m_origin.y;
 
     m_grid->addPoint(x, y, z);
-    return true;
 }
 
 
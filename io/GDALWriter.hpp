@@ -67,12 +67,14 @@ public:
 private:
     virtual void addArgs(ProgramArgs& args);
     virtual void initialize();
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void prepared(PointTableRef table);
     virtual void readyFile(const std::string& filename,
         const SpatialReference& srs);
     virtual void writeView(const PointViewPtr view);
     virtual bool processOne(PointRef& point);
     virtual void doneFile();
+    void writePoint(double x, double y, double z);
     void createGrid(BOX2D bounds);
     void expandGrid(BOX2D bounds);
     Cell cell(double x, double y);
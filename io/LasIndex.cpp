@@ -0,0 +1,270 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <pdal/PointView.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+
+#include "LasHeader.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+const std::string Magic("PDAL-QIX");
+const uint32_t Version = 2;
+const point_count_t CellPoints = 10000;
+const int MaxDepth = 8;
+
+} // unnamed namespace
+
+
+bool LasIndex::Source::operator==(const Source& other) const
+{
+    return m_fileSize == other.m_fileSize &&
+        m_pointOffset == other.m_pointOffset &&
+        m_pointCount == other.m_pointCount &&
+        m_bounds == other.m_bounds;
+}
+
+
+LasIndex::LasIndex() : m_source(), m_pointCount(0), m_depth(0)
+{}
+
+
+LasIndex::Source LasIndex::source(const std::string& lasFilename,
+    const LasHeader& header)
+{
+    Source source;
+    source.m_fileSize = FileUtils::fileSize(lasFilename);
+    source.m_pointOffset = header.pointOffset();
+    source.m_pointCount = header.pointCount();
+    source.m_bounds = header.getBounds();
+    return source;
+}
+
+
+std::string LasIndex::filename(const std::string& lasFilename)
+{
+    return lasFilename + ".qix";
+}
+
+
+void LasIndex::build(const PointView& view, const Source& source, int depth)
+{
+    m_source = source;
+    m_pointCount = view.size();
+    m_cells.clear();
+    m_bounds.clear();
+    m_depth = 0;
+    if (m_pointCount == 0)
+        return;
+
+    if (depth < 0)
+    {
+        depth = 0;
+        while (depth < MaxDepth && (m_pointCount >> (2 * depth)) > CellPoints)
+            depth++;
+    }
+    m_depth = depth;
+
+    // Grow the extent a bit so that it has an area even when the points
+    // fall on a line.
+    view.calculateBounds(m_bounds);
+    m_bounds.maxx += (m_bounds.maxx - m_bounds.minx) * 1e-6 + 1e-6;
+    m_bounds.maxy += (m_bounds.maxy - m_bounds.miny) * 1e-6 + 1e-6;
+
+    // Points are visited in order, so each cell's ranges come out sorted.
+    const uint64_t cells = 1ULL << m_depth;
+    for (PointId id = 0; id < view.size(); ++id)
+    {
+        const double x = view.getFieldAs<double>(Dimension::Id::X, id);
+        const double y = view.getFieldAs<double>(Dimension::Id::Y, id);
+        const uint64_t key = cell(y, m_bounds.miny, m_bounds.maxy) * cells +
+            cell(x, m_bounds.minx, m_bounds.maxx);
+
+        RangeList& ranges = m_cells[key];
+        if (ranges.size() && ranges.back().m_end == id)
+            ranges.back().m_end++;
+        else
+            ranges.push_back({ id, id + 1 });
+    }
+}
+
+
+void LasIndex::write(const std::string& filename) const
+{
+    OLeStream out(filename);
+    if (!out)
+        throw pdal_error("Unable to open index file '" + filename +
+            "' for writing.");
+
+    out.put(Magic);
+    out << Version;
+    out << m_source.m_fileSize << m_source.m_pointOffset <<
+        m_source.m_pointCount;
+    out << m_source.m_bounds.minx << m_source.m_bounds.miny <<
+        m_source.m_bounds.minz << m_source.m_bounds.maxx <<
+        m_source.m_bounds.maxy << m_source.m_bounds.maxz;
+    out << (uint64_t)m_pointCount << (uint32_t)m_depth;
+    out << m_bounds.minx << m_bounds.miny << m_bounds.maxx << m_bounds.maxy;
+    out << (uint64_t)m_cells.size();
+    for (auto& cell : m_cells)
+    {
+        out << cell.first << (uint64_t)cell.second.size();
+        for (const Range& r : cell.second)
+            out << (uint64_t)r.m_begin << (uint64_t)r.m_end;
+    }
+    if (!out)
+        throw pdal_error("Unable to write index file '" + filename + "'.");
+}
+
+
+bool LasIndex::read(const std::string& filename)
+{
+    ILeStream in(filename);
+    if (!in)
+        return false;
+
+    std::string magic;
+    uint32_t version;
+    in.get(magic, Magic.size());
+    in >> version;
+    if (!in || magic != Magic || version != Version)
+        return false;
+
+    in >> m_source.m_fileSize >> m_source.m_pointOffset >>
+        m_source.m_pointCount;
+    in >> m_source.m_bounds.minx >> m_source.m_bounds.miny >>
+        m_source.m_bounds.minz >> m_source.m_bounds.maxx >>
+        m_source.m_bounds.maxy >> m_source.m_bounds.maxz;
+
+    uint64_t pointCount;
+    uint32_t depth;
+    uint64_t numCells;
+    in >> pointCount >> depth;
+    in >> m_bounds.minx >> m_bounds.miny >> m_bounds.maxx >> m_bounds.maxy;
+    in >> numCells;
+    if (!in || depth > 31)
+        return false;
+    m_pointCount = pointCount;
+    m_depth = depth;
+
+    m_cells.clear();
+    for (uint64_t i = 0; i < numCells; ++i)
+    {
+        uint64_t key;
+        uint64_t numRanges;
+        in >> key >> numRanges;
+        if (!in)
+            return false;
+
+        RangeList& ranges = m_cells[key];
+        for (uint64_t j = 0; j < numRanges; ++j)
+        {
+            uint64_t begin, end;
+            in >> begin >> end;
+            if (!in || begin >= end || end > m_pointCount)
+                return false;
+            ranges.push_back({ begin, end });
+        }
+    }
+    return true;
+}
+
+
+// Find the cell that holds a value along one axis, clamped to the grid.
+uint64_t LasIndex::cell(double v, double min, double max) const
+{
+    const uint64_t cells = 1ULL << m_depth;
+    const double pos = std::floor((v - min) / (max - min) * cells);
+    if (pos < 0)
+        return 0;
+    return (std::min)((uint64_t)pos, cells - 1);
+}
+
+
+LasIndex::RangeList LasIndex::query(const BOX2D& box) const
+{
+    RangeList ranges;
+    if (m_cells.empty() || !box.overlaps(m_bounds))
+        return ranges;
+
+    const uint64_t cells = 1ULL << m_depth;
+    const uint64_t col0 = cell(box.minx, m_bounds.minx, m_bounds.maxx);
+    const uint64_t col1 = cell(box.maxx, m_bounds.minx, m_bounds.maxx);
+    const uint64_t row0 = cell(box.miny, m_bounds.miny, m_bounds.maxy);
+    const uint64_t row1 = cell(box.maxy, m_bounds.miny, m_bounds.maxy);
+    for (uint64_t row = row0; row <= row1; ++row)
+    {
+        auto it = m_cells.lower_bound(row * cells + col0);
+        auto end = m_cells.upper_bound(row * cells + col1);
+        for (; it != end; ++it)
+            ranges.insert(ranges.end(), it->second.begin(), it->second.end());
+    }
+    merge(ranges);
+    return ranges;
+}
+
+
+void LasIndex::merge(RangeList& ranges)
+{
+    if (ranges.empty())
+        return;
+
+    std::sort(ranges.begin(), ranges.end(),
+        [](const Range& r1, const Range& r2)
+        { return r1.m_begin < r2.m_begin; });
+
+    RangeList merged { ranges.front() };
+    for (const Range& r : ranges)
+    {
+        Range& last = merged.back();
+        if (r.m_begin <= last.m_end)
+            last.m_end = (std::max)(last.m_end, r.m_end);
+        else
+            merged.push_back(r);
+    }
+    ranges.swap(merged);
+}
+
+} // namespace pdal
@@ -0,0 +1,178 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <pdal/pdal_types.hpp>
+#include <pdal/util/Bounds.hpp>
+
+namespace pdal
+{
+
+class LasHeader;
+class PointView;
+
+/**
+  Spatial index of the points in a LAS/LAZ file, stored in a sidecar file
+  next to it.  The extent of the points is divided into the cells of the
+  deepest level of a quadtree, and each cell holds the ranges of point
+  indices in the file whose points fall in the cell.  The index records
+  the size and header values of the file it was built from so that an
+  index left over from an earlier version of the file isn't used.
+*/
+class PDAL_DLL LasIndex
+{
+public:
+    /**
+      Range of point indices, [m_begin, m_end).
+    */
+    struct Range
+    {
+        point_count_t m_begin;
+        point_count_t m_end;
+    };
+    typedef std::vector<Range> RangeList;
+
+    /**
+      Values of a LAS/LAZ file that change when its points are rewritten.
+    */
+    struct Source
+    {
+        uint64_t m_fileSize;
+        uint64_t m_pointOffset;
+        uint64_t m_pointCount;
+        BOX3D m_bounds;
+
+        bool operator==(const Source& other) const;
+        bool operator!=(const Source& other) const
+            { return !(*this == other); }
+    };
+
+    LasIndex();
+
+    /**
+      Return the values that identify the current version of a LAS/LAZ
+      file.
+
+      \param lasFilename  Name of the LAS/LAZ file.
+      \param header  Header of the file.
+      \return  Identifying values of the file.
+    */
+    static Source source(const std::string& lasFilename,
+        const LasHeader& header);
+
+    /**
+      Return the name of the index file of a LAS/LAZ file.
+
+      \param lasFilename  Name of the LAS/LAZ file.
+      \return  Name of the index file.
+    */
+    static std::string filename(const std::string& lasFilename);
+
+    /**
+      Build the index of the points in a view.  Point IDs in the view must
+      be the indices of the points in the file.
+
+      \param view  View holding all the points of a file.
+      \param source  Identifying values of the file.
+      \param depth  Depth of the quadtree.  If negative, a depth is chosen
+        that puts about 10000 points in each cell.
+    */
+    void build(const PointView& view, const Source& source, int depth = -1);
+
+    /**
+      Write the index to a file.
+
+      \param filename  Name of the index file.
+    */
+    void write(const std::string& filename) const;
+
+    /**
+      Read the index from a file.
+
+      \param filename  Name of the index file.
+      \return  Whether the file exists and holds a valid index.
+    */
+    bool read(const std::string& filename);
+
+    /**
+      Return the number of points in the indexed file.
+    */
+    point_count_t pointCount() const
+        { return m_pointCount; }
+
+    /**
+      Return the identifying values of the file the index was built from.
+    */
+    const Source& source() const
+        { return m_source; }
+
+    /**
+      Return the quadtree depth of the index.
+    */
+    int depth() const
+        { return m_depth; }
+
+    /**
+      Find the ranges of points that may fall in a box.  Points in the
+      ranges must still be checked against the box.
+
+      \param box  Query box.
+      \return  Sorted, non-overlapping list of point ranges.
+    */
+    RangeList query(const BOX2D& box) const;
+
+    /**
+      Sort a list of ranges and merge those that overlap or touch.
+
+      \param ranges  List of ranges to merge.
+    */
+    static void merge(RangeList& ranges);
+
+private:
+    Source m_source;
+    point_count_t m_pointCount;
+    BOX2D m_bounds;
+    int m_depth;
+    // Ranges of each non-empty cell, keyed by row * (1 << depth) + column.
+    std::map<uint64_t, RangeList> m_cells;
+
+    uint64_t cell(double v, double min, double max) const;
+};
+
+} // namespace pdal
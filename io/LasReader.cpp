@@ -46,10 +46,13 @@
 #include <pdal/util/Extractor.hpp>
 #include <pdal/util/IStream.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/private/Executor.hpp>
 
 #include "GeotiffSupport.hpp"
 #include "LasHeader.hpp"
 #include "LasVLR.hpp"
+#include "private/LasCodec.hpp"
+#include "private/LasOctree.hpp"
 
 namespace pdal
 {
@@ -65,13 +68,18 @@ struct invalid_stream : public std::runtime_error
 
 } // unnamed namespace
 
-LasReader::LasReader() : m_decompressor(nullptr), m_index(0)
+LasReader::LasReader() : m_laszip(nullptr), m_decompressor(nullptr),
+    m_index(0), m_chunkPoints(0), m_chunkPointSize(0), m_chunk(0),
+    m_nextChunk(0), m_mapPoints(nullptr), m_mapCount(0), m_mapBlockPoints(0),
+    m_resolution(0), m_query(false), m_range(0)
 {}
 
 
 LasReader::~LasReader()
 {
 #ifdef PDAL_HAVE_LAZPERF
+    while (m_chunks.size())
+        popChunk();
     delete m_decompressor;
 #endif
 }
@@ -85,6 +93,13 @@ void LasReader::addArgs(ProgramArgs& args)
     args.add("use_eb_vlr", "Use extra bytes VLR for 1.0 - 1.3 files",
         m_useEbVlr);
     args.add("ignore_vlr", "VLR userid/recordid to ignore", m_ignoreVLROption);
+    args.add("use_mmap", "Memory-map uncompressed point data", m_useMmap);
+    args.add("bounds", "Read only points inside these bounds", m_bounds);
+    args.add("polygon", "Read only points inside these polygons", m_polys).
+        setErrorText("Invalid polygon specification. "
+            "Must be valid GeoJSON/WKT");
+    args.add("resolution", "Read only the octree nodes needed for points "
+        "this far apart", m_resolution);
 }
 
 
@@ -216,6 +231,21 @@ void LasReader::initializeLocal(PointTableRef table, MetadataNode& m)
     if (m_header.versionAtLeast(1, 4) || m_useEbVlr)
         readExtraBytesVlr();
     setSrs(m);
+
+    // Polygons are compared with points in the SRS of the file.
+    std::vector<Polygon> exploded;
+    for (Polygon& poly : m_polys)
+    {
+        if (!poly.valid())
+            throwError("Geometrically invalid polygon in option 'polygon'.");
+        poly.transform(getSpatialReference());
+
+        std::vector<Polygon> polys = poly.polygons();
+        exploded.insert(exploded.end(), polys.begin(), polys.end());
+    }
+    m_polys = std::move(exploded);
+    m_query = !m_bounds.to2d().empty() || m_polys.size() || m_resolution > 0;
+
     MetadataNode forward = table.privateMetadata("lasforward");
     extractHeaderMetadata(forward, m);
     extractVlrMetadata(forward, m);
@@ -243,8 +273,21 @@ void LasReader::ready(PointTableRef table)
     std::istream *stream(m_streamIf->m_istream);
 
     m_index = 0;
+    m_threads = Executor::global().threads();
     if (m_header.compressed())
     {
+#ifdef PDAL_HAVE_LAZPERF
+        m_chunkOffsets.clear();
+        // Chunks can be decompressed out of order, so use them for
+        // spatial queries as well.
+        initChunks(*stream, m_threads > 1 || m_query);
+        if (m_chunkOffsets.size())
+        {
+            initQuery();
+            return;
+        }
+#endif
+
 #ifdef PDAL_HAVE_LASZIP
         if (m_compression == "LASZIP")
         {
@@ -278,7 +321,245 @@ void LasReader::ready(PointTableRef table)
 #endif
     }
     else
-        stream->seekg(m_header.pointOffset());
+    {
+        m_mapPoints = nullptr;
+        if (m_useMmap)
+            initMap();
+        if (!m_mapPoints)
+            stream->seekg(m_header.pointOffset());
+    }
+    initQuery();
+}
+
+
+// Find the ranges of points to read for a spatial query.  If points can be
+// read out of order and the file has an octree or an index, only the ranges
+// of the nodes or cells that overlap the query are read.  Otherwise all
+// points are read and filtered.
+void LasReader::initQuery()
+{
+    m_range = 0;
+    m_ranges.clear();
+    if (!m_query)
+        return;
+
+    const point_count_t numPoints = getNumPoints();
+    m_ranges.push_back({0, numPoints});
+
+    bool seekable = !m_header.compressed() || m_chunkOffsets.size() ||
+        m_compression == "LASZIP";
+    if (!seekable || m_streamIf->m_offset != 0)
+        return;
+
+    const BOX2D bounds = m_bounds.to2d();
+    const bool spatial = !bounds.empty() || m_polys.size();
+    std::vector<BOX2D> boxes;
+    if (!bounds.empty() && m_polys.empty())
+        boxes.push_back(bounds);
+    for (const Polygon& poly : m_polys)
+    {
+        BOX2D box = poly.bounds().to2d();
+        if (!bounds.empty())
+        {
+            if (!box.overlaps(bounds))
+                continue;
+            box.clip(bounds);
+        }
+        boxes.push_back(box);
+    }
+    auto overlaps = [&boxes](const BOX2D& box)
+    {
+        for (const BOX2D& b : boxes)
+            if (b.overlaps(box))
+                return true;
+        return false;
+    };
+
+    std::string source;
+    LasIndex::RangeList ranges;
+    LasOctree octree;
+    const LasVLR *vlr = m_header.findVlr(PDAL_USER_ID, PDAL_OCTREE_RECORD_ID);
+    if (vlr && m_chunkOffsets.size() &&
+        octree.readVlr(vlr->data(), vlr->dataLen()) &&
+        octree.readHierarchy(*m_streamIf->m_istream))
+    {
+        const uint64_t maxDepth = m_resolution > 0 ?
+            octree.depth(m_resolution) :
+            (std::numeric_limits<uint64_t>::max)();
+        for (const LasOctree::Node& node : octree.nodes())
+        {
+            if (node.m_key.d > maxDepth)
+                continue;
+            const BOX3D box = octree.bounds(node.m_key);
+            if (m_bounds.is3d() && !box.overlaps(m_bounds.to3d()))
+                continue;
+            if (spatial && !overlaps(box.to2d()))
+                continue;
+
+            // Each node is a chunk.
+            auto it = std::lower_bound(m_chunkOffsets.begin(),
+                m_chunkOffsets.end() - 1, node.m_offset);
+            if (it == m_chunkOffsets.end() - 1 || *it != node.m_offset)
+            {
+                log()->get(LogLevel::Warning) << "Ignoring octree of '" <<
+                    m_filename << "', which doesn't match its chunks." <<
+                    std::endl;
+                return;
+            }
+            const size_t chunk = it - m_chunkOffsets.begin();
+            ranges.push_back({ m_chunkFirst[chunk], m_chunkFirst[chunk + 1] });
+        }
+        source = "octree";
+    }
+    else
+    {
+        if (m_resolution > 0)
+            log()->get(LogLevel::Warning) << "Ignoring option 'resolution'. "
+                "File '" << m_filename << "' has no octree." << std::endl;
+        if (!spatial)
+            return;
+
+        LasIndex index;
+        if (!index.read(LasIndex::filename(m_filename)))
+            return;
+        if (index.pointCount() != numPoints ||
+            index.source() != LasIndex::source(m_filename, m_header))
+        {
+            log()->get(LogLevel::Warning) << "Ignoring index '" <<
+                LasIndex::filename(m_filename) << "', which doesn't match "
+                "the points of '" << m_filename << "'." << std::endl;
+            return;
+        }
+        for (const BOX2D& box : boxes)
+        {
+            LasIndex::RangeList boxRanges = index.query(box);
+            ranges.insert(ranges.end(), boxRanges.begin(), boxRanges.end());
+        }
+        source = "index '" + LasIndex::filename(m_filename) + "'";
+    }
+
+#ifdef PDAL_HAVE_LAZPERF
+    // Whole chunks are decompressed, so read whole chunks.
+    if (m_chunkOffsets.size())
+        for (LasIndex::Range& r : ranges)
+        {
+            r.m_begin = m_chunkFirst[chunkOf(r.m_begin)];
+            r.m_end = m_chunkFirst[chunkOf(r.m_end - 1) + 1];
+        }
+#endif
+    LasIndex::merge(ranges);
+    m_ranges.swap(ranges);
+
+    point_count_t count = 0;
+    for (const LasIndex::Range& r : m_ranges)
+        count += r.m_end - r.m_begin;
+    log()->get(LogLevel::Debug) << "Reading " << count << " of " <<
+        numPoints << " points in " << m_ranges.size() << " ranges using " <<
+        source << "." << std::endl;
+}
+
+
+// Move to the next point to read for a spatial query.  Return false if
+// there are no more points to read.
+bool LasReader::nextRange()
+{
+    while (m_range < m_ranges.size() && m_index >= m_ranges[m_range].m_end)
+        m_range++;
+    if (m_range >= m_ranges.size())
+        return false;
+    if (m_index < m_ranges[m_range].m_begin)
+        seekPoint(m_ranges[m_range].m_begin);
+    return true;
+}
+
+
+// Position the reader so that the next point read is 'index'.  Decompressed
+// chunks and mapped points are found from m_index when read.
+void LasReader::seekPoint(point_count_t index)
+{
+    if (!m_header.compressed())
+    {
+        if (!m_mapPoints)
+        {
+            std::istream *stream(m_streamIf->m_istream);
+
+            stream->clear();
+            stream->seekg(m_header.pointOffset() +
+                index * m_header.pointLen());
+        }
+    }
+#ifdef PDAL_HAVE_LASZIP
+    else if (m_compression == "LASZIP" && m_chunkOffsets.empty())
+        handleLaszip(laszip_seek_point(m_laszip, index));
+#endif
+    m_index = index;
+}
+
+
+bool LasReader::passesQuery(const PointRef& point) const
+{
+    const double x = point.getFieldAs<double>(Dimension::Id::X);
+    const double y = point.getFieldAs<double>(Dimension::Id::Y);
+
+    if (m_bounds.is3d())
+    {
+        const double z = point.getFieldAs<double>(Dimension::Id::Z);
+        if (!m_bounds.to3d().contains(x, y, z))
+            return false;
+    }
+    else if (!m_bounds.to2d().empty() && !m_bounds.to2d().contains(x, y))
+        return false;
+
+    if (m_polys.empty())
+        return true;
+    for (const Polygon& poly : m_polys)
+        if (poly.contains(x, y))
+            return true;
+    return false;
+}
+
+
+// Read the points in the query ranges in blocks and keep those that pass
+// the query.
+point_count_t LasReader::readQuery(PointViewPtr view, point_count_t count)
+{
+    const point_count_t blockSize = 1000000;
+
+    // The callback is run on kept points only.
+    PointReadFunc cb;
+    std::swap(cb, m_cb);
+
+    point_count_t numRead = 0;
+    try
+    {
+        while (numRead < count && nextRange())
+        {
+            point_count_t blockCount = (std::min)(blockSize,
+                m_ranges[m_range].m_end - m_index);
+            blockCount = (std::min)(blockCount, count - numRead);
+
+            PointViewPtr block = view->makeNew();
+            if (readPoints(block, blockCount) == 0)
+                break;
+            for (PointId id = 0; id < block->size(); ++id)
+            {
+                PointRef point = block->point(id);
+                if (!passesQuery(point))
+                    continue;
+                view->appendPoint(*block, id);
+                numRead++;
+                if (cb)
+                    cb(*view, view->size() - 1);
+            }
+        }
+    }
+    catch (...)
+    {
+        std::swap(cb, m_cb);
+        throw;
+    }
+    std::swap(cb, m_cb);
+    return numRead;
 }
 
 
@@ -532,39 +813,47 @@ void LasReader::addDimensions(PointLayoutPtr layout)
 {
     using namespace Dimension;
 
-    layout->registerDim(Id::X, Type::Double);
-    layout->registerDim(Id::Y, Type::Double);
-    layout->registerDim(Id::Z, Type::Double);
-    layout->registerDim(Id::Intensity, Type::Unsigned16);
-    layout->registerDim(Id::ReturnNumber, Type::Unsigned8);
-    layout->registerDim(Id::NumberOfReturns, Type::Unsigned8);
-    layout->registerDim(Id::ScanDirectionFlag, Type::Unsigned8);
-    layout->registerDim(Id::EdgeOfFlightLine, Type::Unsigned8);
-    layout->registerDim(Id::Classification, Type::Unsigned8);
-    layout->registerDim(Id::ScanAngleRank, Type::Float);
-    layout->registerDim(Id::UserData, Type::Unsigned8);
-    layout->registerDim(Id::PointSourceId, Type::Unsigned16);
+    // Dimensions that aren't registered are skipped when points are
+    // stored, so there's no need to decode them.
+    auto reg = [this, &layout](Id id, Type type)
+    {
+        if (dimUsed(id))
+            layout->registerDim(id, type);
+    };
+
+    reg(Id::X, Type::Double);
+    reg(Id::Y, Type::Double);
+    reg(Id::Z, Type::Double);
+    reg(Id::Intensity, Type::Unsigned16);
+    reg(Id::ReturnNumber, Type::Unsigned8);
+    reg(Id::NumberOfReturns, Type::Unsigned8);
+    reg(Id::ScanDirectionFlag, Type::Unsigned8);
+    reg(Id::EdgeOfFlightLine, Type::Unsigned8);
+    reg(Id::Classification, Type::Unsigned8);
+    reg(Id::ScanAngleRank, Type::Float);
+    reg(Id::UserData, Type::Unsigned8);
+    reg(Id::PointSourceId, Type::Unsigned16);
 
     if (m_header.hasTime())
-        layout->registerDim(Id::GpsTime, Type::Double);
+        reg(Id::GpsTime, Type::Double);
     if (m_header.hasColor())
     {
-        layout->registerDim(Id::Red, Type::Unsigned16);
-        layout->registerDim(Id::Green, Type::Unsigned16);
-        layout->registerDim(Id::Blue, Type::Unsigned16);
+        reg(Id::Red, Type::Unsigned16);
+        reg(Id::Green, Type::Unsigned16);
+        reg(Id::Blue, Type::Unsigned16);
     }
     if (m_header.hasInfrared())
-        layout->registerDim(Id::Infrared);
+        reg(Id::Infrared, defaultType(Id::Infrared));
     if (m_header.versionAtLeast(1, 4))
     {
-        layout->registerDim(Id::ScanChannel);
-        layout->registerDim(Id::ClassFlags);
+        reg(Id::ScanChannel, defaultType(Id::ScanChannel));
+        reg(Id::ClassFlags, defaultType(Id::ClassFlags));
     }
 
     for (auto& dim : m_extraDims)
     {
         Dimension::Type type = dim.m_dimType.m_type;
-        if (type == Dimension::Type::None)
+        if (type == Dimension::Type::None || !dimUsed(dim.m_name))
             continue;
         if (dim.m_dimType.m_xform.nonstandard())
             type = Dimension::Type::Double;
@@ -574,6 +863,23 @@ void LasReader::addDimensions(PointLayoutPtr layout)
 
 
 bool LasReader::processOne(PointRef& point)
+{
+    if (!m_query)
+        return readPoint(point);
+
+    // Points outside the query are read into the same point and replaced.
+    while (nextRange())
+    {
+        if (!readPoint(point))
+            return false;
+        if (passesQuery(point))
+            return true;
+    }
+    return false;
+}
+
+
+bool LasReader::readPoint(PointRef& point)
 {
     if (m_index >= getNumPoints())
         return false;
@@ -582,6 +888,20 @@ bool LasReader::processOne(PointRef& point)
 
     if (m_header.compressed())
     {
+#ifdef PDAL_HAVE_LAZPERF
+        if (m_chunkOffsets.size())
+        {
+            const size_t chunk = chunkOf(m_index);
+            if (m_chunkBuf.empty() || chunk != m_chunk)
+                loadChunk(chunk);
+            const size_t pos =
+                (m_index - m_chunkFirst[chunk]) * m_chunkPointSize;
+            loadPoint(point, m_chunkBuf.data() + pos, pointLen);
+            m_index++;
+            return true;
+        }
+#endif
+
 #ifdef PDAL_HAVE_LASZIP
         if (m_compression == "LASZIP")
         {
@@ -602,6 +922,14 @@ bool LasReader::processOne(PointRef& point)
             "LAZperf decompression library.");
 #endif
     } // compression
+    else if (m_mapPoints)
+    {
+        if (m_index >= m_mapCount)
+            return false;
+        if (m_index % m_mapBlockPoints == 0)
+            prefetchPoints(m_index + m_mapBlockPoints, m_mapBlockPoints);
+        loadPoint(point, m_mapPoints + m_index * pointLen, pointLen);
+    }
     else
     {
         std::vector<char> buf(m_header.pointLen());
@@ -615,6 +943,14 @@ bool LasReader::processOne(PointRef& point)
 
 
 point_count_t LasReader::read(PointViewPtr view, point_count_t count)
+{
+    if (m_query)
+        return readQuery(view, count);
+    return readPoints(view, count);
+}
+
+
+point_count_t LasReader::readPoints(PointViewPtr view, point_count_t count)
 {
     size_t pointLen = m_header.pointLen();
     count = (std::min)(count, getNumPoints() - m_index);
@@ -622,23 +958,31 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
     PointId i = 0;
     if (m_header.compressed())
     {
+#ifdef PDAL_HAVE_LAZPERF
+        if (m_chunkOffsets.size())
+            return readChunks(view, count);
+#endif
 #if defined(PDAL_HAVE_LAZPERF) || defined(PDAL_HAVE_LASZIP)
         if (m_compression == "LASZIP" || m_compression == "LAZPERF")
         {
+            // readPoint() advances m_index.
             for (i = 0; i < count; i++)
             {
-                PointRef point = view->point(i);
                 PointId id = view->size();
-                processOne(point);
+                PointRef point = view->point(id);
+                readPoint(point);
                 if (m_cb)
                     m_cb(*view, id);
             }
+            return (point_count_t)i;
         }
 #else
         throwError("Can't read compressed file without LASzip or "
             "LAZperf decompression library.");
 #endif
     }
+    else if (m_mapPoints)
+        return readMapped(view, count);
     else
     {
         point_count_t remaining = count;
@@ -652,17 +996,12 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
             {
                 point_count_t blockPoints = readFileBlock(buf, remaining);
                 remaining -= blockPoints;
-                char *pos = buf.data();
-                while (blockPoints--)
-                {
-                    PointId id = view->size();
-                    PointRef point = view->point(id);
-                    loadPoint(point, pos, pointLen);
-                    if (m_cb)
+                PointId id = view->size();
+                loadPoints(*view, id, buf.data(), pointLen, blockPoints);
+                if (m_cb)
+                    for (PointId last = id + blockPoints; id < last; ++id)
                         m_cb(*view, id);
-                    pos += pointLen;
-                    i++;
-                }
+                i += blockPoints;
             } while (remaining);
         }
         catch (std::out_of_range&)
@@ -699,6 +1038,300 @@ point_count_t LasReader::readFileBlock(std::vector<char>& buf,
 }
 
 
+#ifdef PDAL_HAVE_LAZPERF
+// Read the LAZ chunk table so that chunks can be decompressed in parallel.
+// If the table isn't wanted or can't be used, m_chunkOffsets is left empty
+// and points are decompressed serially.  Chunks of varying size can only be
+// found from the table, so it's always read for them.
+void LasReader::initChunks(std::istream& stream, bool wanted)
+{
+    const LasVLR *vlr = m_header.findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+    if (!vlr)
+        throwError("LAZ file missing required laszip VLR.");
+
+    LazPerfVlrChunkDecompressor decompressor(vlr->data());
+    m_chunkPoints = decompressor.chunkSize();
+    m_chunkPointSize = decompressor.pointSize();
+    if (m_chunkPoints && !wanted)
+        return;
+
+    const point_count_t numPoints = getNumPoints();
+    m_chunkFirst.clear();
+    if (m_chunkPoints)
+    {
+        point_count_t numChunks =
+            (numPoints + m_chunkPoints - 1) / m_chunkPoints;
+        m_chunkOffsets = LazPerfVlrChunkDecompressor::chunkTable(stream,
+            m_header.pointOffset());
+        if (m_chunkOffsets.size() != numChunks + 1)
+            m_chunkOffsets.clear();
+        for (point_count_t i = 0; i < numChunks; ++i)
+            m_chunkFirst.push_back(i * m_chunkPoints);
+    }
+    else
+    {
+        std::vector<uint64_t> counts;
+        m_chunkOffsets = LazPerfVlrChunkDecompressor::chunkTable(stream,
+            m_header.pointOffset(), &counts);
+        point_count_t first = 0;
+        for (uint64_t count : counts)
+        {
+            m_chunkFirst.push_back(first);
+            first += count;
+        }
+        if (first != numPoints)
+            m_chunkOffsets.clear();
+    }
+    m_chunkFirst.push_back(numPoints);
+
+    if (m_chunkOffsets.empty())
+    {
+        if (!m_chunkPoints && m_compression == "LAZPERF")
+            throwError("Can't read chunk table of LAZ file with chunks of "
+                "varying size.");
+        log()->get(LogLevel::Debug) << "Can't use LAZ chunk table. "
+            "Decompressing on a single thread." << std::endl;
+        return;
+    }
+
+    while (m_chunks.size())
+        popChunk();
+    m_chunkBuf.clear();
+    m_chunk = 0;
+    m_nextChunk = 0;
+}
+
+
+// Find the chunk that holds a point.
+size_t LasReader::chunkOf(point_count_t index) const
+{
+    auto it = std::upper_bound(m_chunkFirst.begin(), m_chunkFirst.end(),
+        index);
+    return (size_t)(it - m_chunkFirst.begin()) - 1;
+}
+
+
+// Read the compressed data of a chunk.  Called on the thread running the
+// reader, so that executor threads never wait on the stream.
+LasReader::ChunkData LasReader::readChunk(size_t chunk)
+{
+    ChunkData compressed(new std::vector<char>(m_chunkOffsets[chunk + 1] -
+        m_chunkOffsets[chunk]));
+
+    std::istream *stream(m_streamIf->m_istream);
+    stream->seekg(m_chunkOffsets[chunk]);
+    stream->read(compressed->data(), compressed->size());
+    if (stream->gcount() != (std::streamsize)compressed->size())
+        throwError("Unable to read compressed data for chunk " +
+            std::to_string(chunk) + ".");
+    return compressed;
+}
+
+
+// Decompress a chunk read by readChunk().  Called on executor threads.
+std::vector<char> LasReader::decompressChunk(size_t chunk,
+    std::vector<char>& compressed) const
+{
+    const point_count_t first = m_chunkFirst[chunk];
+    const point_count_t count = m_chunkFirst[chunk + 1] - first;
+
+    const LasVLR *vlr = m_header.findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+    LazPerfVlrChunkDecompressor decompressor(vlr->data());
+    std::vector<char> points(count * m_chunkPointSize);
+    decompressor.decompress(compressed.data(), compressed.size(),
+        points.data(), count);
+    return points;
+}
+
+
+// Make a decompressed chunk current in stream mode.  Queued chunks that
+// precede it are dropped and chunks are queued so that each thread has work
+// ahead of the consumer.  With a spatial query, only chunks holding points
+// in the query ranges are queued.
+void LasReader::loadChunk(size_t chunk)
+{
+    auto wanted = [this](size_t chunk)
+    {
+        if (!m_query)
+            return true;
+        const point_count_t first = m_chunkFirst[chunk];
+        auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), first,
+            [](point_count_t v, const LasIndex::Range& r)
+            { return v < r.m_end; });
+        return it != m_ranges.end() && it->m_begin < m_chunkFirst[chunk + 1];
+    };
+
+    while (m_chunks.size() && m_chunks.front().first < chunk)
+        popChunk();
+    if (m_chunks.empty() || m_chunks.front().first != chunk)
+    {
+        while (m_chunks.size())
+            popChunk();
+        m_nextChunk = chunk;
+    }
+
+    const size_t numChunks = m_chunkOffsets.size() - 1;
+    Executor& executor = Executor::global();
+    while (m_chunks.size() < 2 * m_threads && m_nextChunk < numChunks)
+    {
+        size_t next = m_nextChunk++;
+        if (next != chunk && !wanted(next))
+            continue;
+        ChunkData compressed = readChunk(next);
+        m_chunks.emplace_back(next, executor.async([this, next, compressed]()
+            { return decompressChunk(next, *compressed); }));
+    }
+    if (m_chunks.empty())
+        throwError("Unexpected end of compressed point data.");
+    executor.wait(m_chunks.front().second);
+    m_chunkBuf = m_chunks.front().second.get();
+    m_chunks.pop_front();
+    m_chunk = chunk;
+}
+
+
+// Drop the oldest queued chunk.  Its decompression may still be running and
+// uses the reader, so wait for it to finish.
+void LasReader::popChunk()
+{
+    std::future<std::vector<char>>& f = m_chunks.front().second;
+    Executor::global().wait(f);
+    m_chunks.pop_front();
+}
+
+
+// Decompress the chunks holding the next 'count' points in parallel.  Points
+// are added to the view first so that each chunk fills its own range.  Each
+// chunk is read on this thread and its decompression is queued while the
+// next chunk is read.
+point_count_t LasReader::readChunks(PointViewPtr view, point_count_t count)
+{
+    const PointId start = view->size();
+    const point_count_t first = m_index;
+    const point_count_t end = m_index + count;
+
+    view->addPoints(count);
+
+    const size_t numChunks = m_chunkFirst.size() - 1;
+    TaskGroup group;
+    for (size_t chunk = chunkOf(first);
+            chunk < numChunks && m_chunkFirst[chunk] < end; ++chunk)
+    {
+        ChunkData compressed = readChunk(chunk);
+        group.run([this, chunk, compressed, view, start, first, end]()
+        {
+            std::vector<char> buf = decompressChunk(chunk, *compressed);
+
+            const point_count_t chunkFirst = m_chunkFirst[chunk];
+            const point_count_t b = (std::max)(first, chunkFirst);
+            const point_count_t e = (std::min)(end,
+                chunkFirst + buf.size() / m_chunkPointSize);
+            if (b < e)
+                loadPoints(*view, start + b - first,
+                    buf.data() + (b - chunkFirst) * m_chunkPointSize,
+                    m_chunkPointSize, e - b);
+        });
+    }
+    group.wait();
+
+    if (m_cb)
+        for (PointId id = start; id < start + count; ++id)
+            m_cb(*view, id);
+    m_index += count;
+    return count;
+}
+#endif // PDAL_HAVE_LAZPERF
+
+
+// Map the file so that uncompressed points can be decoded in place rather
+// than copied from the stream.  If the file can't be mapped, m_mapPoints is
+// left null and points are read from the stream.
+void LasReader::initMap()
+{
+    m_map = FileUtils::mapFile(m_streamIf->m_filename);
+    if (!m_map.addr())
+    {
+        log()->get(LogLevel::Debug) << m_map.what() <<
+            " Reading points from stream." << std::endl;
+        return;
+    }
+
+    const size_t pointLen = m_header.pointLen();
+    const uint64_t start = m_streamIf->m_offset + m_header.pointOffset();
+    if (start > m_map.size())
+    {
+        FileUtils::unmapFile(m_map);
+        return;
+    }
+    m_mapPoints = m_map.addr() + start;
+
+    // A truncated file holds fewer points than the header claims.
+    m_mapCount = (std::min)(getNumPoints(),
+        (point_count_t)((m_map.size() - start) / pointLen));
+    m_mapBlockPoints = (std::max)((size_t)1, 1000000 / pointLen);
+    prefetchPoints(0, m_mapBlockPoints);
+}
+
+
+void LasReader::prefetchPoints(point_count_t index, point_count_t count)
+{
+    const size_t pointLen = m_header.pointLen();
+    FileUtils::prefetchMap(m_map,
+        (m_mapPoints - m_map.addr()) + index * pointLen, count * pointLen);
+}
+
+
+// Decode the next 'count' points from the mapped file.  With more than one
+// thread, points are added to the view first and blocks of points are
+// decoded into their own ranges in parallel.
+point_count_t LasReader::readMapped(PointViewPtr view, point_count_t count)
+{
+    const size_t pointLen = m_header.pointLen();
+    const PointId start = view->size();
+    char *base = m_mapPoints + m_index * pointLen;
+    count = (std::min)(count, m_mapCount - m_index);
+
+    if (m_threads > 1)
+    {
+        view->addPoints(count);
+
+        TaskGroup group;
+        for (point_count_t first = 0; first < count;
+                first += m_mapBlockPoints)
+        {
+            point_count_t last = (std::min)(count, first + m_mapBlockPoints);
+            group.run([this, view, base, start, first, last, pointLen]()
+            {
+                loadPoints(*view, start + first, base + first * pointLen,
+                    pointLen, last - first);
+            });
+        }
+        group.wait();
+
+        if (m_cb)
+            for (PointId id = start; id < start + count; ++id)
+                m_cb(*view, id);
+    }
+    else
+    {
+        for (point_count_t first = 0; first < count;
+                first += m_mapBlockPoints)
+        {
+            point_count_t last = (std::min)(count, first + m_mapBlockPoints);
+            prefetchPoints(m_index + last, m_mapBlockPoints);
+            PointId id = view->size();
+            loadPoints(*view, id, base + first * pointLen, pointLen,
+                last - first);
+            if (m_cb)
+                for (PointId end = id + last - first; id < end; ++id)
+                    m_cb(*view, id);
+        }
+    }
+    m_index += count;
+    return count;
+}
+
+
 #ifdef PDAL_HAVE_LASZIP
 void LasReader::loadPoint(PointRef& point, laszip_point& p)
 {
@@ -710,6 +1343,35 @@ void LasReader::loadPoint(PointRef& point, laszip_point& p)
 #endif // PDAL_HAVE_LASZIP
 
 
+// Decode 'count' records, 'stride' bytes apart, into the view starting at
+// 'id'.  Base fields are decoded a batch at a time by code specialized for
+// the point format.
+void LasReader::loadPoints(PointView& view, PointId id, const char *buf,
+    size_t stride, point_count_t count)
+{
+    LasCodec::Batch batch;
+    for (point_count_t done = 0; done < count; done += LasCodec::BatchSize)
+    {
+        point_count_t n = (std::min)(LasCodec::BatchSize, count - done);
+        LasCodec::decode(m_header, buf + done * stride, stride, n, batch);
+        LasCodec::store(m_header, batch, view, id + done, n);
+    }
+
+    if (m_extraDims.size())
+    {
+        const size_t baseLen = m_header.basePointLen();
+        PointRef point(view, id);
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            point.setPointId(id + i);
+            LeExtractor extractor(buf + i * stride + baseLen,
+                stride - baseLen);
+            loadExtraDims(extractor, point);
+        }
+    }
+}
+
+
 void LasReader::loadPoint(PointRef& point, char *buf, size_t bufsize)
 {
     if (m_header.has14Format())
@@ -944,8 +1606,10 @@ void LasReader::loadExtraDims(LeExtractor& istream, PointRef& point)
 {
     for (auto& dim : m_extraDims)
     {
-        // Dimension type of None is undefined and unprocessed
-        if (dim.m_dimType.m_type == Dimension::Type::None)
+        // Dimension type of None is undefined and unprocessed.  Dimensions
+        // without an ID weren't registered.
+        if (dim.m_dimType.m_type == Dimension::Type::None ||
+            dim.m_dimType.m_id == Dimension::Id::Unknown)
         {
             istream.skip(dim.m_size);
             continue;
@@ -972,8 +1636,17 @@ void LasReader::done(PointTableRef)
     {
         handleLaszip(laszip_close_reader(m_laszip));
         handleLaszip(laszip_destroy(m_laszip));
+        m_laszip = nullptr;
     }
 #endif
+    // Wait for any prefetched chunks before the stream is closed.
+#ifdef PDAL_HAVE_LAZPERF
+    while (m_chunks.size())
+        popChunk();
+#endif
+    m_chunkOffsets.clear();
+    FileUtils::unmapFile(m_map);
+    m_mapPoints = nullptr;
     m_streamIf.reset();
 }
 
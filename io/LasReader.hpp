@@ -34,11 +34,17 @@
 
 #pragma once
 
+#include <deque>
+#include <future>
+#include <memory>
+
 #include <pdal/pdal_export.hpp>
 #include <pdal/pdal_features.hpp>
 #include <pdal/PDALUtils.hpp>
+#include <pdal/Polygon.hpp>
 #include <pdal/Reader.hpp>
 #include <pdal/Streamable.hpp>
+#include <pdal/util/FileUtils.hpp>
 
 #ifdef PDAL_HAVE_LASZIP
 #include <laszip/laszip_api.h>
@@ -50,6 +56,7 @@ struct laszip_point;
 
 #include "LasError.hpp"
 #include "LasHeader.hpp"
+#include "LasIndex.hpp"
 #include "LasUtils.hpp"
 
 namespace pdal
@@ -67,11 +74,12 @@ protected:
     class LasStreamIf
     {
     protected:
-        LasStreamIf()
+        LasStreamIf() : m_offset(0)
         {}
 
     public:
-        LasStreamIf(const std::string& filename)
+        LasStreamIf(const std::string& filename) : m_filename(filename),
+                m_offset(0)
             { m_istream = Utils::openFile(filename); }
 
         virtual ~LasStreamIf()
@@ -81,6 +89,10 @@ protected:
         }
 
         std::istream *m_istream;
+        // File holding the LAS data and the offset of the data within it,
+        // used to memory-map point data.
+        std::string m_filename;
+        uint64_t m_offset;
     };
 
     friend class NitfReader;
@@ -114,6 +126,8 @@ protected:
 
 private:
     typedef std::vector<LasUtils::IgnoreVLR> IgnoreVLRList;
+    // Compressed chunk data, shared with the task that decompresses it.
+    typedef std::shared_ptr<std::vector<char>> ChunkData;
 
     LasHeader m_header;
     laszip_POINTER m_laszip;
@@ -128,6 +142,41 @@ private:
     std::string m_compression;
     StringList m_ignoreVLROption;
     bool m_useEbVlr;
+    // Threads of the shared executor, which points are decoded on.
+    size_t m_threads;
+
+    // Parallel decompression of LAZ chunks.  m_chunkOffsets is empty when
+    // points are decompressed serially.  m_chunkFirst is the index of the
+    // first point of each chunk, followed by the number of points.
+    // m_chunkPoints is zero when chunks vary in size.
+    std::vector<uint64_t> m_chunkOffsets;
+    std::vector<point_count_t> m_chunkFirst;
+    point_count_t m_chunkPoints;
+    size_t m_chunkPointSize;
+    // Stream mode: chunks being decompressed ahead of processOne(), with
+    // their chunk numbers.  m_chunk is the chunk in m_chunkBuf.
+    std::deque<std::pair<size_t, std::future<std::vector<char>>>> m_chunks;
+    std::vector<char> m_chunkBuf;
+    size_t m_chunk;
+    size_t m_nextChunk;
+
+    // Memory-mapped reads of uncompressed points.  m_mapPoints is null
+    // when points are read from the stream.
+    bool m_useMmap;
+    FileUtils::MapContext m_map;
+    char *m_mapPoints;
+    point_count_t m_mapCount;
+    point_count_t m_mapBlockPoints;
+
+    // Spatial query from the 'bounds', 'polygon' and 'resolution' options.
+    // Only points in m_ranges, found from the file's octree or index when
+    // it has one, are read.  m_range is the range being read.
+    Bounds m_bounds;
+    std::vector<Polygon> m_polys;
+    double m_resolution;
+    bool m_query;
+    LasIndex::RangeList m_ranges;
+    size_t m_range;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void initialize(PointTableRef table)
@@ -138,9 +187,12 @@ private:
     virtual void ready(PointTableRef table);
     virtual point_count_t read(PointViewPtr view, point_count_t count);
     virtual bool processOne(PointRef& point);
+    point_count_t readPoints(PointViewPtr view, point_count_t count);
+    bool readPoint(PointRef& point);
     virtual void done(PointTableRef table);
     virtual bool eof()
-        { return m_index >= getNumPoints(); }
+        { return m_index >= getNumPoints() ||
+            (m_query && m_range >= m_ranges.size()); }
 
     void handleCompressionOption();
     void setSrs(MetadataNode& m);
@@ -151,11 +203,29 @@ private:
     void loadPointV10(PointRef& point, laszip_point& p);
     void loadPointV14(PointRef& point, laszip_point& p);
     void loadPoint(PointRef& point, char *buf, size_t bufsize);
+    void loadPoints(PointView& view, PointId id, const char *buf,
+        size_t stride, point_count_t count);
     void loadPointV10(PointRef& point, char *buf, size_t bufsize);
     void loadPointV14(PointRef& point, char *buf, size_t bufsize);
     void loadExtraDims(LeExtractor& istream, PointRef& data);
     point_count_t readFileBlock(std::vector<char>& buf,
         point_count_t maxPoints);
+    void initChunks(std::istream& stream, bool wanted);
+    size_t chunkOf(point_count_t index) const;
+    ChunkData readChunk(size_t chunk);
+    std::vector<char> decompressChunk(size_t chunk,
+        std::vector<char>& compressed) const;
+    void loadChunk(size_t chunk);
+    void popChunk();
+    point_count_t readChunks(PointViewPtr view, point_count_t count);
+    void initMap();
+    void prefetchPoints(point_count_t index, point_count_t count);
+    point_count_t readMapped(PointViewPtr view, point_count_t count);
+    void initQuery();
+    bool nextRange();
+    void seekPoint(point_count_t index);
+    bool passesQuery(const PointRef& point) const;
+    point_count_t readQuery(PointViewPtr view, point_count_t count);
     void handleLaszip(int result);
 
     LasReader& operator=(const LasReader&); // not implemented
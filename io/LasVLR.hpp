@@ -53,6 +53,7 @@ static const uint16_t LASZIP_RECORD_ID = 22204;
 static const uint16_t EXTRA_BYTES_RECORD_ID = 4;
 static const uint16_t PDAL_METADATA_RECORD_ID = 12;
 static const uint16_t PDAL_PIPELINE_RECORD_ID = 13;
+static const uint16_t PDAL_OCTREE_RECORD_ID = 14;
 
 static const char TRANSFORM_USER_ID[] = "LASF_Projection";
 static const char SPEC_USER_ID[] = "LASF_Spec";
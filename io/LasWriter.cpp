@@ -53,6 +53,7 @@
 #include "LasWriter.hpp"
 
 #include <climits>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -66,8 +67,11 @@
 #include <pdal/util/OStream.hpp>
 #include <pdal/util/Utils.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/private/Executor.hpp>
 
 #include "GeotiffSupport.hpp"
+#include "private/LasCodec.hpp"
+#include "private/LasOctree.hpp"
 
 namespace pdal
 {
@@ -87,7 +91,8 @@ CREATE_STATIC_STAGE(LasWriter, s_info)
 std::string LasWriter::getName() const { return s_info.name; }
 
 LasWriter::LasWriter() : m_compressor(nullptr), m_ostream(NULL),
-    m_compression(LasCompression::None), m_srsCnt(0)
+    m_compression(LasCompression::None), m_srsCnt(0), m_octree(false),
+    m_octreeVlrPos(0)
 {}
 
 
@@ -111,6 +116,11 @@ void LasWriter::addArgs(ProgramArgs& args)
     args.add("a_srs", "Spatial reference to use to write output", m_aSrs);
     args.add("compression", "Compression to use for output ('LASZIP' or "
         "'LAZPERF')", m_compression, LasCompression::None);
+    args.add("octree", "Write points in the nodes of an octree, one LAZ "
+        "chunk per node", m_octree);
+    args.add("octree_memory_points", "Number of points held in memory "
+        "while building an octree before points are spooled to disk",
+        m_octreeMemoryPoints, (point_count_t)10000000);
     args.add("discard_high_return_numbers", "Discard points with out-of-spec "
         "return numbers.", m_discardHighReturnNumbers);
     args.add("extra_dims", "Dimensions to write above those in point format",
@@ -152,6 +162,20 @@ void LasWriter::initialize()
 {
     std::string ext = FileUtils::extension(m_filename);
     ext = Utils::tolower(ext);
+    if (m_octree)
+    {
+#ifndef PDAL_HAVE_LAZPERF
+        throwError("Can't write octree output.  PDAL not built with "
+            "LAZperf.");
+#endif
+        if (m_compression == LasCompression::None)
+            m_compression = LasCompression::LazPerf;
+        if (m_compression != LasCompression::LazPerf)
+            throwError("Option 'octree' requires 'lazperf' compression.");
+        if (ext == ".las")
+            throwError("Option 'octree' writes LAZ output, which can't be "
+                "written to '" + m_filename + "'.  Use a '.laz' extension.");
+    }
     if ((ext == ".laz") && (m_compression == LasCompression::None))
     {
 #if defined(PDAL_HAVE_LASZIP)
@@ -349,6 +373,8 @@ void LasWriter::prepOutput(std::ostream *outStream, const SpatialReference& srs)
     {
         LasVLR& vlr = *vi;
         vlr.write(out, m_lasHeader.versionEquals(1, 0) ? 0xAABB : 0);
+        if (vlr.matches(PDAL_USER_ID, PDAL_OCTREE_RECORD_ID))
+            m_octreeVlrPos = m_ostream->tellp() - (std::streamoff)vlr.dataLen();
     }
 
     // Write the point data start signature for version 1.0.
@@ -720,13 +746,30 @@ void LasWriter::readyLazPerfCompression()
     if (m_lasHeader.hasColor())
         schema.push(laszip::factory::record_item::RGB12);
     laszip::io::laz_vlr zipvlr = laszip::io::laz_vlr::from_schema(schema);
+    // Octree nodes are chunks of varying size.
+    if (m_octree)
+        zipvlr.chunk_size = (std::numeric_limits<uint32_t>::max)();
     std::vector<uint8_t> data(zipvlr.size());
     zipvlr.extract((char *)data.data());
     addVlr(LASZIP_USER_ID, LASZIP_RECORD_ID, "http://laszip.org", data);
 
+    // Chunks are compressed on the shared executor.
+    const size_t threads = Executor::global().threads();
     delete m_compressor;
     m_compressor = new LazPerfVlrCompressor(*m_ostream, schema,
-        zipvlr.chunk_size);
+        zipvlr.chunk_size, threads);
+
+    m_octreeBuilder.reset();
+    if (m_octree)
+    {
+        // The VLR is filled in when the octree has been written.
+        std::vector<uint8_t> octreeData(LasOctree::VlrSize);
+        deleteVlr(PDAL_USER_ID, PDAL_OCTREE_RECORD_ID);
+        addVlr(PDAL_USER_ID, PDAL_OCTREE_RECORD_ID, "PDAL octree",
+            octreeData);
+        m_octreeBuilder.reset(new LasOctreeBuilder(m_lasHeader.pointLen(),
+            threads, m_octreeMemoryPoints));
+    }
 #endif
 }
 
@@ -797,7 +840,10 @@ bool LasWriter::processPoint(PointRef& point)
         LeInserter ostream(m_pointBuf.data(), m_pointBuf.size());
         if (!fillPointBuf(point, ostream))
             return false;
-        writeLazPerfBuf(m_pointBuf.data(), m_lasHeader.pointLen(), 1);
+        if (m_octreeBuilder)
+            m_octreeBuilder->add(m_pointBuf.data(), 1);
+        else
+            writeLazPerfBuf(m_pointBuf.data(), m_lasHeader.pointLen(), 1);
     }
     else
     {
@@ -841,16 +887,21 @@ void LasWriter::writeView(const PointViewPtr view)
                     pointLen * view->size()));
 
         const PointView& viewRef(*view.get());
+        const point_count_t blockPoints = m_pointBuf.size() / pointLen;
 
         point_count_t remaining = view->size();
         PointId idx = 0;
         while (remaining)
         {
-            point_count_t filled = fillWriteBuf(viewRef, idx, m_pointBuf);
-            idx += filled;
-            remaining -= filled;
-
-            if (m_compression == LasCompression::LazPerf)
+            point_count_t count = (std::min)(blockPoints, remaining);
+            point_count_t filled =
+                fillWriteBuf(viewRef, idx, count, m_pointBuf);
+            idx += count;
+            remaining -= count;
+
+            if (m_octreeBuilder)
+                m_octreeBuilder->add(m_pointBuf.data(), filled);
+            else if (m_compression == LasCompression::LazPerf)
                 writeLazPerfBuf(m_pointBuf.data(), pointLen, filled);
             else
                 m_ostream->write(m_pointBuf.data(), filled * pointLen);
@@ -1127,21 +1178,89 @@ bool LasWriter::fillPointBuf(PointRef& point, LeInserter& ostream)
 }
 
 
+// Encode 'count' points starting at 'startId' into 'buf' a batch at a time.
+// Returns the number of points written, which is less than 'count' if
+// points with high return numbers are discarded.
 point_count_t LasWriter::fillWriteBuf(const PointView& view,
-    PointId startId, std::vector<char>& buf)
+    PointId startId, point_count_t count, std::vector<char>& buf)
 {
-    point_count_t blocksize = buf.size() / m_lasHeader.pointLen();
-    blocksize = (std::min)(blocksize, view.size() - startId);
-    PointId lastId = startId + blocksize;
+    using namespace Dimension;
 
-    LeInserter ostream(buf.data(), buf.size());
+    const size_t pointLen = m_lasHeader.pointLen();
+    const size_t baseLen = m_lasHeader.basePointLen();
+    const uint8_t maxReturnCount = (uint8_t)m_lasHeader.maxReturnCount();
+
+    auto converter = [this](double d, Dimension::Id dim) -> int32_t
+    {
+        int32_t i(0);
+
+        if (!Utils::numericCast(d, i))
+            throwError("Unable to convert scaled value (" +
+                Utils::toString(d) + ") to "
+                "int32 for dimension '" + Dimension::name(dim) +
+                "' when writing LAS/LAZ file " + m_curFilename + ".");
+        return i;
+    };
+
+    LasCodec::Batch batch;
     PointRef point = (const_cast<PointView&>(view)).point(0);
-    for (PointId idx = startId; idx < lastId; idx++)
+    char *pos = buf.data();
+    point_count_t written = 0;
+    for (point_count_t done = 0; done < count; done += LasCodec::BatchSize)
     {
-        point.setPointId(idx);
-        fillPointBuf(point, ostream);
+        const point_count_t n = (std::min)(LasCodec::BatchSize, count - done);
+        const PointId id = startId + done;
+        LasCodec::fetch(m_lasHeader, view, id, n, batch);
+
+        std::vector<bool> keep(n, true);
+        for (point_count_t i = 0; i < n; ++i)
+        {
+            if (batch.numberOfReturns[i] > maxReturnCount &&
+                m_discardHighReturnNumbers)
+            {
+                // If this return number is too high, pitch the point.
+                if (batch.returnNumber[i] > maxReturnCount)
+                    keep[i] = false;
+                batch.numberOfReturns[i] = maxReturnCount;
+            }
+            batch.xi[i] = converter(m_scaling.m_xXform.toScaled(batch.x[i]),
+                Id::X);
+            batch.yi[i] = converter(m_scaling.m_yXform.toScaled(batch.y[i]),
+                Id::Y);
+            batch.zi[i] = converter(m_scaling.m_zXform.toScaled(batch.z[i]),
+                Id::Z);
+        }
+        LasCodec::encode(m_lasHeader, batch, n, pos, pointLen);
+
+        // Drop discarded points, write extra dimensions and update the
+        // summary for the rest.
+        char *out = pos;
+        for (point_count_t i = 0; i < n; ++i, pos += pointLen)
+        {
+            if (!keep[i])
+                continue;
+            if (out != pos)
+                std::memmove(out, pos, baseLen);
+            if (m_extraDims.size())
+            {
+                point.setPointId(id + i);
+                LeInserter ostream(out + baseLen, pointLen - baseLen);
+                Everything e;
+                for (auto& dim : m_extraDims)
+                {
+                    point.getField((char *)&e, dim.m_dimType.m_id,
+                        dim.m_dimType.m_type);
+                    Utils::insertDim(ostream, dim.m_dimType.m_type, e);
+                }
+            }
+            m_summaryData->addPoint(batch.x[i], batch.y[i], batch.z[i],
+                batch.returnNumber[i]);
+            out += pointLen;
+            written++;
+        }
+        pos = out;
     }
-    return blocksize;
+    return written;
 }
 
 
@@ -1216,7 +1335,63 @@ void LasWriter::finishLasZipOutput()
 void LasWriter::finishLazPerfOutput()
 {
 #ifdef PDAL_HAVE_LAZPERF
+    if (m_octreeBuilder)
+        finishOctreeOutput();
+    else
+        m_compressor->done();
+#endif
+}
+
+
+// Build the octree and write each node as a chunk.  The hierarchy is
+// written after the chunk table and the octree VLR is filled in to point
+// at it.
+void LasWriter::finishOctreeOutput()
+{
+#ifdef PDAL_HAVE_LAZPERF
+    const size_t pointLen = m_lasHeader.pointLen();
+
+    LasOctree::NodeList nodes;
+    BOX3D cube = m_octreeBuilder->build(
+        [this, pointLen, &nodes](const Key& key, char *buf,
+            point_count_t count)
+        {
+            writeLazPerfBuf(buf, pointLen, count);
+            m_compressor->endChunk();
+            nodes.push_back({ key, 0, 0, (uint32_t)count });
+        });
+    m_octreeBuilder.reset();
     m_compressor->done();
+
+    // Chunks follow the chunk table position at the start of the points.
+    const std::vector<uint32_t>& sizes = m_compressor->chunkSizes();
+    if (sizes.size() != nodes.size())
+        throwError("Octree nodes don't match the chunks written.");
+    uint64_t offset = m_lasHeader.pointOffset() + sizeof(uint64_t);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        nodes[i].m_offset = offset;
+        nodes[i].m_size = sizes[i];
+        offset += sizes[i];
+    }
+
+    auto unscale = [](const XForm& xform, double d)
+        { return d * xform.m_scale.m_val + xform.m_offset.m_val; };
+    LasOctree octree(BOX3D(
+        unscale(m_scaling.m_xXform, cube.minx),
+        unscale(m_scaling.m_yXform, cube.miny),
+        unscale(m_scaling.m_zXform, cube.minz),
+        unscale(m_scaling.m_xXform, cube.maxx),
+        unscale(m_scaling.m_yXform, cube.maxy),
+        unscale(m_scaling.m_zXform, cube.maxz)));
+    octree.nodes() = std::move(nodes);
+    octree.writeHierarchy(*m_ostream);
+
+    std::streampos end = m_ostream->tellp();
+    std::vector<uint8_t> data = octree.vlrData();
+    m_ostream->seekp(m_octreeVlrPos);
+    m_ostream->write((const char *)data.data(), data.size());
+    m_ostream->seekp(end);
 #endif
 }
 
@@ -57,6 +57,7 @@ class LasTester;
 class NitfWriter;
 class GeotiffSupport;
 class LazPerfVlrCompressor;
+class LasOctreeBuilder;
 
 struct VlrOptionInfo
 {
@@ -129,6 +130,13 @@ private:
     bool m_writePDALMetadata;
     std::vector<ExtLasVLR> m_userVLRs;
     bool m_firstPoint;
+    // Points are sorted into the nodes of an octree and each node is
+    // written as a LAZ chunk.  m_octreeVlrPos is the file position of the
+    // data of the octree VLR, which is filled in when the file is done.
+    bool m_octree;
+    point_count_t m_octreeMemoryPoints;
+    std::unique_ptr<LasOctreeBuilder> m_octreeBuilder;
+    std::streampos m_octreeVlrPos;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void initialize();
@@ -154,7 +162,7 @@ private:
     void fillHeader();
     bool fillPointBuf(PointRef& point, LeInserter& ostream);
     point_count_t fillWriteBuf(const PointView& view, PointId startId,
-        std::vector<char>& buf);
+        point_count_t count, std::vector<char>& buf);
     bool writeLasZipBuf(PointRef& point);
     void writeLazPerfBuf(char *data, size_t pointLen, point_count_t numPts);
     void addForwardVlrs();
@@ -176,6 +184,7 @@ private:
     bool addWktVlr();
     void finishLasZipOutput();
     void finishLazPerfOutput();
+    void finishOctreeOutput();
     bool processPoint(PointRef& point);
 
     LasWriter& operator=(const LasWriter&); // not implemented
@@ -0,0 +1,499 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "MultiReader.hpp"
+
+#include <algorithm>
+
+#include <filters/StreamCallbackFilter.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/private/ThreadPool.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+
+namespace pdal
+{
+
+static StaticPluginInfo const s_info
+{
+    "readers.multi",
+    "Read several files concurrently as one input.",
+    "http://pdal.io/stages/readers.multi.html",
+    {}
+};
+
+CREATE_STATIC_STAGE(MultiReader, s_info)
+
+std::string MultiReader::getName() const { return s_info.name; }
+
+namespace
+{
+
+// Thrown to end the streaming of a file when the consumer has stopped.
+struct StreamStopped
+{};
+
+} // unnamed namespace
+
+
+MultiReader::MultiReader() : m_merge(false), m_threads(4), m_chunkPoints(0),
+    m_pointSize(0), m_chunkPos(0), m_filesLeft(0), m_stop(false), m_index(0)
+{}
+
+
+MultiReader::~MultiReader()
+{
+    stopStream();
+}
+
+
+void MultiReader::addArgs(ProgramArgs& args)
+{
+    args.add("filenames", "Files to read.  Names may be glob patterns.",
+        m_filespecs);
+    args.add("merge", "Read all files into a single point view", m_merge);
+    args.add("threads", "Maximum number of files read at once", m_threads,
+        (size_t)4);
+    args.add("chunk_size", "Number of points passed at a time from each "
+        "file in stream mode", m_chunkPoints, (point_count_t)10000);
+}
+
+
+// Expand the file patterns into the list of files to read, in sorted order
+// for each pattern.  Names that match nothing, such as remote files, are
+// passed to their readers as given.
+void MultiReader::expandFiles()
+{
+    StringList specs(m_filespecs);
+    if (m_filename.size())
+        specs.insert(specs.begin(), m_filename);
+    if (specs.empty())
+        throwError("No files to read.  Set 'filenames'.");
+
+    m_files.clear();
+    for (const std::string& spec : specs)
+    {
+        StringList names = FileUtils::glob(spec);
+        std::sort(names.begin(), names.end());
+        if (names.empty() && spec.find_first_of("*?[") == std::string::npos)
+            names.push_back(spec);
+        for (const std::string& name : names)
+        {
+            File file;
+            file.m_filename = name;
+            file.m_driver = m_factory.inferReaderDriver(name);
+            if (file.m_driver.empty())
+                throwError("Unable to infer reader for file '" + name + "'.");
+            m_files.push_back(file);
+        }
+    }
+    if (m_files.empty())
+        throwError("No files match 'filenames'.");
+    m_threads = (std::max)(m_threads, (size_t)1);
+    m_chunkPoints = (std::max)(m_chunkPoints, (point_count_t)1);
+}
+
+
+Stage& MultiReader::createReader(const File& file)
+{
+    Stage *reader = m_factory.createStage(file.m_driver);
+    if (!reader)
+        throwError("Unable to create reader '" + file.m_driver +
+            "' for file '" + file.m_filename + "'.");
+    Options opts;
+    opts.add("filename", file.m_filename);
+    reader->setOptions(opts);
+    return *reader;
+}
+
+
+// Prepare a reader for each file to find its dimensions.  Only the file
+// headers are read, several files at a time.
+void MultiReader::initialize()
+{
+    expandFiles();
+
+    ThreadPool pool(m_threads, m_files.size());
+    for (File& file : m_files)
+        pool.add([this, &file]()
+        {
+            Stage& reader = createReader(file);
+            PointTable table;
+            reader.prepare(table);
+            PointLayoutPtr layout = table.layout();
+            for (Dimension::Id id : layout->dims())
+                file.m_dims.push_back({ layout->dimName(id),
+                    layout->dimType(id) });
+            file.m_srs = reader.getSpatialReference();
+            m_factory.destroyStage(&reader);
+        });
+    pool.await();
+    if (pool.errors().size())
+        throwError(pool.errors().front());
+
+    // Points from all files take on the spatial reference of the first
+    // file that has one.
+    SpatialReference srs;
+    for (const File& file : m_files)
+    {
+        if (file.m_srs.empty())
+            continue;
+        if (srs.empty())
+            srs = file.m_srs;
+        else if (file.m_srs != srs)
+            log()->get(LogLevel::Warning) << "Spatial reference of file '" <<
+                file.m_filename << "' differs from that of the first file "
+                "and is ignored." << std::endl;
+    }
+    if (!srs.empty())
+        setSpatialReference(srs);
+    log()->get(LogLevel::Debug) << "Reading " << m_files.size() <<
+        " files." << std::endl;
+}
+
+
+// Summarize the files from their headers, several files at a time.
+QuickInfo MultiReader::inspect()
+{
+    expandFiles();
+
+    std::vector<QuickInfo> infos(m_files.size());
+    ThreadPool pool(m_threads, m_files.size());
+    for (size_t i = 0; i < m_files.size(); ++i)
+        pool.add([this, &infos, i]()
+        {
+            Stage& reader = createReader(m_files[i]);
+            infos[i] = reader.preview();
+            m_factory.destroyStage(&reader);
+        });
+    pool.await();
+    if (pool.errors().size())
+        throwError(pool.errors().front());
+
+    QuickInfo qi;
+    for (const QuickInfo& info : infos)
+    {
+        if (!info.valid())
+            continue;
+        qi.m_bounds.grow(info.m_bounds);
+        qi.m_pointCount += info.m_pointCount;
+        for (const std::string& name : info.m_dimNames)
+            if (std::find(qi.m_dimNames.begin(), qi.m_dimNames.end(), name) ==
+                    qi.m_dimNames.end())
+                qi.m_dimNames.push_back(name);
+        if (qi.m_srs.empty())
+            qi.m_srs = info.m_srs;
+        qi.m_valid = true;
+    }
+    return qi;
+}
+
+
+void MultiReader::addDimensions(PointLayoutPtr layout)
+{
+    for (const File& file : m_files)
+        for (auto& dim : file.m_dims)
+            if (dimUsed(dim.first))
+                layout->registerOrAssignDim(dim.first, dim.second);
+}
+
+
+void MultiReader::ready(PointTableRef table)
+{
+    PointLayoutPtr layout = table.layout();
+
+    m_dims.clear();
+    m_pointSize = 0;
+    for (Dimension::Id id : layout->dims())
+    {
+        Dim dim { layout->dimName(id), id, layout->dimType(id), m_pointSize };
+        m_pointSize += Dimension::size(dim.m_type);
+        m_dims.push_back(dim);
+    }
+
+    stopStream();
+    m_index = 0;
+}
+
+
+// Find the dimensions of a file's layout that correspond to the output
+// dimensions.  Those that the file doesn't have are Unknown.
+Dimension::IdList MultiReader::mapDims(const PointLayout& layout) const
+{
+    Dimension::IdList ids;
+    for (const Dim& dim : m_dims)
+        ids.push_back(layout.findDim(dim.m_name));
+    return ids;
+}
+
+
+void MultiReader::pack(PointRef& point, const Dimension::IdList& srcDims,
+    char *buf) const
+{
+    for (size_t i = 0; i < m_dims.size(); ++i)
+    {
+        const Dim& dim = m_dims[i];
+        if (srcDims[i] == Dimension::Id::Unknown)
+            std::fill(buf + dim.m_offset,
+                buf + dim.m_offset + Dimension::size(dim.m_type), 0);
+        else
+            point.getField(buf + dim.m_offset, srcDims[i], dim.m_type);
+    }
+}
+
+
+void MultiReader::unpack(PointRef& point, const char *buf) const
+{
+    for (const Dim& dim : m_dims)
+        point.setField(dim.m_id, dim.m_type, buf + dim.m_offset);
+}
+
+
+// Read several files at a time, each into its own table, and copy the points
+// into a view per file.  Points are only copied to the shared table under
+// the lock, so decoding proceeds in parallel.
+PointViewSet MultiReader::run(PointViewPtr view)
+{
+    std::vector<PointViewPtr> views;
+    for (size_t i = 0; i < m_files.size(); ++i)
+        views.push_back(view->makeNew());
+
+    std::mutex mutex;
+    ThreadPool pool(m_threads, m_files.size());
+    for (size_t i = 0; i < m_files.size(); ++i)
+        pool.add([this, &views, &mutex, i]()
+        {
+            const File& file = m_files[i];
+            Stage& reader = createReader(file);
+            PointTable table;
+            reader.prepare(table);
+            PointViewSet set = reader.execute(table);
+
+            const Dimension::IdList srcDims = mapDims(*table.layout());
+            point_count_t count = 0;
+            for (const PointViewPtr& v : set)
+                count += v->size();
+            std::vector<char> buf(count * m_pointSize);
+            char *pos = buf.data();
+            for (const PointViewPtr& v : set)
+            {
+                PointRef point(*v, 0);
+                for (PointId idx = 0; idx < v->size(); ++idx)
+                {
+                    point.setPointId(idx);
+                    pack(point, srcDims, pos);
+                    pos += m_pointSize;
+                }
+            }
+            m_factory.destroyStage(&reader);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            PointRef point(*views[i], 0);
+            pos = buf.data();
+            for (PointId idx = 0; idx < count; ++idx)
+            {
+                point.setPointId(idx);
+                unpack(point, pos);
+                pos += m_pointSize;
+            }
+        });
+    pool.await();
+    if (pool.errors().size())
+        throwError(pool.errors().front());
+
+    // Assemble the output in file order, limited to 'count' points.
+    PointViewSet viewSet;
+    point_count_t remaining = m_count;
+    for (PointViewPtr& v : views)
+    {
+        if (v->size() > remaining)
+        {
+            PointViewPtr trimmed = v->makeNew();
+            for (PointId idx = 0; idx < remaining; ++idx)
+                trimmed->appendPoint(*v, idx);
+            v = trimmed;
+        }
+        remaining -= v->size();
+        if (m_merge)
+            view->append(*v);
+        else
+            viewSet.insert(v);
+    }
+    if (m_merge)
+        viewSet.insert(view);
+    return viewSet;
+}
+
+
+// In stream mode each file is streamed through its reader on a pool
+// thread.  Points are packed into chunks and queued, so chunks from the
+// files being read are interleaved in the order they become available.
+void MultiReader::startStream()
+{
+    m_ready.clear();
+    m_chunk.clear();
+    m_chunkPos = 0;
+    m_filesLeft = m_files.size();
+    m_stop = false;
+    m_error.clear();
+
+    m_pool.reset(new ThreadPool(m_threads, m_files.size()));
+    for (const File& file : m_files)
+        m_pool->add([this, &file]()
+        {
+            try
+            {
+                streamFile(file);
+            }
+            catch (const StreamStopped&)
+            {}
+            catch (const std::exception& err)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_error.empty())
+                    m_error = err.what();
+                m_stop = true;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filesLeft--;
+            m_cv.notify_all();
+        });
+}
+
+
+void MultiReader::streamFile(const File& file)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop)
+            return;
+    }
+
+    Stage& reader = createReader(file);
+    StreamCallbackFilter f;
+    f.setInput(reader);
+
+    Dimension::IdList srcDims;
+    std::vector<char> chunk;
+    f.setCallback([this, &srcDims, &chunk](PointRef& point)
+    {
+        chunk.resize(chunk.size() + m_pointSize);
+        pack(point, srcDims, chunk.data() + chunk.size() - m_pointSize);
+        if (chunk.size() == m_chunkPoints * m_pointSize)
+            pushChunk(chunk);
+        return true;
+    });
+
+    FixedPointTable table(m_chunkPoints);
+    f.prepare(table);
+    srcDims = mapDims(*table.layout());
+    chunk.reserve(m_chunkPoints * m_pointSize);
+    f.execute(table);
+    if (chunk.size())
+        pushChunk(chunk);
+    m_factory.destroyStage(&reader);
+}
+
+
+// Queue a chunk for the consumer, waiting if too many are queued.
+void MultiReader::pushChunk(std::vector<char>& chunk)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]()
+        { return m_stop || m_ready.size() < 2 * m_threads; });
+    if (m_stop)
+        throw StreamStopped();
+    m_ready.push_back(std::move(chunk));
+    chunk.clear();
+    chunk.reserve(m_chunkPoints * m_pointSize);
+    m_cv.notify_all();
+}
+
+
+// Take the next queued chunk, waiting for one if necessary.  Return false
+// once all files have been read.
+bool MultiReader::nextChunk()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]()
+        { return m_ready.size() || !m_filesLeft || m_error.size(); });
+    if (m_error.size())
+        throwError(m_error);
+    if (m_ready.empty())
+        return false;
+    m_chunk = std::move(m_ready.front());
+    m_ready.pop_front();
+    m_chunkPos = 0;
+    m_cv.notify_all();
+    return true;
+}
+
+
+void MultiReader::stopStream()
+{
+    if (!m_pool)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_pool->join();
+    m_pool.reset();
+}
+
+
+bool MultiReader::processOne(PointRef& point)
+{
+    if (m_index >= m_count)
+        return false;
+    if (!m_pool)
+        startStream();
+    if (m_chunkPos == m_chunk.size() && !nextChunk())
+        return false;
+
+    unpack(point, m_chunk.data() + m_chunkPos);
+    m_chunkPos += m_pointSize;
+    m_index++;
+    return true;
+}
+
+
+void MultiReader::done(PointTableRef)
+{
+    stopStream();
+}
+
+} // namespace pdal
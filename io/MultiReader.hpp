@@ -0,0 +1,129 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <pdal/Reader.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/Streamable.hpp>
+
+namespace pdal
+{
+
+class ThreadPool;
+
+// Reads a list of files, named directly or by glob patterns, as a single
+// stage.  Several files are read at once, each with the reader inferred
+// from its name.
+class PDAL_DLL MultiReader : public Reader, public Streamable
+{
+    // Dimension in the output layout.  Points are packed with these
+    // dimensions at these offsets when moved between tables.
+    struct Dim
+    {
+        std::string m_name;
+        Dimension::Id m_id;
+        Dimension::Type m_type;
+        size_t m_offset;
+    };
+
+    struct File
+    {
+        std::string m_filename;
+        std::string m_driver;
+        std::vector<std::pair<std::string, Dimension::Type>> m_dims;
+        SpatialReference m_srs;
+    };
+
+public:
+    MultiReader();
+    virtual ~MultiReader();
+
+    std::string getName() const override;
+
+private:
+    virtual void addArgs(ProgramArgs& args) override;
+    virtual void initialize() override;
+    virtual QuickInfo inspect() override;
+    virtual void addDimensions(PointLayoutPtr layout) override;
+    virtual void ready(PointTableRef table) override;
+    virtual PointViewSet run(PointViewPtr view) override;
+    virtual bool processOne(PointRef& point) override;
+    virtual void done(PointTableRef table) override;
+
+    void expandFiles();
+    Stage& createReader(const File& file);
+    Dimension::IdList mapDims(const PointLayout& layout) const;
+    void pack(PointRef& point, const Dimension::IdList& srcDims,
+        char *buf) const;
+    void unpack(PointRef& point, const char *buf) const;
+
+    // Streaming
+    void startStream();
+    void streamFile(const File& file);
+    void pushChunk(std::vector<char>& chunk);
+    bool nextChunk();
+    void stopStream();
+
+    StringList m_filespecs;
+    bool m_merge;
+    size_t m_threads;
+    point_count_t m_chunkPoints;
+
+    std::vector<File> m_files;
+    std::vector<Dim> m_dims;
+    size_t m_pointSize;
+    StageFactory m_factory;
+
+    // The below are for streaming operation only.
+    std::unique_ptr<ThreadPool> m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::vector<char>> m_ready;
+    std::vector<char> m_chunk;
+    size_t m_chunkPos;
+    size_t m_filesLeft;
+    bool m_stop;
+    std::string m_error;
+    point_count_t m_index;
+};
+
+} // namespace pdal
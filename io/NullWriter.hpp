@@ -44,6 +44,8 @@ class PDAL_DLL NullWriter : public Writer
 public:
     std::string getName() const;
 private:
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
     virtual void write(const PointViewPtr /*view*/)
         {}
 };
@@ -40,7 +40,9 @@
 #include <pdal/util/Algorithm.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace pdal
 {
@@ -204,6 +206,7 @@ void TextWriter::ready(PointTableRef table)
                 m_dims.push_back(ds);
         }
     }
+    m_values.resize(m_dims.size());
 
     if (!m_writeHeader)
         log()->get(LogLevel::Debug) << "Not writing header" << std::endl;
@@ -263,18 +266,41 @@ void TextWriter::writeCSVHeader(PointTableRef table)
 
 
 void TextWriter::processOneCSV(PointRef& point)
+{
+    for (size_t i = 0; i < m_dims.size(); ++i)
+        m_values[i] = point.getFieldAs<double>(m_dims[i].id);
+    writeCSV(m_values.data());
+}
+
+
+// Write a CSV record.  'values' holds the value of each output dimension.
+void TextWriter::writeCSV(const double *values)
 {
     for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
     {
         if (di != m_dims.begin())
             *m_stream << m_delimiter;
         m_stream->precision(di->precision);
-        *m_stream << point.getFieldAs<double>(di->id);
+        *m_stream << *values++;
     }
     *m_stream << m_newline;
 }
 
+
 void TextWriter::processOneGeoJSON(PointRef& point)
+{
+    for (size_t i = 0; i < m_dims.size(); ++i)
+        m_values[i] = point.getFieldAs<double>(m_dims[i].id);
+    writeGeoJSON(point.getFieldAs<double>(Dimension::Id::X),
+        point.getFieldAs<double>(Dimension::Id::Y),
+        point.getFieldAs<double>(Dimension::Id::Z), m_values.data());
+}
+
+
+// Write a GeoJSON feature.  'values' holds the value of each output
+// dimension.
+void TextWriter::writeGeoJSON(double x, double y, double z,
+    const double *values)
 {
     if (m_idx)
         *m_stream << ",";
@@ -282,11 +308,11 @@ void TextWriter::processOneGeoJSON(PointRef& point)
         "{ \"type\": \"Point\", \"coordinates\": [";
 
     m_stream->precision(m_xDim.precision);
-    *m_stream << point.getFieldAs<double>(Dimension::Id::X) << ",";
+    *m_stream << x << ",";
     m_stream->precision(m_yDim.precision);
-    *m_stream << point.getFieldAs<double>(Dimension::Id::Y) << ",";
+    *m_stream << y << ",";
     m_stream->precision(m_zDim.precision);
-    *m_stream << point.getFieldAs<double>(Dimension::Id::Z) << "]},";
+    *m_stream << z << "]},";
 
     *m_stream << "\"properties\": {";
 
@@ -298,7 +324,7 @@ void TextWriter::processOneGeoJSON(PointRef& point)
         *m_stream << "\"" << di->name << "\":";
         *m_stream << "\"";
         m_stream->precision(di->precision);
-        *m_stream << point.getFieldAs<double>(di->id);
+        *m_stream << *values++;
         *m_stream <<"\"";
     }
     *m_stream << "}"; // end properties
@@ -319,20 +345,43 @@ bool TextWriter::processOne(PointRef& point)
 
 void TextWriter::write(const PointViewPtr view)
 {
-    PointRef point(*view, 0);
+    // Fetch each dimension a block of points at a time and then write
+    // the records for the block.
+    const point_count_t blockSize = 4096;
+    const size_t numDims = m_dims.size();
+    std::vector<double> values(numDims * blockSize);
+    std::vector<double> x, y, z;
+    if (m_outputType == OutputType::GEOJSON)
+    {
+        x.resize(blockSize);
+        y.resize(blockSize);
+        z.resize(blockSize);
+    }
 
-    if (m_outputType == OutputType::CSV)
-        for (PointId idx = 0; idx < view->size(); ++idx)
+    for (PointId start = 0; start < view->size(); start += blockSize)
+    {
+        point_count_t count = (std::min)(blockSize, view->size() - start);
+        for (size_t d = 0; d < numDims; ++d)
+            view->getFieldArray(m_dims[d].id, start, count,
+                values.data() + d * blockSize);
+
+        if (m_outputType == OutputType::GEOJSON)
         {
-            point.setPointId(idx);
-            processOneCSV(point);
+            view->getFieldArray(Dimension::Id::X, start, count, x.data());
+            view->getFieldArray(Dimension::Id::Y, start, count, y.data());
+            view->getFieldArray(Dimension::Id::Z, start, count, z.data());
         }
-    else if (m_outputType == OutputType::GEOJSON)
-        for (PointId idx = 0; idx < view->size(); ++idx)
+
+        for (point_count_t i = 0; i < count; ++i)
         {
-            point.setPointId(idx);
-            processOneGeoJSON(point);
+            for (size_t d = 0; d < numDims; ++d)
+                m_values[d] = values[d * blockSize + i];
+            if (m_outputType == OutputType::CSV)
+                writeCSV(m_values.data());
+            else if (m_outputType == OutputType::GEOJSON)
+                writeGeoJSON(x[i], y[i], z[i], m_values.data());
         }
+    }
 }
 
 
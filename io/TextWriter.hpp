@@ -81,6 +81,8 @@ private:
     void writeCSVHeader(PointTableRef table);
     void processOneCSV(PointRef& point);
     void processOneGeoJSON(PointRef& point);
+    void writeCSV(const double *values);
+    void writeGeoJSON(double x, double y, double z, const double *values);
 
     DimSpec extractDim(std::string dim, PointTableRef table);
     bool findDim(Dimension::Id id, DimSpec& ds);
@@ -100,6 +102,7 @@ private:
 
     FileStreamPtr m_stream;
     std::vector<DimSpec> m_dims;
+    std::vector<double> m_values;
     DimSpec m_xDim;
     DimSpec m_yDim;
     DimSpec m_zDim;
@@ -0,0 +1,324 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "EptCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <list>
+#include <map>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#ifndef S_ISREG
+#define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
+#endif
+
+#include <pdal/util/FileUtils.hpp>
+
+#include "EptSupport.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+// Text resources of all caches of a process, most recently used first.
+class MemoryTier
+{
+public:
+    MemoryTier() : m_bytes(0)
+    {}
+
+    bool get(const std::string& id, std::string& text)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(id);
+        if (it == m_index.end())
+            return false;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        text = it->second->second;
+        return true;
+    }
+
+    void put(const std::string& id, const std::string& text)
+    {
+        if (text.size() > EptCache::MemoryBytes)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_index.count(id))
+            return;
+        m_entries.emplace_front(id, text);
+        m_index[id] = m_entries.begin();
+        m_bytes += text.size();
+        while (m_bytes > EptCache::MemoryBytes)
+        {
+            auto& last = m_entries.back();
+            m_bytes -= last.second.size();
+            m_index.erase(last.first);
+            m_entries.pop_back();
+        }
+    }
+
+private:
+    using Entry = std::pair<std::string, std::string>;
+
+    std::mutex m_mutex;
+    std::list<Entry> m_entries;
+    std::map<std::string, std::list<Entry>::iterator> m_index;
+    size_t m_bytes;
+};
+
+MemoryTier& memoryTier()
+{
+    static MemoryTier tier;
+    return tier;
+}
+
+// 64-bit FNV-1a hash, started from 'h'.  Unlike std::hash, stable across
+// processes.
+uint64_t hash(const std::string& s, uint64_t h)
+{
+    for (unsigned char c : s)
+    {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Mark a file as recently used.
+void touch(const std::string& filename)
+{
+#ifdef _WIN32
+    _utime(filename.c_str(), nullptr);
+#else
+    utime(filename.c_str(), nullptr);
+#endif
+}
+
+} // unnamed namespace
+
+
+EptCache::EptCache(const std::string& dir, uint64_t maxBytes) :
+    m_dir(dir), m_maxBytes(maxBytes), m_bytes(0),
+    m_random((uint64_t)std::chrono::system_clock::now().
+        time_since_epoch().count() ^ std::random_device()())
+{
+    if (!FileUtils::directoryExists(m_dir) &&
+            !FileUtils::createDirectories(m_dir))
+        throw ept_error("Unable to create cache directory '" + m_dir + "'.");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evict();
+}
+
+
+// Files are named by two hashes of the ID with different starting values,
+// so that names of different IDs are very unlikely to be the same.
+std::string EptCache::filename(const std::string& id) const
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string name;
+    for (uint64_t h : { hash(id, 14695981039346656037ULL),
+            hash(id, 0x6c62272e07bb0142ULL) })
+        for (int i = 0; i < 16; ++i)
+        {
+            name.push_back(digits[h & 0xf]);
+            h >>= 4;
+        }
+    return m_dir + "/" + name + FileUtils::extension(id);
+}
+
+
+// Read a cache file.  Returns false if the file isn't in the cache.
+bool EptCache::read(const std::string& filename, std::vector<char>& data)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return false;
+    data.assign(std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>());
+    if (in.bad())
+        return false;
+    touch(filename);
+    return true;
+}
+
+
+// Write a cache file.  Failure to write only means that the resource will
+// be fetched again next time.
+void EptCache::store(const std::string& filename, const char *data,
+    size_t size)
+{
+    std::string temp;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        temp = filename + "." + std::to_string(m_random()) + ".tmp";
+    }
+
+    {
+        std::ofstream out(temp, std::ios::binary);
+        out.write(data, size);
+        if (!out)
+        {
+            out.close();
+            FileUtils::deleteFile(temp);
+            return;
+        }
+    }
+    try
+    {
+        FileUtils::renameFile(filename, temp);
+    }
+    catch (const std::exception&)
+    {
+        FileUtils::deleteFile(temp);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bytes += size;
+    if (m_bytes > m_maxBytes)
+        evict();
+}
+
+
+// Remove the least recently used files until the files are well within the
+// budget.  Recently used files may be about to be read, by this or another
+// process, so are kept.  Other processes may be removing files as well, so
+// failures are ignored.  Must be called with the lock held.
+void EptCache::evict()
+{
+    struct Entry
+    {
+        std::string m_filename;
+        time_t m_time;
+        uint64_t m_size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    for (const std::string& filename : FileUtils::directoryList(m_dir))
+    {
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        entries.push_back({ filename, st.st_mtime, (uint64_t)st.st_size });
+        total += st.st_size;
+    }
+
+    if (total > m_maxBytes)
+    {
+        std::sort(entries.begin(), entries.end(),
+            [](const Entry& e1, const Entry& e2)
+            { return e1.m_time < e2.m_time; });
+
+        const time_t now = time(nullptr);
+        const uint64_t target = m_maxBytes - m_maxBytes / 10;
+        for (const Entry& e : entries)
+        {
+            if (total <= target)
+                break;
+            if (now - e.m_time < MinAge)
+                break;
+            FileUtils::deleteFile(e.m_filename);
+            total -= e.m_size;
+        }
+    }
+    m_bytes = total;
+}
+
+
+std::string EptCache::get(const std::string& id, const TextFetch& fetch)
+{
+    std::string text;
+    if (memoryTier().get(id, text))
+        return text;
+
+    const std::string name = filename(id);
+    std::vector<char> data;
+    if (read(name, data))
+        text.assign(data.begin(), data.end());
+    else
+    {
+        text = fetch();
+        store(name, text.data(), text.size());
+    }
+    memoryTier().put(id, text);
+    return text;
+}
+
+
+std::vector<char> EptCache::getBinary(const std::string& id,
+    const BinaryFetch& fetch)
+{
+    const std::string name = filename(id);
+    std::vector<char> data;
+    if (!read(name, data))
+    {
+        data = fetch();
+        store(name, data.data(), data.size());
+    }
+    return data;
+}
+
+
+std::string EptCache::localPath(const std::string& id,
+    const BinaryFetch& fetch)
+{
+    const std::string name = filename(id);
+    if (FileUtils::fileExists(name))
+        touch(name);
+    else
+    {
+        std::vector<char> data = fetch();
+        store(name, data.data(), data.size());
+        if (!FileUtils::fileExists(name))
+            throw ept_error("Unable to write cache file '" + name + "'.");
+    }
+    return name;
+}
+
+} // namespace pdal
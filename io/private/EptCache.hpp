@@ -0,0 +1,99 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// Local cache of EPT resources.  Resources are stored as files in a
+// directory, named by a 128-bit hash of an ID made from the endpoint and
+// path of the resource.  The ID isn't stored in the file, since files from
+// localPath() are read as-is by other readers, so IDs with the same hash
+// would share a file.  With 128 bits, that's very unlikely.  When the
+// files exceed a size budget, the least recently used are removed.  Files
+// are written under temporary names and renamed into place, so several
+// processes may share a directory.  Files used in the last minute may be
+// open and aren't removed, so the files can briefly exceed the budget.
+// Text resources, such as hierarchy JSON, are also kept in a memory tier
+// shared by the caches of a process.
+class PDAL_DLL EptCache
+{
+public:
+    using TextFetch = std::function<std::string()>;
+    using BinaryFetch = std::function<std::vector<char>()>;
+
+    // Bytes of text kept in the memory tier.
+    static const size_t MemoryBytes = 64 * 1024 * 1024;
+    // Seconds after its last use that a file may be removed.
+    static const int MinAge = 60;
+
+    EptCache(const std::string& dir, uint64_t maxBytes);
+
+    // Get a text resource from the cache, fetching and storing it if
+    // it's missing.
+    std::string get(const std::string& id, const TextFetch& fetch);
+
+    // Get a binary resource from the cache, fetching and storing it if
+    // it's missing.
+    std::vector<char> getBinary(const std::string& id,
+        const BinaryFetch& fetch);
+
+    // Get the name of the cache file of a resource, fetching and storing
+    // the resource if it's missing.
+    std::string localPath(const std::string& id, const BinaryFetch& fetch);
+
+private:
+    std::string filename(const std::string& id) const;
+    bool read(const std::string& filename, std::vector<char>& data);
+    void store(const std::string& filename, const char *data, size_t size);
+    void evict();
+
+    std::string m_dir;
+    uint64_t m_maxBytes;
+    std::mutex m_mutex;
+    uint64_t m_bytes;  // Approximate size of the files in the directory.
+    std::mt19937_64 m_random;
+};
+
+} // namespace pdal
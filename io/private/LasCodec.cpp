@@ -0,0 +1,401 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasCodec.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include <pdal/PointView.hpp>
+#include <pdal/util/portable_endian.hpp>
+
+#include "../LasHeader.hpp"
+
+namespace pdal
+{
+namespace LasCodec
+{
+
+namespace
+{
+
+// Fields present in each point format.  Waveform formats aren't supported
+// for reading or writing, so don't need their own layouts.
+template<int Format>
+struct Traits
+{
+    static const bool V14 = (Format > 5);
+    static const bool Time = (Format == 1 || Format >= 3);
+    static const bool Color = (Format == 2 || Format == 3 || Format == 7 ||
+        Format == 8);
+    static const bool Infrared = (Format == 8);
+    static const size_t TimePos = V14 ? 22 : 20;
+    static const size_t ColorPos = V14 ? 30 : (Time ? 28 : 20);
+    static const size_t InfraredPos = 36;
+};
+
+inline uint8_t toHost(uint8_t v)
+    { return v; }
+inline uint16_t toHost(uint16_t v)
+    { return le16toh(v); }
+inline uint32_t toHost(uint32_t v)
+    { return le32toh(v); }
+inline uint64_t toHost(uint64_t v)
+    { return le64toh(v); }
+
+inline uint8_t toLe(uint8_t v)
+    { return v; }
+inline uint16_t toLe(uint16_t v)
+    { return htole16(v); }
+inline uint32_t toLe(uint32_t v)
+    { return htole32(v); }
+inline uint64_t toLe(uint64_t v)
+    { return htole64(v); }
+
+// Read a little-endian value of type T, stored as the unsigned type U of
+// the same size.
+template<typename T, typename U>
+inline T load(const char *p)
+{
+    U u;
+    std::memcpy(&u, p, sizeof(U));
+    u = toHost(u);
+    T t;
+    std::memcpy(&t, &u, sizeof(T));
+    return t;
+}
+
+template<typename T, typename U>
+inline void save(char *p, T t)
+{
+    U u;
+    std::memcpy(&u, &t, sizeof(U));
+    u = toLe(u);
+    std::memcpy(p, &u, sizeof(U));
+}
+
+template<int Format>
+void decodeFormat(const LasHeader& h, const char *buf, size_t stride,
+    point_count_t count, Batch& b)
+{
+    typedef Traits<Format> F;
+
+    for (point_count_t i = 0; i < count; ++i, buf += stride)
+    {
+        b.xi[i] = load<int32_t, uint32_t>(buf);
+        b.yi[i] = load<int32_t, uint32_t>(buf + 4);
+        b.zi[i] = load<int32_t, uint32_t>(buf + 8);
+        b.intensity[i] = load<uint16_t, uint16_t>(buf + 12);
+        if (F::V14)
+        {
+            uint8_t returnInfo = (uint8_t)buf[14];
+            uint8_t flags = (uint8_t)buf[15];
+            b.returnNumber[i] = returnInfo & 0x0F;
+            b.numberOfReturns[i] = (returnInfo >> 4) & 0x0F;
+            b.classFlags[i] = flags & 0x0F;
+            b.scanChannel[i] = (flags >> 4) & 0x03;
+            b.scanDirectionFlag[i] = (flags >> 6) & 0x01;
+            b.edgeOfFlightLine[i] = (flags >> 7) & 0x01;
+            b.classification[i] = (uint8_t)buf[16];
+            b.userData[i] = (uint8_t)buf[17];
+            b.scanAngle[i] =
+                (float)(load<int16_t, uint16_t>(buf + 18) * .006);
+            b.pointSourceId[i] = load<uint16_t, uint16_t>(buf + 20);
+        }
+        else
+        {
+            uint8_t flags = (uint8_t)buf[14];
+            b.returnNumber[i] = flags & 0x07;
+            b.numberOfReturns[i] = (flags >> 3) & 0x07;
+            b.scanDirectionFlag[i] = (flags >> 6) & 0x01;
+            b.edgeOfFlightLine[i] = (flags >> 7) & 0x01;
+            b.classification[i] = (uint8_t)buf[15];
+            b.scanAngle[i] = load<int8_t, uint8_t>(buf + 16);
+            b.userData[i] = (uint8_t)buf[17];
+            b.pointSourceId[i] = load<uint16_t, uint16_t>(buf + 18);
+        }
+        if (F::Time)
+            b.gpsTime[i] = load<double, uint64_t>(buf + F::TimePos);
+        if (F::Color)
+        {
+            b.red[i] = load<uint16_t, uint16_t>(buf + F::ColorPos);
+            b.green[i] = load<uint16_t, uint16_t>(buf + F::ColorPos + 2);
+            b.blue[i] = load<uint16_t, uint16_t>(buf + F::ColorPos + 4);
+        }
+        if (F::Infrared)
+            b.infrared[i] = load<uint16_t, uint16_t>(buf + F::InfraredPos);
+    }
+
+    // Kept separate from the loop above so that it can be vectorized.
+    const double sx = h.scaleX();
+    const double sy = h.scaleY();
+    const double sz = h.scaleZ();
+    const double ox = h.offsetX();
+    const double oy = h.offsetY();
+    const double oz = h.offsetZ();
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        b.x[i] = b.xi[i] * sx + ox;
+        b.y[i] = b.yi[i] * sy + oy;
+        b.z[i] = b.zi[i] * sz + oz;
+    }
+}
+
+
+template<int Format>
+void encodeFormat(const Batch& b, point_count_t count, char *buf,
+    size_t stride)
+{
+    typedef Traits<Format> F;
+
+    for (point_count_t i = 0; i < count; ++i, buf += stride)
+    {
+        save<int32_t, uint32_t>(buf, b.xi[i]);
+        save<int32_t, uint32_t>(buf + 4, b.yi[i]);
+        save<int32_t, uint32_t>(buf + 8, b.zi[i]);
+        save<uint16_t, uint16_t>(buf + 12, b.intensity[i]);
+        if (F::V14)
+        {
+            buf[14] = (char)(b.returnNumber[i] | (b.numberOfReturns[i] << 4));
+            buf[15] = (char)((b.classFlags[i] & 0x0F) |
+                ((b.scanChannel[i] & 0x03) << 4) |
+                ((b.scanDirectionFlag[i] & 0x01) << 6) |
+                ((b.edgeOfFlightLine[i] & 0x01) << 7));
+            buf[16] = (char)b.classification[i];
+            buf[17] = (char)b.userData[i];
+            // Guaranteed to fit if scan angle rank isn't wonky.
+            int16_t scanAngle =
+                static_cast<int16_t>(std::round(b.scanAngle[i] / .006f));
+            save<int16_t, uint16_t>(buf + 18, scanAngle);
+            save<uint16_t, uint16_t>(buf + 20, b.pointSourceId[i]);
+        }
+        else
+        {
+            buf[14] = (char)(b.returnNumber[i] | (b.numberOfReturns[i] << 3) |
+                (b.scanDirectionFlag[i] << 6) | (b.edgeOfFlightLine[i] << 7));
+            buf[15] = (char)b.classification[i];
+            buf[16] = (char)(int8_t)b.scanAngle[i];
+            buf[17] = (char)b.userData[i];
+            save<uint16_t, uint16_t>(buf + 18, b.pointSourceId[i]);
+        }
+        if (F::Time)
+            save<double, uint64_t>(buf + F::TimePos, b.gpsTime[i]);
+        if (F::Color)
+        {
+            save<uint16_t, uint16_t>(buf + F::ColorPos, b.red[i]);
+            save<uint16_t, uint16_t>(buf + F::ColorPos + 2, b.green[i]);
+            save<uint16_t, uint16_t>(buf + F::ColorPos + 4, b.blue[i]);
+        }
+        if (F::Infrared)
+            save<uint16_t, uint16_t>(buf + F::InfraredPos, b.infrared[i]);
+    }
+}
+
+} // unnamed namespace
+
+
+Batch::Batch() : xi(BatchSize), yi(BatchSize), zi(BatchSize), x(BatchSize),
+    y(BatchSize), z(BatchSize), intensity(BatchSize),
+    returnNumber(BatchSize), numberOfReturns(BatchSize),
+    scanDirectionFlag(BatchSize), edgeOfFlightLine(BatchSize),
+    classification(BatchSize), classFlags(BatchSize), scanChannel(BatchSize),
+    userData(BatchSize), scanAngle(BatchSize), pointSourceId(BatchSize),
+    gpsTime(BatchSize), red(BatchSize), green(BatchSize), blue(BatchSize),
+    infrared(BatchSize)
+{}
+
+
+void decode(const LasHeader& header, const char *buf, size_t stride,
+    point_count_t count, Batch& batch)
+{
+    switch (header.pointFormat())
+    {
+    case 0:
+        decodeFormat<0>(header, buf, stride, count, batch);
+        break;
+    case 1:
+        decodeFormat<1>(header, buf, stride, count, batch);
+        break;
+    case 2:
+        decodeFormat<2>(header, buf, stride, count, batch);
+        break;
+    case 3:
+        decodeFormat<3>(header, buf, stride, count, batch);
+        break;
+    case 6:
+        decodeFormat<6>(header, buf, stride, count, batch);
+        break;
+    case 7:
+        decodeFormat<7>(header, buf, stride, count, batch);
+        break;
+    case 8:
+        decodeFormat<8>(header, buf, stride, count, batch);
+        break;
+    default:
+        throw pdal_error("Unsupported LAS point format: " +
+            std::to_string((int)header.pointFormat()) + ".");
+    }
+}
+
+
+// Each field is set with one call.  When the view's points are contiguous
+// and the table's type for the dimension matches the field, the table copies
+// the whole array into its storage.
+void store(const LasHeader& header, const Batch& b, PointView& view,
+    PointId id, point_count_t count)
+{
+    using namespace Dimension;
+
+    view.setFieldArray(Id::X, id, count, b.x.data());
+    view.setFieldArray(Id::Y, id, count, b.y.data());
+    view.setFieldArray(Id::Z, id, count, b.z.data());
+    view.setFieldArray(Id::Intensity, id, count, b.intensity.data());
+    view.setFieldArray(Id::ReturnNumber, id, count, b.returnNumber.data());
+    view.setFieldArray(Id::NumberOfReturns, id, count,
+        b.numberOfReturns.data());
+    if (header.has14Format())
+    {
+        view.setFieldArray(Id::ClassFlags, id, count, b.classFlags.data());
+        view.setFieldArray(Id::ScanChannel, id, count, b.scanChannel.data());
+    }
+    view.setFieldArray(Id::ScanDirectionFlag, id, count,
+        b.scanDirectionFlag.data());
+    view.setFieldArray(Id::EdgeOfFlightLine, id, count,
+        b.edgeOfFlightLine.data());
+    view.setFieldArray(Id::Classification, id, count,
+        b.classification.data());
+    view.setFieldArray(Id::ScanAngleRank, id, count, b.scanAngle.data());
+    view.setFieldArray(Id::UserData, id, count, b.userData.data());
+    view.setFieldArray(Id::PointSourceId, id, count, b.pointSourceId.data());
+    if (header.hasTime())
+        view.setFieldArray(Id::GpsTime, id, count, b.gpsTime.data());
+    if (header.hasColor())
+    {
+        view.setFieldArray(Id::Red, id, count, b.red.data());
+        view.setFieldArray(Id::Green, id, count, b.green.data());
+        view.setFieldArray(Id::Blue, id, count, b.blue.data());
+    }
+    if (header.hasInfrared())
+        view.setFieldArray(Id::Infrared, id, count, b.infrared.data());
+}
+
+
+void fetch(const LasHeader& header, const PointView& view, PointId id,
+    point_count_t count, Batch& b)
+{
+    using namespace Dimension;
+
+    view.getFieldArray(Id::X, id, count, b.x.data());
+    view.getFieldArray(Id::Y, id, count, b.y.data());
+    view.getFieldArray(Id::Z, id, count, b.z.data());
+    view.getFieldArray(Id::Intensity, id, count, b.intensity.data());
+    if (view.hasDim(Id::ReturnNumber))
+        view.getFieldArray(Id::ReturnNumber, id, count,
+            b.returnNumber.data());
+    else
+        std::fill(b.returnNumber.begin(), b.returnNumber.begin() + count, 1);
+    if (view.hasDim(Id::NumberOfReturns))
+        view.getFieldArray(Id::NumberOfReturns, id, count,
+            b.numberOfReturns.data());
+    else
+        std::fill(b.numberOfReturns.begin(),
+            b.numberOfReturns.begin() + count, 1);
+    view.getFieldArray(Id::ScanChannel, id, count, b.scanChannel.data());
+    view.getFieldArray(Id::ScanDirectionFlag, id, count,
+        b.scanDirectionFlag.data());
+    view.getFieldArray(Id::EdgeOfFlightLine, id, count,
+        b.edgeOfFlightLine.data());
+    view.getFieldArray(Id::Classification, id, count,
+        b.classification.data());
+    view.getFieldArray(Id::UserData, id, count, b.userData.data());
+    view.getFieldArray(Id::PointSourceId, id, count, b.pointSourceId.data());
+    if (header.has14Format())
+    {
+        view.getFieldArray(Id::ClassFlags, id, count, b.classFlags.data());
+        view.getFieldArray(Id::ScanAngleRank, id, count, b.scanAngle.data());
+    }
+    else
+    {
+        // Fetch as int8_t so that out-of-range values are reported.
+        int8_t scanAngle[BatchSize];
+        view.getFieldArray(Id::ScanAngleRank, id, count, scanAngle);
+        std::copy(scanAngle, scanAngle + count, b.scanAngle.begin());
+    }
+    if (header.hasTime())
+        view.getFieldArray(Id::GpsTime, id, count, b.gpsTime.data());
+    if (header.hasColor())
+    {
+        view.getFieldArray(Id::Red, id, count, b.red.data());
+        view.getFieldArray(Id::Green, id, count, b.green.data());
+        view.getFieldArray(Id::Blue, id, count, b.blue.data());
+    }
+    if (header.hasInfrared())
+        view.getFieldArray(Id::Infrared, id, count, b.infrared.data());
+}
+
+
+void encode(const LasHeader& header, const Batch& batch, point_count_t count,
+    char *buf, size_t stride)
+{
+    switch (header.pointFormat())
+    {
+    case 0:
+        encodeFormat<0>(batch, count, buf, stride);
+        break;
+    case 1:
+        encodeFormat<1>(batch, count, buf, stride);
+        break;
+    case 2:
+        encodeFormat<2>(batch, count, buf, stride);
+        break;
+    case 3:
+        encodeFormat<3>(batch, count, buf, stride);
+        break;
+    case 6:
+        encodeFormat<6>(batch, count, buf, stride);
+        break;
+    case 7:
+        encodeFormat<7>(batch, count, buf, stride);
+        break;
+    case 8:
+        encodeFormat<8>(batch, count, buf, stride);
+        break;
+    default:
+        throw pdal_error("Unsupported LAS point format: " +
+            std::to_string((int)header.pointFormat()) + ".");
+    }
+}
+
+} // namespace LasCodec
+} // namespace pdal
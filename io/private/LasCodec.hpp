@@ -0,0 +1,108 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <pdal/pdal_types.hpp>
+
+namespace pdal
+{
+
+class LasHeader;
+class PointView;
+
+namespace LasCodec
+{
+
+// Number of points decoded or encoded at a time.
+const point_count_t BatchSize = 4096;
+
+// The base LAS fields of a batch of points, one array per field.  Extra
+// bytes aren't included.  Fields have the types that readers.las gives
+// their dimensions, so that storing a batch in a contiguous view copies each
+// array straight into the table.
+struct Batch
+{
+    Batch();
+
+    std::vector<int32_t> xi;
+    std::vector<int32_t> yi;
+    std::vector<int32_t> zi;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<uint16_t> intensity;
+    std::vector<uint8_t> returnNumber;
+    std::vector<uint8_t> numberOfReturns;
+    std::vector<uint8_t> scanDirectionFlag;
+    std::vector<uint8_t> edgeOfFlightLine;
+    std::vector<uint8_t> classification;
+    std::vector<uint8_t> classFlags;
+    std::vector<uint8_t> scanChannel;
+    std::vector<uint8_t> userData;
+    std::vector<float> scanAngle;
+    std::vector<uint16_t> pointSourceId;
+    std::vector<double> gpsTime;
+    std::vector<uint16_t> red;
+    std::vector<uint16_t> green;
+    std::vector<uint16_t> blue;
+    std::vector<uint16_t> infrared;
+};
+
+// Decode up to BatchSize records, 'stride' bytes apart, into the columns of
+// a batch, including scaled X, Y and Z.  The point format is taken from the
+// header and switched on once per call.
+void decode(const LasHeader& header, const char *buf, size_t stride,
+    point_count_t count, Batch& batch);
+
+// Set the decoded fields of 'count' points in a view, starting at 'id'.
+// Points are added to the view as necessary.
+void store(const LasHeader& header, const Batch& batch, PointView& view,
+    PointId id, point_count_t count);
+
+// Fetch the fields of 'count' points of a view, starting at 'id'.  X, Y and
+// Z are fetched unscaled and ReturnNumber and NumberOfReturns default to 1
+// when the view doesn't have them.
+void fetch(const LasHeader& header, const PointView& view, PointId id,
+    point_count_t count, Batch& batch);
+
+// Encode the base fields of up to BatchSize points, using the scaled
+// integer X, Y and Z, into records 'stride' bytes apart.
+void encode(const LasHeader& header, const Batch& batch, point_count_t count,
+    char *buf, size_t stride);
+
+} // namespace LasCodec
+} // namespace pdal
@@ -0,0 +1,554 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasOctree.hpp"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <future>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <pdal/private/Executor.hpp>
+#include <pdal/util/Extractor.hpp>
+#include <pdal/util/Inserter.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+#include <pdal/util/portable_endian.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Largest number of points in a bucket, assuming that points lie on a
+// surface, so that a level has four times the points of the one above.
+const point_count_t BucketPoints = 1000000;
+// Limits the number of buckets to 8^4.  Must be no more than log2 of
+// GridSize, so that the cells of nodes above the buckets don't cross
+// buckets.
+const uint64_t MaxBucketDepth = 4;
+// Nodes with no more than this number of points aren't split.
+const point_count_t LeafPoints = 65536;
+const uint64_t MaxDepth = 24;
+
+// Size of a node in the hierarchy.
+const size_t NodeSize = 4 * sizeof(int32_t) + sizeof(uint64_t) +
+    2 * sizeof(uint32_t);
+
+// The scaled X, Y and Z of a point are the first fields of all LAS point
+// formats.
+void position(const char *point, double *xyz)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        uint32_t u;
+        std::memcpy(&u, point + i * sizeof(u), sizeof(u));
+        xyz[i] = (int32_t)le32toh(u);
+    }
+}
+
+} // unnamed namespace
+
+
+LasOctree::LasOctree() : m_hierarchyOffset(0), m_hierarchyCount(0)
+{}
+
+
+LasOctree::LasOctree(const BOX3D& cube) : m_cube(cube),
+    m_hierarchyOffset(0), m_hierarchyCount(0)
+{}
+
+
+bool LasOctree::readVlr(const char *data, size_t size)
+{
+    if (size < VlrSize)
+        return false;
+
+    LeExtractor in(data, size);
+    in >> m_cube.minx >> m_cube.miny >> m_cube.minz >>
+        m_cube.maxx >> m_cube.maxy >> m_cube.maxz;
+    in >> m_hierarchyOffset >> m_hierarchyCount;
+    return m_cube.maxx > m_cube.minx && m_cube.maxy > m_cube.miny &&
+        m_cube.maxz > m_cube.minz;
+}
+
+
+std::vector<uint8_t> LasOctree::vlrData() const
+{
+    std::vector<uint8_t> data(VlrSize);
+
+    LeInserter out((char *)data.data(), data.size());
+    out << m_cube.minx << m_cube.miny << m_cube.minz <<
+        m_cube.maxx << m_cube.maxy << m_cube.maxz;
+    out << m_hierarchyOffset << m_hierarchyCount;
+    return data;
+}
+
+
+void LasOctree::writeHierarchy(std::ostream& stream)
+{
+    m_hierarchyOffset = (uint64_t)stream.tellp();
+    m_hierarchyCount = m_nodes.size();
+
+    OLeStream out(&stream);
+    for (const Node& n : m_nodes)
+    {
+        out << (int32_t)n.m_key.d << (int32_t)n.m_key.x <<
+            (int32_t)n.m_key.y << (int32_t)n.m_key.z;
+        out << n.m_offset << n.m_size << n.m_count;
+    }
+}
+
+
+bool LasOctree::readHierarchy(std::istream& stream)
+{
+    m_nodes.clear();
+    stream.seekg(m_hierarchyOffset);
+
+    std::vector<char> buf(NodeSize);
+    for (uint64_t i = 0; i < m_hierarchyCount; ++i)
+    {
+        stream.read(buf.data(), buf.size());
+        if (!stream)
+        {
+            stream.clear();
+            m_nodes.clear();
+            return false;
+        }
+
+        LeExtractor in(buf.data(), buf.size());
+        int32_t d, x, y, z;
+        Node n;
+        in >> d >> x >> y >> z >> n.m_offset >> n.m_size >> n.m_count;
+        n.m_key.d = d;
+        n.m_key.x = x;
+        n.m_key.y = y;
+        n.m_key.z = z;
+        m_nodes.push_back(n);
+    }
+    return true;
+}
+
+
+BOX3D LasOctree::bounds(const Key& key) const
+{
+    const double cells = (double)(1ULL << key.d);
+    const double dx = (m_cube.maxx - m_cube.minx) / cells;
+    const double dy = (m_cube.maxy - m_cube.miny) / cells;
+    const double dz = (m_cube.maxz - m_cube.minz) / cells;
+
+    return BOX3D(m_cube.minx + key.x * dx, m_cube.miny + key.y * dy,
+        m_cube.minz + key.z * dz, m_cube.minx + (key.x + 1) * dx,
+        m_cube.miny + (key.y + 1) * dy, m_cube.minz + (key.z + 1) * dz);
+}
+
+
+uint64_t LasOctree::depth(double resolution) const
+{
+    uint64_t maxDepth = 0;
+    for (const Node& n : m_nodes)
+        maxDepth = (std::max)(maxDepth, n.m_key.d);
+
+    double spacing = (m_cube.maxx - m_cube.minx) / GridSize;
+    uint64_t depth = 0;
+    while (depth < maxDepth && spacing > resolution)
+    {
+        spacing /= 2;
+        depth++;
+    }
+    return depth;
+}
+
+
+LasOctreeBuilder::LasOctreeBuilder(size_t pointLen, size_t threads,
+        point_count_t memoryPoints) :
+    m_pointLen(pointLen), m_threads((std::max)(threads, (size_t)1)),
+    m_memoryPoints((std::max)(memoryPoints, (point_count_t)1)),
+    m_spooled(0), m_fd(-1), m_bucketDepth(0)
+{}
+
+
+LasOctreeBuilder::~LasOctreeBuilder()
+{
+#ifndef _WIN32
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+
+void LasOctreeBuilder::add(const char *buf, point_count_t count)
+{
+    double xyz[3];
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        const char *point = buf + i * m_pointLen;
+        position(point, xyz);
+        m_bounds.grow(xyz[0], xyz[1], xyz[2]);
+        m_points.insert(m_points.end(), point, point + m_pointLen);
+        if (m_points.size() / m_pointLen >= m_memoryPoints)
+            spool();
+    }
+}
+
+
+// Move the points in memory to the end of the spool file.  The file is
+// removed as soon as it's created so that it goes away when the builder is
+// destroyed, even if we crash.  Points are kept in memory on Windows.
+void LasOctreeBuilder::spool()
+{
+#ifndef _WIN32
+    if (m_points.empty())
+        return;
+    if (m_fd < 0)
+    {
+        std::string dir;
+        Utils::getenv("TMPDIR", dir);
+        if (dir.empty())
+            dir = "/tmp";
+        std::string filename = dir + "/pdal_octree_XXXXXX";
+        std::vector<char> name(filename.begin(), filename.end());
+        name.push_back(0);
+        m_fd = ::mkstemp(name.data());
+        if (m_fd < 0)
+            throw pdal_error("Unable to create octree spool file in '" +
+                dir + "': " + std::strerror(errno) + ".");
+        ::unlink(name.data());
+    }
+
+    const point_count_t count = m_points.size() / m_pointLen;
+    writeSpool(m_points.data(), m_spooled, count);
+    m_spooled += count;
+    m_points.clear();
+#endif
+}
+
+
+void LasOctreeBuilder::writeSpool(const char *buf, point_count_t first,
+    point_count_t count)
+{
+#ifndef _WIN32
+    off_t offset = (off_t)(first * m_pointLen);
+    size_t size = count * m_pointLen;
+    while (size)
+    {
+        ssize_t n = ::pwrite(m_fd, buf, size, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw pdal_error(std::string("Unable to write octree spool "
+                "file: ") + std::strerror(errno) + ".");
+        }
+        buf += n;
+        offset += n;
+        size -= n;
+    }
+#endif
+}
+
+
+void LasOctreeBuilder::readSpool(char *buf, point_count_t first,
+    point_count_t count) const
+{
+#ifndef _WIN32
+    off_t offset = (off_t)(first * m_pointLen);
+    size_t size = count * m_pointLen;
+    while (size)
+    {
+        ssize_t n = ::pread(m_fd, buf, size, offset);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+                continue;
+            throw pdal_error(std::string("Unable to read octree spool "
+                "file: ") + (n ? std::strerror(errno) : "unexpected end") +
+                ".");
+        }
+        buf += n;
+        offset += n;
+        size -= n;
+    }
+#endif
+}
+
+
+BOX3D LasOctreeBuilder::build(NodeFunc f)
+{
+    const point_count_t numPoints = m_spooled + m_points.size() / m_pointLen;
+    if (numPoints == 0)
+        return BOX3D();
+
+    // Points fall in [min, min + side) along each axis.
+    const double side = (std::max)((std::max)(m_bounds.maxx - m_bounds.minx,
+        m_bounds.maxy - m_bounds.miny), m_bounds.maxz - m_bounds.minz) + 1;
+    m_root = Key();
+    m_root.b = BOX3D(m_bounds.minx, m_bounds.miny, m_bounds.minz,
+        m_bounds.minx + side, m_bounds.miny + side, m_bounds.minz + side);
+
+    const point_count_t bucketPoints = (std::min)(BucketPoints,
+        m_memoryPoints);
+    m_bucketDepth = 0;
+    while (m_bucketDepth < MaxBucketDepth &&
+            (numPoints >> (2 * m_bucketDepth)) > bucketPoints)
+        m_bucketDepth++;
+
+    // Sort the points by bucket a run at a time, so that the points of a
+    // bucket can be found in each run.
+    m_runs.clear();
+    if (m_spooled)
+    {
+        spool();
+
+        std::vector<char> buf;
+        for (point_count_t first = 0; first < m_spooled;
+                first += m_memoryPoints)
+        {
+            const point_count_t count = (std::min)(m_memoryPoints,
+                m_spooled - first);
+            buf.resize(count * m_pointLen);
+            readSpool(buf.data(), first, count);
+
+            Run run;
+            run.m_first = first;
+            sortRun(buf.data(), count, run);
+            writeSpool(buf.data(), first, count);
+            m_runs.push_back(run);
+        }
+        std::vector<char>().swap(m_points);
+    }
+    else
+    {
+        Run run;
+        run.m_first = 0;
+        sortRun(m_points.data(), numPoints, run);
+        m_runs.push_back(run);
+    }
+
+    // Build buckets in parallel and pass their nodes on in order.  Points
+    // of nodes above the buckets are collected and passed on last.
+    std::map<Key, std::vector<char>> ancestors;
+    Executor& executor = Executor::global();
+    std::deque<std::future<Bucket>> pending;
+    auto next = [this, &executor, &pending, &ancestors, &f]()
+    {
+        executor.wait(pending.front());
+        Bucket bucket = pending.front().get();
+        pending.pop_front();
+        for (auto& node : bucket.m_nodes)
+            f(node.first, node.second.data(),
+                node.second.size() / m_pointLen);
+        for (auto& node : bucket.m_ancestors)
+        {
+            std::vector<char>& points = ancestors[node.first];
+            points.insert(points.end(), node.second.begin(),
+                node.second.end());
+        }
+    };
+
+    // Buckets still being built use our state, so they're waited for if
+    // the node function throws.
+    const size_t numBuckets = (size_t)1 << (3 * m_bucketDepth);
+    try
+    {
+        for (size_t b = 0; b < numBuckets; ++b)
+        {
+            point_count_t count = 0;
+            for (const Run& run : m_runs)
+                count += run.m_starts[b + 1] - run.m_starts[b];
+            if (count == 0)
+                continue;
+
+            if (pending.size() >= 2 * m_threads)
+                next();
+            pending.push_back(executor.async([this, b]()
+                { return buildBucket(b); }));
+        }
+        while (pending.size())
+            next();
+    }
+    catch (...)
+    {
+        for (auto& p : pending)
+            executor.wait(p);
+        throw;
+    }
+
+    for (auto& node : ancestors)
+        f(node.first, node.second.data(), node.second.size() / m_pointLen);
+    return m_root.b;
+}
+
+
+// Find the bucket of a point by descending from the root as place() does.
+size_t LasOctreeBuilder::bucketOf(const char *point) const
+{
+    double xyz[3];
+    position(point, xyz);
+
+    Key key(m_root);
+    while (key.d < m_bucketDepth)
+    {
+        uint64_t dir = 0;
+        for (int i = 0; i < 3; ++i)
+            if (xyz[i] >= key[i] + (key[i + 3] - key[i]) / 2.0)
+                dir |= (uint64_t)1 << i;
+        key = key.bisect(dir);
+    }
+    return (size_t)((key.x << (2 * m_bucketDepth)) |
+        (key.y << m_bucketDepth) | key.z);
+}
+
+
+// Sort a run of points by bucket, keeping their order within a bucket.
+void LasOctreeBuilder::sortRun(char *buf, point_count_t count, Run& run) const
+{
+    const size_t numBuckets = (size_t)1 << (3 * m_bucketDepth);
+
+    std::vector<size_t> buckets(count);
+    run.m_starts.assign(numBuckets + 1, 0);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        buckets[i] = bucketOf(buf + i * m_pointLen);
+        run.m_starts[buckets[i] + 1]++;
+    }
+    for (size_t b = 0; b < numBuckets; ++b)
+        run.m_starts[b + 1] += run.m_starts[b];
+
+    std::vector<char> sorted(count * m_pointLen);
+    std::vector<point_count_t> pos(run.m_starts.begin(),
+        run.m_starts.end() - 1);
+    for (point_count_t i = 0; i < count; ++i)
+        std::memcpy(sorted.data() + pos[buckets[i]]++ * m_pointLen,
+            buf + i * m_pointLen, m_pointLen);
+    std::memcpy(buf, sorted.data(), sorted.size());
+}
+
+
+std::vector<char> LasOctreeBuilder::loadBucket(size_t bucket) const
+{
+    point_count_t count = 0;
+    for (const Run& run : m_runs)
+        count += run.m_starts[bucket + 1] - run.m_starts[bucket];
+
+    std::vector<char> points(count * m_pointLen);
+    char *pos = points.data();
+    for (const Run& run : m_runs)
+    {
+        const point_count_t first = run.m_first + run.m_starts[bucket];
+        const point_count_t n =
+            run.m_starts[bucket + 1] - run.m_starts[bucket];
+        if (m_spooled)
+            readSpool(pos, first, n);
+        else
+            std::memcpy(pos, m_points.data() + first * m_pointLen,
+                n * m_pointLen);
+        pos += n * m_pointLen;
+    }
+    return points;
+}
+
+
+// Called on executor threads.
+LasOctreeBuilder::Bucket LasOctreeBuilder::buildBucket(size_t bucket) const
+{
+    Bucket result;
+    std::vector<char> points = loadBucket(bucket);
+    place(m_root, points, result);
+    return result;
+}
+
+
+// Keep the first point in each cell of a node's grid and pass the rest to
+// its children.  Nodes at or below the buckets that are small enough keep
+// all their points.
+void LasOctreeBuilder::place(const Key& key, std::vector<char>& points,
+    Bucket& result) const
+{
+    const point_count_t count = points.size() / m_pointLen;
+    if (count == 0)
+        return;
+
+    const bool ancestor = key.d < m_bucketDepth;
+    const double side = key.b.maxx - key.b.minx;
+    if (!ancestor && (count <= LeafPoints || key.d >= MaxDepth ||
+            side <= LasOctree::GridSize))
+    {
+        result.m_nodes.emplace_back(key, std::move(points));
+        return;
+    }
+
+    const size_t g = LasOctree::GridSize;
+    const double min[3] { key.b.minx, key.b.miny, key.b.minz };
+    const double max[3] { key.b.maxx, key.b.maxy, key.b.maxz };
+    std::vector<bool> taken(g * g * g);
+    std::vector<char> kept;
+    std::vector<char> children[8];
+    double xyz[3];
+    for (const char *p = points.data(); p < points.data() + points.size();
+            p += m_pointLen)
+    {
+        position(p, xyz);
+
+        size_t cell = 0;
+        uint64_t dir = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            double c = std::floor((xyz[i] - min[i]) / (max[i] - min[i]) * g);
+            c = (std::max)(0.0, (std::min)(c, (double)(g - 1)));
+            cell = cell * g + (size_t)c;
+            if (xyz[i] >= min[i] + (max[i] - min[i]) / 2.0)
+                dir |= (uint64_t)1 << i;
+        }
+        std::vector<char>& dest = taken[cell] ? children[dir] : kept;
+        taken[cell] = true;
+        dest.insert(dest.end(), p, p + m_pointLen);
+    }
+    std::vector<char>().swap(points);
+
+    if (ancestor)
+        result.m_ancestors[key] = std::move(kept);
+    else
+        result.m_nodes.emplace_back(key, std::move(kept));
+    for (uint64_t dir = 0; dir < 8; ++dir)
+        place(key.bisect(dir), children[dir], result);
+}
+
+} // namespace pdal
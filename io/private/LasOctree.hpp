@@ -0,0 +1,175 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include <pdal/pdal_types.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include "EptSupport.hpp"
+
+namespace pdal
+{
+
+// Octree of the points of a LAZ file whose chunks are the nodes of the
+// octree.  The cube of the octree and the location of the hierarchy are
+// stored in a VLR.  The hierarchy follows the chunk table at the end of the
+// point data and maps each node to its chunk.  Each node holds about one
+// point per cell of a GridSize^3 grid over its bounds, so the spacing of
+// points halves at each level.
+class PDAL_DLL LasOctree
+{
+public:
+    struct Node
+    {
+        Key m_key;
+        // File offset and compressed size of the node's chunk.
+        uint64_t m_offset;
+        uint32_t m_size;
+        uint32_t m_count;
+    };
+    typedef std::vector<Node> NodeList;
+
+    // Cells of the grid of a node along each axis.
+    static const int GridSize = 128;
+    // Size of the VLR data.
+    static const size_t VlrSize = 6 * sizeof(double) + 2 * sizeof(uint64_t);
+
+    LasOctree();
+    LasOctree(const BOX3D& cube);
+
+    // Read the cube and hierarchy location from VLR data.  Returns false if
+    // the data isn't valid.
+    bool readVlr(const char *data, size_t size);
+    std::vector<uint8_t> vlrData() const;
+
+    // Write the hierarchy at the current position of a stream and note its
+    // location for vlrData().
+    void writeHierarchy(std::ostream& out);
+    // Read the hierarchy found from the VLR.  Returns false if it can't be
+    // read.
+    bool readHierarchy(std::istream& in);
+
+    const BOX3D& cube() const
+        { return m_cube; }
+    NodeList& nodes()
+        { return m_nodes; }
+    const NodeList& nodes() const
+        { return m_nodes; }
+
+    // Bounds of a node.
+    BOX3D bounds(const Key& key) const;
+    // Depth of the shallowest level whose points are no more than
+    // 'resolution' apart, limited to the depth of the deepest node.
+    uint64_t depth(double resolution) const;
+
+private:
+    BOX3D m_cube;
+    uint64_t m_hierarchyOffset;
+    uint64_t m_hierarchyCount;
+    NodeList m_nodes;
+};
+
+
+// Sorts packed LAS points into the nodes of a LasOctree.  Points are added
+// as they're written and held in memory until there are too many, after
+// which they're spooled to a temporary file.  The octree is built by
+// sorting points into buckets, the nodes of a level of the octree chosen so
+// that each bucket fits in memory, and building the subtree of each bucket
+// in parallel.  A node above the buckets takes points from each bucket
+// independently, which works because the cells of its grid don't cross
+// buckets.
+class PDAL_DLL LasOctreeBuilder
+{
+public:
+    // Called with the points of each node in turn.
+    typedef std::function<void(const Key& key, char *buf,
+        point_count_t count)> NodeFunc;
+
+    LasOctreeBuilder(size_t pointLen, size_t threads,
+        point_count_t memoryPoints);
+    ~LasOctreeBuilder();
+
+    // Add packed points.
+    void add(const char *buf, point_count_t count);
+
+    // Build the octree and call 'f' from this thread with the points of
+    // each node.  Returns the cube of the octree in the scaled (integer)
+    // coordinates of the points.
+    BOX3D build(NodeFunc f);
+
+private:
+    struct Run
+    {
+        point_count_t m_first;
+        // First point of each bucket, relative to m_first, and the end of
+        // the run.
+        std::vector<point_count_t> m_starts;
+    };
+    struct Bucket
+    {
+        std::vector<std::pair<Key, std::vector<char>>> m_nodes;
+        std::map<Key, std::vector<char>> m_ancestors;
+    };
+
+    size_t m_pointLen;
+    size_t m_threads;
+    point_count_t m_memoryPoints;
+    std::vector<char> m_points;
+    point_count_t m_spooled;
+    int m_fd;
+    BOX3D m_bounds;
+    Key m_root;
+    uint64_t m_bucketDepth;
+    std::vector<Run> m_runs;
+
+    void spool();
+    void readSpool(char *buf, point_count_t first, point_count_t count) const;
+    void writeSpool(const char *buf, point_count_t first,
+        point_count_t count);
+    size_t bucketOf(const char *point) const;
+    void sortRun(char *buf, point_count_t count, Run& run) const;
+    std::vector<char> loadBucket(size_t bucket) const;
+    Bucket buildBucket(size_t bucket) const;
+    void place(const Key& key, std::vector<char>& points, Bucket& result)
+        const;
+};
+
+} // namespace pdal
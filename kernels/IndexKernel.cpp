@@ -0,0 +1,103 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "IndexKernel.hpp"
+
+#include <pdal/PointView.hpp>
+#include <pdal/Reader.hpp>
+
+#include "../io/LasIndex.hpp"
+#include "../io/LasReader.hpp"
+
+namespace pdal
+{
+
+static StaticPluginInfo const s_info
+{
+    "kernels.index",
+    "Index Kernel",
+    "http://pdal.io/apps/spatial_index.html"
+};
+
+CREATE_STATIC_KERNEL(IndexKernel, s_info)
+
+std::string IndexKernel::getName() const
+{
+    return s_info.name;
+}
+
+
+IndexKernel::IndexKernel() : m_depth(-1)
+{}
+
+
+void IndexKernel::addSwitches(ProgramArgs& args)
+{
+    args.add("input,i", "Input LAS/LAZ filename", m_inputFile).
+        setPositional();
+    args.add("depth", "Quadtree depth of the index. Chosen from the "
+        "number of points if not set", m_depth, -1);
+}
+
+
+int IndexKernel::execute()
+{
+    if (m_depth > 16)
+        throw pdal_error("Index depth must be no more than 16.");
+
+    // Point IDs of the view must be indices into the file, so read the
+    // file directly.  Only X and Y are needed.
+    Stage& readerStage = makeReader(m_inputFile, "readers.las");
+    Reader *reader = dynamic_cast<Reader *>(&readerStage);
+    if (reader)
+        reader->setUsedDims({ "X", "Y" });
+
+    PointTable table;
+    readerStage.prepare(table);
+    PointViewSet viewSet = readerStage.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    LasReader *lasReader = dynamic_cast<LasReader *>(&readerStage);
+    if (!lasReader)
+        throw pdal_error("Unable to read '" + m_inputFile + "' as LAS/LAZ.");
+
+    LasIndex index;
+    index.build(*view, LasIndex::source(m_inputFile, lasReader->header()),
+        m_depth);
+    index.write(LasIndex::filename(m_inputFile));
+
+    return 0;
+}
+
+} // namespace pdal
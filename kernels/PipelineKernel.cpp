@@ -106,6 +106,20 @@ void PipelineKernel::addSwitches(ProgramArgs& args)
         m_stream);
     args.add("nostream", "Run in standard mode.", m_noStream);
     args.add("metadata", "Metadata filename", m_metadataFile);
+    args.add("out-of-core", "In standard mode, store point data in a "
+        "memory-mapped temporary file rather than in memory.", m_outOfCore);
+    args.add("resident-memory", "Approximate amount of point data (in MB) "
+        "kept in memory when running out of core.  0 leaves paging to the "
+        "operating system.", m_residentMb);
+    args.add("temp-dir", "Directory for temporary files used when running "
+        "out of core.", m_tempDir);
+    args.add("columnar", "In standard mode, store the values of each "
+        "dimension in a separate array rather than storing points one after "
+        "another.", m_columnar);
+    args.add("profile", "Write the time, point counts and memory use of "
+        "each stage to standard error.", m_profile);
+    args.add("read-ahead", "In stream mode, number of tables of points read "
+        "ahead on a separate thread.", m_readAhead);
 }
 
 
@@ -143,9 +157,20 @@ int PipelineKernel::execute()
         return 0;
     }
 
+    if (m_outOfCore && m_columnar)
+        throw pdal_error("Options 'out-of-core' and 'columnar' can't be "
+            "used together.");
+    if (m_outOfCore)
+        m_manager.setOutOfCore(m_residentMb * 1024 * 1024, m_tempDir);
+    if (m_columnar)
+        m_manager.setColumnStorage();
+    m_manager.setProfiling(m_profile);
+    m_manager.setReadAhead(m_readAhead);
     m_manager.readPipeline(m_inputFile);
     if (m_manager.execute(m_mode).m_mode == ExecMode::None)
         throw pdal_error("Couldn't run pipeline in requested execution mode.");
+    if (m_profile)
+        Utils::toJSON(m_manager.getProfile(), std::cerr);
 
     if (m_metadataFile.size())
     {
@@ -64,6 +64,12 @@ private:
     bool m_usestdin;
     bool m_stream;
     bool m_noStream;
+    bool m_outOfCore;
+    size_t m_residentMb;
+    std::string m_tempDir;
+    bool m_columnar;
+    bool m_profile;
+    size_t m_readAhead;
     ExecMode m_mode;
 };
 
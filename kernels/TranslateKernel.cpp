@@ -89,6 +89,10 @@ void TranslateKernel::addSwitches(ProgramArgs& args)
     args.add("writer,w", "Writer type", m_writerType);
     args.add("nostream", "Run in standard mode", m_noStream);
     args.add("stream", "Run in stream mode.  Error if not possible.", m_stream);
+    args.add("profile", "Write the time, point counts and memory use of "
+        "each stage to standard error.", m_profile);
+    args.add("read-ahead", "In stream mode, number of tables of points read "
+        "ahead on a separate thread.", m_readAhead);
 }
 
 
@@ -223,9 +227,13 @@ int TranslateKernel::execute()
         return 0;
     }
 
+    m_manager.setProfiling(m_profile);
+    m_manager.setReadAhead(m_readAhead);
     if (m_manager.execute(m_mode).m_mode == ExecMode::None)
         throw pdal_error("Couldn't run translation pipeline in requested "
             "execution mode.");
+    if (m_profile)
+        Utils::toJSON(m_manager.getProfile(), std::cerr);
 
     if (metaOut)
     {
@@ -68,6 +68,8 @@ private:
     std::string m_metadataFile;
     bool m_noStream;
     bool m_stream;
+    bool m_profile;
+    size_t m_readAhead;
     ExecMode m_mode;
 };
 
@@ -0,0 +1,209 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/BlockAllocator.hpp>
+
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace pdal
+{
+
+namespace
+{
+
+const std::size_t HugePageSize = 2 * 1024 * 1024;
+
+std::size_t hugeRound(std::size_t size)
+{
+    return ((size + HugePageSize - 1) / HugePageSize) * HugePageSize;
+}
+
+} // unnamed namespace
+
+
+BlockAllocator::BlockAllocator(bool hugePages, std::size_t poolBytes) :
+    m_hugePages(hugePages), m_poolLimit(poolBytes), m_pooledBytes(0)
+{}
+
+
+BlockAllocator::~BlockAllocator()
+{
+    clear();
+}
+
+
+BlockAllocator& BlockAllocator::heap()
+{
+    static BlockAllocator allocator;
+    return allocator;
+}
+
+
+char *BlockAllocator::allocate(std::size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_free.find(size);
+        if (it != m_free.end() && it->second.size())
+        {
+            char *block = it->second.back();
+            it->second.pop_back();
+            m_pooledBytes -= size;
+            std::memset(block, 0, size);
+            return block;
+        }
+    }
+    return newBlock(size);
+}
+
+
+void BlockAllocator::release(char *block, std::size_t size)
+{
+    if (!block)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_pooledBytes + size <= m_poolLimit)
+        {
+            m_free[size].push_back(block);
+            m_pooledBytes += size;
+            return;
+        }
+    }
+    freeBlock(block, size);
+}
+
+
+void BlockAllocator::setPoolLimit(std::size_t poolBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_poolLimit = poolBytes;
+    trim(m_poolLimit);
+}
+
+
+std::size_t BlockAllocator::pooledBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_pooledBytes;
+}
+
+
+void BlockAllocator::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    trim(0);
+}
+
+
+// Free pooled blocks until no more than 'limit' bytes remain.  Called with
+// the mutex held.
+void BlockAllocator::trim(std::size_t limit)
+{
+    for (auto it = m_free.begin(); it != m_free.end() && m_pooledBytes > limit;)
+    {
+        std::vector<char *>& blocks = it->second;
+        while (blocks.size() && m_pooledBytes > limit)
+        {
+            freeBlock(blocks.back(), it->first);
+            blocks.pop_back();
+            m_pooledBytes -= it->first;
+        }
+        if (blocks.empty())
+            it = m_free.erase(it);
+        else
+            ++it;
+    }
+}
+
+
+char *BlockAllocator::newBlock(std::size_t size)
+{
+#ifdef __linux__
+    if (m_hugePages)
+    {
+        // Over-allocate so that the block can start on a huge page
+        // boundary, then unmap the unused ends.
+        std::size_t len = hugeRound(size);
+        void *p = mmap(nullptr, len + HugePageSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+
+        char *base = static_cast<char *>(p);
+        std::size_t head = (HugePageSize -
+            (reinterpret_cast<std::size_t>(base) % HugePageSize)) %
+            HugePageSize;
+        if (head)
+            munmap(base, head);
+        std::size_t tail = HugePageSize - head;
+        if (tail)
+            munmap(base + head + len, tail);
+        char *block = base + head;
+#ifdef MADV_HUGEPAGE
+        madvise(block, len, MADV_HUGEPAGE);
+#endif
+        return block;
+    }
+#endif
+    char *block = new char[size];
+    std::memset(block, 0, size);
+    return block;
+}
+
+
+void BlockAllocator::freeBlock(char *block, std::size_t size)
+{
+#ifdef __linux__
+    if (m_hugePages)
+    {
+        munmap(block, hugeRound(size));
+        return;
+    }
+#endif
+    delete [] block;
+}
+
+} // namespace pdal
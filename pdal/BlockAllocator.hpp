@@ -0,0 +1,109 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+/// Allocator for the blocks of point data held by a PointTable.
+///
+/// Blocks are returned zero-filled.  When huge pages are requested, blocks
+/// are mapped directly from the operating system, aligned to a 2MB boundary
+/// and marked as eligible for transparent huge pages, which reduces TLB
+/// misses when large tables are scanned.  When a pool limit is set, freed
+/// blocks are kept (up to the limit) and handed out again in preference to
+/// new memory, so that repeated pipeline runs reuse pages that are already
+/// faulted in.  Pooled blocks are freed when the allocator is destroyed, so
+/// an allocator must outlive the tables that use it.
+///
+/// Allocation and release are thread-safe.
+class PDAL_DLL BlockAllocator
+{
+public:
+    /// \param hugePages  Back blocks with 2MB huge pages where supported.
+    /// \param poolBytes  Maximum number of bytes of released blocks to keep
+    ///     for reuse.  Zero disables pooling.
+    BlockAllocator(bool hugePages = false, std::size_t poolBytes = 0);
+    ~BlockAllocator();
+
+    BlockAllocator(const BlockAllocator&) = delete;
+    BlockAllocator& operator=(const BlockAllocator&) = delete;
+
+    /// Allocate a zero-filled block.
+    /// \param size  Size of the block in bytes.
+    char *allocate(std::size_t size);
+
+    /// Return a block to the allocator.
+    /// \param block  Block returned by allocate().
+    /// \param size  Size passed to allocate() when the block was obtained.
+    void release(char *block, std::size_t size);
+
+    /// Set the maximum number of bytes of released blocks kept for reuse.
+    /// Pooled blocks beyond the new limit are freed.
+    void setPoolLimit(std::size_t poolBytes);
+
+    /// Number of bytes currently held in the pool.
+    std::size_t pooledBytes() const;
+
+    /// Free all pooled blocks.
+    void clear();
+
+    bool hugePages() const
+        { return m_hugePages; }
+
+    /// Allocator that gets each block from the heap and frees it on release.
+    /// This is the default allocator for PointTable.
+    static BlockAllocator& heap();
+
+private:
+    char *newBlock(std::size_t size);
+    void freeBlock(char *block, std::size_t size);
+    void trim(std::size_t limit);
+
+    bool m_hugePages;
+    std::size_t m_poolLimit;
+    std::size_t m_pooledBytes;
+    std::map<std::size_t, std::vector<char *>> m_free;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace pdal
@@ -103,6 +103,32 @@ inline BaseType base(Type t)
     return BaseType(Utils::toNative(t) & 0xFF00);
 }
 
+/// Get the dimension type that corresponds to a C++ type.
+/// \return  Dimension type, or Type::None if there is no corresponding type.
+template<typename T>
+inline Type typeOf()
+    { return Type::None; }
+template<> inline Type typeOf<int8_t>()
+    { return Type::Signed8; }
+template<> inline Type typeOf<int16_t>()
+    { return Type::Signed16; }
+template<> inline Type typeOf<int32_t>()
+    { return Type::Signed32; }
+template<> inline Type typeOf<int64_t>()
+    { return Type::Signed64; }
+template<> inline Type typeOf<uint8_t>()
+    { return Type::Unsigned8; }
+template<> inline Type typeOf<uint16_t>()
+    { return Type::Unsigned16; }
+template<> inline Type typeOf<uint32_t>()
+    { return Type::Unsigned32; }
+template<> inline Type typeOf<uint64_t>()
+    { return Type::Unsigned64; }
+template<> inline Type typeOf<float>()
+    { return Type::Float; }
+template<> inline Type typeOf<double>()
+    { return Type::Double; }
+
 static const int COUNT = (std::numeric_limits<uint16_t>::max)();
 static const int PROPRIETARY = 0xF000;
 
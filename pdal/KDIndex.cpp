@@ -0,0 +1,212 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/KDIndex.hpp>
+
+#include <functional>
+
+#include "private/Executor.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+typedef std::pair<std::size_t, std::size_t> Range;
+
+// Split the query points into ranges, a few per thread so that uneven
+// query costs balance out.
+std::vector<Range> splitQueries(std::size_t count, int threads)
+{
+    std::vector<Range> ranges;
+
+    std::size_t numRanges = (threads > 1) ? (std::size_t)threads * 4 : 1;
+    numRanges = (std::max)((std::size_t)1, (std::min)(numRanges, count));
+    std::size_t rangeSize = (count + numRanges - 1) / numRanges;
+    for (std::size_t begin = 0; begin < count; begin += rangeSize)
+        ranges.push_back({ begin, (std::min)(begin + rangeSize, count) });
+    return ranges;
+}
+
+
+// Run a function for each range of queries.  Ranges are run on the shared
+// executor when more than one thread is requested.
+void runQueries(const std::vector<Range>& ranges, int threads,
+    const std::function<void(std::size_t)>& fn)
+{
+    if (threads <= 1 || ranges.size() <= 1)
+    {
+        for (std::size_t i = 0; i < ranges.size(); ++i)
+            fn(i);
+        return;
+    }
+
+    TaskGroup group;
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+        group.run([&fn, i]() { fn(i); });
+    group.wait();
+}
+
+
+template<typename TREE>
+NeighborResults knnQueries(const TREE& tree, const double *coords,
+    std::size_t numDims, point_count_t numPoints, const PointIdList& ids,
+    point_count_t k, int threads)
+{
+    NeighborResults res;
+
+    k = (std::min)(numPoints, k);
+    res.offsets.resize(ids.size() + 1);
+    for (std::size_t i = 0; i < res.offsets.size(); ++i)
+        res.offsets[i] = i * k;
+    res.indices.resize(ids.size() * k);
+    res.sqrDists.resize(ids.size() * k);
+
+    std::vector<Range> ranges = splitQueries(ids.size(), threads);
+    runQueries(ranges, threads, [&](std::size_t r)
+    {
+        for (std::size_t i = ranges[r].first; i < ranges[r].second; ++i)
+        {
+            nanoflann::KNNResultSet<double, PointId, point_count_t>
+                resultSet(k);
+            resultSet.init(res.indices.data() + i * k,
+                res.sqrDists.data() + i * k);
+            tree.findNeighbors(resultSet, coords + ids[i] * numDims,
+                nanoflann::SearchParams(10));
+        }
+    });
+    return res;
+}
+
+
+template<typename TREE>
+NeighborResults radiusQueries(const TREE& tree, const double *coords,
+    std::size_t numDims, const PointIdList& ids, double r, int threads)
+{
+    struct Partial
+    {
+        std::vector<std::size_t> counts;
+        PointIdList indices;
+        std::vector<double> sqrDists;
+    };
+
+    std::vector<Range> ranges = splitQueries(ids.size(), threads);
+    std::vector<Partial> partials(ranges.size());
+    runQueries(ranges, threads, [&](std::size_t p)
+    {
+        Partial& part = partials[p];
+        std::vector<std::pair<std::size_t, double>> matches;
+        nanoflann::SearchParams params;
+        params.sorted = true;
+
+        for (std::size_t i = ranges[p].first; i < ranges[p].second; ++i)
+        {
+            // Our distance metric is square distance, so we use the square
+            // of the radius.
+            std::size_t count = tree.radiusSearch(coords + ids[i] * numDims,
+                r * r, matches, params);
+            part.counts.push_back(count);
+            for (std::size_t j = 0; j < count; ++j)
+            {
+                part.indices.push_back(matches[j].first);
+                part.sqrDists.push_back(matches[j].second);
+            }
+        }
+    });
+
+    // Stitch the results of each range together.
+    NeighborResults res;
+    std::size_t total = 0;
+    for (Partial& part : partials)
+        total += part.indices.size();
+    res.offsets.reserve(ids.size() + 1);
+    res.indices.reserve(total);
+    res.sqrDists.reserve(total);
+
+    res.offsets.push_back(0);
+    for (Partial& part : partials)
+    {
+        for (std::size_t count : part.counts)
+            res.offsets.push_back(res.offsets.back() + count);
+        res.indices.insert(res.indices.end(), part.indices.begin(),
+            part.indices.end());
+        res.sqrDists.insert(res.sqrDists.end(), part.sqrDists.begin(),
+            part.sqrDists.end());
+    }
+    return res;
+}
+
+} // unnamed namespace
+
+
+NeighborResults KD2Index::knnSearch(const PointIdList& ids, point_count_t k,
+    int threads) const
+{
+    return knnQueries(*m_index, m_coords.data(), 2, m_buf.size(), ids, k,
+        threads);
+}
+
+
+NeighborResults KD2Index::radius(const PointIdList& ids, double r,
+    int threads) const
+{
+    return radiusQueries(*m_index, m_coords.data(), 2, ids, r, threads);
+}
+
+
+NeighborResults KD3Index::knnSearch(const PointIdList& ids, point_count_t k,
+    int threads) const
+{
+    return knnQueries(*m_index, m_coords.data(), 3, m_buf.size(), ids, k,
+        threads);
+}
+
+
+NeighborResults KD3Index::radius(const PointIdList& ids, double r,
+    int threads) const
+{
+    return radiusQueries(*m_index, m_coords.data(), 3, ids, r, threads);
+}
+
+
+NeighborResults KDFlexIndex::radius(const PointIdList& ids, double r,
+    int threads) const
+{
+    return radiusQueries(*m_index, m_coords.data(), m_dims.size(), ids, r,
+        threads);
+}
+
+} // namespace pdal
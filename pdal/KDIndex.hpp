@@ -34,7 +34,9 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include <nanoflann/nanoflann.hpp>
 
@@ -53,6 +55,28 @@ namespace nanoflann
 namespace pdal
 {
 
+/**
+  Results of a neighbor search for a list of query points, stored in
+  compressed sparse row form.  The neighbors of the i'th query point are
+  indices[offsets[i]] through indices[offsets[i + 1] - 1], ordered by
+  increasing distance.  sqrDists holds the corresponding square distances.
+*/
+struct NeighborResults
+{
+    std::vector<std::size_t> offsets;
+    PointIdList indices;
+    std::vector<double> sqrDists;
+
+    std::size_t size() const
+        { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::size_t count(std::size_t i) const
+        { return offsets[i + 1] - offsets[i]; }
+    const PointId *neighbors(std::size_t i) const
+        { return indices.data() + offsets[i]; }
+    const double *distances(std::size_t i) const
+        { return sqrDists.data() + offsets[i]; }
+};
+
 template<int DIM>
 class PDAL_DLL KDIndex
 {
@@ -67,19 +91,92 @@ public:
     std::size_t kdtree_get_point_count() const
         { return m_buf.size(); }
 
-    double kdtree_get_pt(const PointId idx, int dim) const;
-    double kdtree_distance(const double *p1, const PointId p2_idx,
-        size_t /*numDims*/) const;
-    template <class BBOX> bool kdtree_get_bbox(BBOX& bb) const;
+    double kdtree_get_pt(const PointId idx, int dim) const
+    {
+        if (idx >= m_buf.size())
+            return 0.0;
+        return m_coords[idx * DIM + dim];
+    }
+
+    // nanoflann hands us a vector that represents the position of p1.  We
+    // fetch the position of p2 and and compute the square distance.
+    double kdtree_distance(const double *p1, const PointId idx,
+        size_t /*numDims*/) const
+    {
+        const double *p2 = m_coords.data() + idx * DIM;
+        double result(0.0);
+        for (int i = 0; i < DIM; ++i)
+        {
+            double d = p1[i] - p2[i];
+            result += d * d;
+        }
+        return result;
+    }
+
+    template <class BBOX> bool kdtree_get_bbox(BBOX& bb) const
+    {
+        if (m_buf.empty())
+        {
+            for (int i = 0; i < DIM; ++i)
+            {
+                bb[i].low = 0.0;
+                bb[i].high = 0.0;
+            }
+            return true;
+        }
+
+        for (int i = 0; i < DIM; ++i)
+        {
+            bb[i].low = (std::numeric_limits<double>::max)();
+            bb[i].high = std::numeric_limits<double>::lowest();
+        }
+        for (PointId idx = 0; idx < m_buf.size(); ++idx)
+        {
+            const double *p = m_coords.data() + idx * DIM;
+            for (int i = 0; i < DIM; ++i)
+            {
+                bb[i].low = (std::min)(bb[i].low, p[i]);
+                bb[i].high = (std::max)(bb[i].high, p[i]);
+            }
+        }
+        return true;
+    }
+
     void build()
     {
+        // Copy the coordinates into a packed array so that building and
+        // searching the tree don't go through the point view.
+        static const Dimension::Id dims[] =
+            { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+
+        const point_count_t n = m_buf.size();
+        std::vector<double> vals(n);
+        m_coords.resize(n * DIM);
+        for (int i = 0; i < DIM; ++i)
+        {
+            m_buf.getFieldArray(dims[i], 0, n, vals.data());
+            for (PointId idx = 0; idx < n; ++idx)
+                m_coords[idx * DIM + i] = vals[idx];
+        }
+
         m_index.reset(new my_kd_tree_t(DIM, *this,
             nanoflann::KDTreeSingleIndexAdaptorParams(100)));
         m_index->buildIndex();
     }
 
+    /**
+      Get a pointer to the coordinates of a point as stored in the index.
+      Only valid after build() has been called.
+
+      \param idx  ID of the point.
+      \return  Pointer to DIM coordinates of the point.
+    */
+    const double *coords(PointId idx) const
+        { return m_coords.data() + idx * DIM; }
+
 protected:
     const PointView& m_buf;
+    std::vector<double> m_coords;
 
     typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<
         double, KDIndex, double>, KDIndex, -1, std::size_t> my_kd_tree_t;
@@ -138,8 +235,9 @@ public:
 
     PointIdList neighbors(PointId idx, point_count_t k) const
     {
-        double x = m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
+        const double *p = coords(idx);
+        double x = p[0];
+        double y = p[1];
 
         return neighbors(x, y, k);
     }
@@ -169,8 +267,9 @@ public:
     void knnSearch(PointId idx, point_count_t k, PointIdList *indices,
         std::vector<double> *sqr_dists) const
     {
-        double x = m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
+        const double *p = coords(idx);
+        double x = p[0];
+        double y = p[1];
 
         knnSearch(x, y, k, indices, sqr_dists);
     }
@@ -208,8 +307,9 @@ public:
 
     PointIdList radius(PointId idx, double const& r) const
     {
-        double x = m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
+        const double *p = coords(idx);
+        double x = p[0];
+        double y = p[1];
 
         return radius(x, y, r);
     }
@@ -221,6 +321,30 @@ public:
 
         return radius(x, y, r);
     }
+
+    /**
+      Find the k nearest neighbors of each of a list of points in the
+      view.  Each point is its own nearest neighbor.
+
+      \param ids  IDs of the query points.
+      \param k  Number of neighbors to find for each point.
+      \param threads  Number of threads on which to run the queries.
+      \return  Neighbors of each query point.
+    */
+    NeighborResults knnSearch(const PointIdList& ids, point_count_t k,
+        int threads = 1) const;
+
+    /**
+      Find the neighbors within a radius of each of a list of points in
+      the view.
+
+      \param ids  IDs of the query points.
+      \param r  Search radius.
+      \param threads  Number of threads on which to run the queries.
+      \return  Neighbors of each query point.
+    */
+    NeighborResults radius(const PointIdList& ids, double r,
+        int threads = 1) const;
 };
 
 class PDAL_DLL KD3Index : public KDIndex<3>
@@ -291,9 +415,10 @@ public:
 
     PointIdList neighbors(PointId idx, point_count_t k, size_t stride=1) const
     {
-        double x = m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = m_buf.getFieldAs<double>(Dimension::Id::Z, idx);
+        const double *p = coords(idx);
+        double x = p[0];
+        double y = p[1];
+        double z = p[2];
 
         return neighbors(x, y, z, k, stride);
     }
@@ -326,9 +451,10 @@ public:
     void knnSearch(PointId idx, point_count_t k, PointIdList *indices,
         std::vector<double> *sqr_dists) const
     {
-        double x = m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = m_buf.getFieldAs<double>(Dimension::Id::Z, idx);
+        const double *p = coords(idx);
+        double x = p[0];
+        double y = p[1];
+        double z = p[2];
 
         knnSearch(x, y, z, k, indices, sqr_dists);
     }
@@ -367,9 +493,10 @@ public:
 
     PointIdList radius(PointId idx, double r) const
     {
-        double x = m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = m_buf.getFieldAs<double>(Dimension::Id::Z, idx);
+        const double *p = coords(idx);
+        double x = p[0];
+        double y = p[1];
+        double z = p[2];
 
         return radius(x, y, z, r);
     }
@@ -382,13 +509,38 @@ public:
 
         return radius(x, y, z, r);
     }
+
+    /**
+      Find the k nearest neighbors of each of a list of points in the
+      view.  Each point is its own nearest neighbor.
+
+      \param ids  IDs of the query points.
+      \param k  Number of neighbors to find for each point.
+      \param threads  Number of threads on which to run the queries.
+      \return  Neighbors of each query point.
+    */
+    NeighborResults knnSearch(const PointIdList& ids, point_count_t k,
+        int threads = 1) const;
+
+    /**
+      Find the neighbors within a radius of each of a list of points in
+      the view.
+
+      \param ids  IDs of the query points.
+      \param r  Search radius.
+      \param threads  Number of threads on which to run the queries.
+      \return  Neighbors of each query point.
+    */
+    NeighborResults radius(const PointIdList& ids, double r,
+        int threads = 1) const;
 };
 
-class KDFlexIndex
+class PDAL_DLL KDFlexIndex
 {
 protected:
     const PointView& m_buf;
     const Dimension::IdList& m_dims;
+    std::vector<double> m_coords;
 
     typedef nanoflann::KDTreeSingleIndexAdaptor<
         nanoflann::L2_Simple_Adaptor<double, KDFlexIndex, double>, KDFlexIndex,
@@ -405,8 +557,21 @@ public:
 
     void build()
     {
+        // Copy the values of the dimensions into a packed array so that
+        // building and searching the tree don't go through the point view.
+        const size_t numDims = m_dims.size();
+        const point_count_t n = m_buf.size();
+        std::vector<double> vals(n);
+        m_coords.resize(n * numDims);
+        for (size_t i = 0; i < numDims; ++i)
+        {
+            m_buf.getFieldArray(m_dims[i], 0, n, vals.data());
+            for (PointId idx = 0; idx < n; ++idx)
+                m_coords[idx * numDims + i] = vals[idx];
+        }
+
         m_index.reset(
-            new my_kd_tree_t(m_dims.size(), *this,
+            new my_kd_tree_t(numDims, *this,
                              nanoflann::KDTreeSingleIndexAdaptorParams(100)));
         m_index->buildIndex();
     }
@@ -420,6 +585,11 @@ public:
     {
     }
 
+    const double *coords(PointId idx) const
+    {
+        return m_coords.data() + idx * m_dims.size();
+    }
+
     PointIdList radius(PointId idx, double r) const
     {
         PointIdList output;
@@ -427,38 +597,44 @@ public:
         nanoflann::SearchParams params;
         params.sorted = true;
 
-        std::vector<double> pt;
-        for (auto const& dim : m_dims)
-        {
-            double val = m_buf.getFieldAs<double>(dim, idx);
-            pt.push_back(val);
-        }
-
         // Our distance metric is square distance, so we use the square of
         // the radius.
         const std::size_t count =
-            m_index->radiusSearch(&pt[0], r * r, ret_matches, params);
+            m_index->radiusSearch(coords(idx), r * r, ret_matches, params);
 
         for (std::size_t i = 0; i < count; ++i)
             output.push_back(ret_matches[i].first);
         return output;
     }
 
+    /**
+      Find the neighbors within a radius of each of a list of points in
+      the view.
+
+      \param ids  IDs of the query points.
+      \param r  Search radius.
+      \param threads  Number of threads on which to run the queries.
+      \return  Neighbors of each query point.
+    */
+    NeighborResults radius(const PointIdList& ids, double r,
+        int threads = 1) const;
+
     inline double kdtree_get_pt(const PointId idx, int dim) const
     {
         if (idx >= m_buf.size())
             return 0.0;
 
-        return m_buf.getFieldAs<double>(m_dims[dim], idx);
+        return coords(idx)[dim];
     }
 
     inline double kdtree_distance(const double* p1, const PointId idx,
                                   size_t /*numDims*/) const
     {
+        const double *p2 = coords(idx);
         double result(0.0);
         for (size_t i = 0; i < m_dims.size(); ++i)
         {
-            double d = p1[i] - m_buf.getFieldAs<double>(m_dims[i], idx);
+            double d = p1[i] - p2[i];
             result += d * d;
         }
 
@@ -485,9 +661,10 @@ public:
 
             for (PointId i = 0; i < m_buf.size(); ++i)
             {
+                const double *p = coords(i);
                 for (size_t j = 0; j < m_dims.size(); ++j)
                 {
-                    double val = m_buf.getFieldAs<double>(m_dims[j], i);
+                    double val = p[j];
                     if (val < bb[j].low)
                         bb[j].low = val;
                     if (val > bb[j].high)
@@ -503,128 +680,4 @@ private:
     KDFlexIndex& operator=(KDFlexIndex&);
 };
 
-template<>
-inline
-double KDIndex<2>::kdtree_get_pt(const PointId idx, int dim) const
-{
-    if (idx >= m_buf.size())
-        return 0.0;
-
-    Dimension::Id id = Dimension::Id::Unknown;
-    switch (dim)
-    {
-    case 0:
-        id = Dimension::Id::X;
-        break;
-    case 1:
-        id = Dimension::Id::Y;
-        break;
-    default:
-        throw pdal_error("kdtree_get_pt: Request for invalid dimension "
-            "from nanoflann");
-    }
-    return m_buf.getFieldAs<double>(id, idx);
-}
-
-template<>
-inline
-double KDIndex<3>::kdtree_get_pt(const PointId idx, int dim) const
-{
-    if (idx >= m_buf.size())
-        return 0.0;
-
-    Dimension::Id id = Dimension::Id::Unknown;
-    switch (dim)
-    {
-    case 0:
-        id = Dimension::Id::X;
-        break;
-    case 1:
-        id = Dimension::Id::Y;
-        break;
-    case 2:
-        id = Dimension::Id::Z;
-        break;
-    default:
-        throw pdal_error("kdtree_get_pt: Request for invalid dimension "
-            "from nanoflann");
-    }
-    return m_buf.getFieldAs<double>(id, idx);
-}
-
-// nanoflann hands us a vector that represents the position of p1.  We fetch
-// the position of p2 and and compute the square distance.
-template<>
-inline double KDIndex<2>::kdtree_distance(const double *p1, const PointId idx,
-    size_t /*numDims*/) const
-{
-    double d0 = p1[0] - m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-    double d1 = p1[1] - m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
-
-    return (d0 * d0 + d1 * d1);
-}
-
-template<>
-inline double KDIndex<3>::kdtree_distance(const double *p1, const PointId idx,
-    size_t /*numDims*/) const
-{
-    double d0 = p1[0] - m_buf.getFieldAs<double>(Dimension::Id::X, idx);
-    double d1 = p1[1] - m_buf.getFieldAs<double>(Dimension::Id::Y, idx);
-    double d2 = p1[2] - m_buf.getFieldAs<double>(Dimension::Id::Z, idx);
-
-    return (d0 * d0 + d1 * d1 + d2 * d2);
-}
-
-template<>
-template <class BBOX>
-bool KDIndex<2>::kdtree_get_bbox(BBOX& bb) const
-{
-    if (m_buf.empty())
-    {
-        bb[0].low = 0.0;
-        bb[0].high = 0.0;
-        bb[1].low = 0.0;
-        bb[1].high = 0.0;
-    }
-    else
-    {
-        BOX2D bounds;
-        calculateBounds(m_buf, bounds);
-
-        bb[0].low = bounds.minx;
-        bb[0].high = bounds.maxx;
-        bb[1].low = bounds.miny;
-        bb[1].high = bounds.maxy;
-    }
-    return true;
-}
-
-template<>
-template <class BBOX>
-bool KDIndex<3>::kdtree_get_bbox(BBOX& bb) const
-{
-    if (m_buf.empty())
-    {
-        bb[0].low = 0.0;
-        bb[0].high = 0.0;
-        bb[1].low = 0.0;
-        bb[1].high = 0.0;
-        bb[2].low = 0.0;
-        bb[2].high = 0.0;
-    }
-    else
-    {
-        BOX3D bounds;
-        calculateBounds(m_buf, bounds);
-
-        bb[0].low = bounds.minx;
-        bb[0].high = bounds.maxx;
-        bb[1].low = bounds.miny;
-        bb[1].high = bounds.maxy;
-        bb[2].low = bounds.minz;
-        bb[2].high = bounds.maxz;
-    }
-    return true;
-}
-
 } // namespace pdal
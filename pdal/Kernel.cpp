@@ -42,6 +42,7 @@
 #include <pdal/StageFactory.hpp>
 #include <pdal/util/Algorithm.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/private/Executor.hpp>
 
 #include <pdal/pdal_config.hpp>
 
@@ -51,7 +52,7 @@
 namespace pdal
 {
 
-Kernel::Kernel() : m_showTime(false), m_hardCoreDebug(false)
+Kernel::Kernel() : m_showTime(false), m_hardCoreDebug(false), m_threads(0)
 {}
 
 
@@ -224,6 +225,14 @@ int Kernel::run(const StringList& cmdArgs, LogPtr& log)
         return 1;
     }
 
+    // The shared executor is created on first use, so its size has to be
+    // set before anything runs.
+    if (m_threads)
+    {
+        Executor::setThreads(m_threads);
+        m_manager.setThreads(m_threads);
+    }
+
     int startup_status = doStartup();
     if (startup_status)
         return startup_status;
@@ -309,6 +318,9 @@ void Kernel::addBasicSwitches(ProgramArgs& args)
         "Enable developer debug (don't trap exceptions)", m_hardCoreDebug);
     args.add("label", "A string to label the process with", m_label);
     args.add("driver", "Override reader driver", m_driverOverride);
+    args.add("threads", "Number of threads used to process points.  "
+        "Defaults to the value of PDAL_NUM_THREADS or one per core.",
+        m_threads);
     args.add("help", "Print help and exit", s_help);
 }
 
@@ -125,6 +125,7 @@ private:
     bool m_showTime;
     bool m_hardCoreDebug;
     std::string m_label;
+    size_t m_threads;
 };
 
 PDAL_DLL std::ostream& operator<<(std::ostream& ostr, const Kernel&);
@@ -60,7 +60,8 @@ Log::Log(std::string const& leaderString, std::string const& outputName,
         m_log = Utils::createFile(outputName);
         m_deleteStreamOnCleanup = true;
     }
-    m_leaders.push(leaderString);
+    m_owner = std::this_thread::get_id();
+    m_leaders[m_owner].push(leaderString);
     if (m_timing)
         m_start = m_clock.now();
 }
@@ -72,7 +73,8 @@ Log::Log(std::string const& leaderString, std::ostream* v, bool timing)
     , m_timing(timing)
 {
     m_log = v;
-    m_leaders.push(leaderString);
+    m_owner = std::this_thread::get_id();
+    m_leaders[m_owner].push(leaderString);
     if (m_timing)
         m_start = m_clock.now();
 }
@@ -101,6 +103,40 @@ Log::~Log()
 }
 
 
+void Log::pushLeader(const std::string& leader)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_leaders[std::this_thread::get_id()].push(leader);
+}
+
+
+std::string Log::leader() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_leaders.find(std::this_thread::get_id());
+    if (it == m_leaders.end() || it->second.empty())
+        it = m_leaders.find(m_owner);
+    if (it == m_leaders.end() || it->second.empty())
+        return std::string();
+    return it->second.top();
+}
+
+
+void Log::popLeader()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_leaders.find(std::this_thread::get_id());
+    if (it == m_leaders.end())
+        return;
+    if (!it->second.empty())
+        it->second.pop();
+    // Drop the stacks of other threads once they're empty, since thread ids
+    // may be reused.
+    if (it->second.empty() && it->first != m_owner)
+        m_leaders.erase(it);
+}
+
+
 void Log::floatPrecision(int level)
 {
     m_log->setf(std::ios_base::fixed, std::ios_base::floatfield);
@@ -35,9 +35,12 @@
 #pragma once
 
 #include <cassert>
+#include <map>
 #include <memory> // shared_ptr
+#include <mutex>
 #include <stack>
 #include <chrono>
+#include <thread>
 
 #include <pdal/pdal_internal.hpp>
 #include <pdal/util/NullOStream.hpp>
@@ -104,22 +107,18 @@ public:
     void setLeader(const std::string& leader)
         { pushLeader(leader); }
 
-    /// Push the leader string onto the stack.
+    /// Push the leader string onto the stack.  Each thread has a stack of
+    /// its own.  A thread that hasn't pushed a leader uses the stack of the
+    /// thread that created the log.
     /// \param  leader  Leader string
-    void pushLeader(const std::string& leader)
-        { m_leaders.push(leader); }
+    void pushLeader(const std::string& leader);
 
     /// Get the leader string.
     /// \return  The current leader string.
-    std::string leader() const
-        { return m_leaders.empty() ? std::string() : m_leaders.top(); }
+    std::string leader() const;
 
     /// Pop the current leader string.
-    void popLeader()
-    {
-        if (!m_leaders.empty())
-            m_leaders.pop();
-    }
+    void popLeader();
 
     /// @return A string representing the LogLevel
     std::string getLevelString(LogLevel v) const;
@@ -155,7 +154,9 @@ private:
 
     LogLevel m_level;
     bool m_deleteStreamOnCleanup;
-    std::stack<std::string> m_leaders;
+    std::map<std::thread::id, std::stack<std::string>> m_leaders;
+    std::thread::id m_owner;
+    mutable std::mutex m_mutex;
     NullOStream m_nullStream;
     bool m_timing;
     std::chrono::steady_clock m_clock;
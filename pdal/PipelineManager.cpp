@@ -36,6 +36,8 @@
 #include <pdal/StageFactory.hpp>
 #include <pdal/PipelineReaderJSON.hpp>
 #include <pdal/PDALUtils.hpp>
+#include <pdal/Reader.hpp>
+#include <pdal/Writer.hpp>
 #include <pdal/util/Algorithm.hpp>
 #include <pdal/util/FileUtils.hpp>
 
@@ -46,10 +48,12 @@ namespace pdal
 
 PipelineManager::PipelineManager(point_count_t streamLimit) :
     m_factory(new StageFactory),
-    m_tablePtr(new PointTable()), m_table(*m_tablePtr),
+    m_tablePtr(new PointTable()),
+    m_table(m_tablePtr.get()),
     m_streamTablePtr(new FixedPointTable(streamLimit)),
     m_streamTable(*m_streamTablePtr),
-    m_progressFd(-1), m_input(nullptr)
+    m_progressFd(-1), m_threads(1), m_readAhead(0), m_profile(false),
+    m_input(nullptr)
 {}
 
 
@@ -59,6 +63,29 @@ PipelineManager::~PipelineManager()
 }
 
 
+void PipelineManager::setBlockAllocation(point_count_t blockPtCnt,
+    BlockAllocator& allocator)
+{
+    m_tablePtr.reset(new PointTable(blockPtCnt, allocator));
+    m_table = m_tablePtr.get();
+}
+
+
+void PipelineManager::setOutOfCore(std::size_t residentBytes,
+    const std::string& tempDir)
+{
+    m_tablePtr.reset(new MappedPointTable(residentBytes, tempDir));
+    m_table = m_tablePtr.get();
+}
+
+
+void PipelineManager::setColumnStorage()
+{
+    m_tablePtr.reset(new ColumnPointTable);
+    m_table = m_tablePtr.get();
+}
+
+
 void PipelineManager::readPipeline(std::istream& input)
 {
     std::istreambuf_iterator<char> eos;
@@ -204,7 +231,60 @@ void PipelineManager::prepare() const
     validateStageOptions();
     Stage *s = getStage();
     if (s)
-       s->prepare(m_table);
+    {
+        pushdownDimensions(*s);
+        s->prepare(*m_table);
+    }
+}
+
+
+// Tell the readers of the pipeline ending at 'leaf' which dimensions
+// are used by its other stages so that they can avoid reading the rest.
+// Readers are only limited when the pipeline ends in a writer and every
+// other stage reports the dimensions it uses.  Otherwise the caller gets
+// the resulting views, which need all dimensions.
+void PipelineManager::pushdownDimensions(Stage& leaf) const
+{
+    std::vector<Stage *> stages;
+    std::vector<Stage *> pending { &leaf };
+    while (pending.size())
+    {
+        Stage *s = pending.back();
+        pending.pop_back();
+        if (Utils::contains(stages, s))
+            continue;
+        stages.push_back(s);
+        for (Stage *in : s->getInputs())
+            pending.push_back(in);
+    }
+
+    std::vector<Reader *> readers;
+    StringList dims;
+    bool limit = (dynamic_cast<Writer *>(&leaf) != nullptr);
+    for (Stage *s : stages)
+    {
+        Reader *r = dynamic_cast<Reader *>(s);
+        if (r)
+            readers.push_back(r);
+        else if (limit && !s->findUsedDimensions(dims))
+            limit = false;
+    }
+
+    for (Reader *r : readers)
+    {
+        if (limit)
+            r->setUsedDims(dims);
+        else
+            r->clearUsedDims();
+    }
+    if (limit && readers.size() && m_log)
+    {
+        std::ostream& out = m_log->get(LogLevel::Debug);
+        out << "Readers limited to dimensions:";
+        for (const std::string& dim : dims)
+            out << " " << dim;
+        out << std::endl;
+    }
 }
 
 
@@ -216,6 +296,7 @@ PipelineManager::ExecResult PipelineManager::execute(ExecMode mode)
     Stage *s = getStage();
     if (!s)
         return result;
+    pushdownDimensions(*s);
                 
     if (mode == ExecMode::PreferStream)
     {
@@ -239,6 +320,9 @@ PipelineManager::ExecResult PipelineManager::execute(ExecMode mode)
             goto next;
         }
         // We can stream.
+        s->setThreads(m_threads);
+        s->setReadAhead(m_readAhead);
+        s->setProfiling(m_profile);
         s->execute(m_streamTable);
         result.m_mode = ExecMode::Stream;
         return result;
@@ -250,14 +334,19 @@ PipelineManager::ExecResult PipelineManager::execute(ExecMode mode)
         if (s->pipelineStreamable())
         {
             s->prepare(m_streamTable);
+            s->setThreads(m_threads);
+            s->setReadAhead(m_readAhead);
+            s->setProfiling(m_profile);
             s->execute(m_streamTable);
             result.m_mode = ExecMode::Stream;
         }
     }
     else if (mode == ExecMode::Standard)
     {
-        s->prepare(m_table);
-        m_viewSet = s->execute(m_table);
+        s->prepare(*m_table);
+        s->setThreads(m_threads);
+        s->setProfiling(m_profile);
+        m_viewSet = s->execute(*m_table);
         point_count_t cnt = 0;
         for (auto pi = m_viewSet.begin(); pi != m_viewSet.end(); ++pi)
         {
@@ -284,6 +373,9 @@ void PipelineManager::executeStream(StreamPointTable& table)
         return;
 
     s->prepare(table);
+    s->setThreads(m_threads);
+    s->setReadAhead(m_readAhead);
+    s->setProfiling(m_profile);
     s->execute(table);
 }
 
@@ -300,6 +392,24 @@ MetadataNode PipelineManager::getMetadata() const
 }
 
 
+MetadataNode PipelineManager::getProfile() const
+{
+    MetadataNode output("profile");
+
+    for (auto s : m_stages)
+    {
+        MetadataNode profile = s->getMetadata().findChild("profile");
+        if (!profile.valid())
+            continue;
+        MetadataNode stage = output.addList("stages");
+        stage.add("name", s->getName());
+        stage.add("tag", s->tag());
+        stage.add(profile.clone("profile"));
+    }
+    return output;
+}
+
+
 Stage& PipelineManager::makeReader(const std::string& inputFile,
     std::string driver)
 {
@@ -80,6 +80,41 @@ public:
     void setProgressFd(int fd)
         { m_progressFd = fd; }
 
+    // Set the number of threads used to execute the pipeline.
+    // See Stage::setThreads().
+    void setThreads(size_t threads)
+        { m_threads = threads; }
+
+    // Set the number of tables the reader fills ahead of the rest of the
+    // pipeline in stream mode.  See Stage::setReadAhead().
+    void setReadAhead(size_t chunks)
+        { m_readAhead = chunks; }
+
+    // Enable profiling of the stages of the pipeline when it's executed.
+    // See Stage::setProfiling() and getProfile().
+    void setProfiling(bool profile)
+        { m_profile = profile; }
+
+    // Set the number of points in each block of memory allocated for
+    // standard-mode execution and the allocator from which blocks are
+    // obtained.  By default blocks come from the heap.  To reuse memory
+    // across executions, pass the same pooling allocator to each manager.
+    // The allocator must outlive the manager.  Must be called before the
+    // pipeline is prepared.
+    void setBlockAllocation(point_count_t blockPtCnt,
+        BlockAllocator& allocator);
+
+    // Store point data for standard-mode execution in a memory-mapped
+    // temporary file rather than on the heap.  Must be called before the
+    // pipeline is prepared.  See MappedPointTable.
+    void setOutOfCore(std::size_t residentBytes,
+        const std::string& tempDir = "");
+
+    // Store point data for standard-mode execution with the values of each
+    // dimension in a separate array.  Must be called before the pipeline is
+    // prepared.  See ColumnPointTable.
+    void setColumnStorage();
+
     void readPipeline(std::istream& input);
     void readPipeline(const std::string& filename);
 
@@ -136,9 +171,12 @@ public:
 
     // Get the point table data.
     PointTableRef pointTable() const
-        { return m_table; }
+        { return *m_table; }
 
     MetadataNode getMetadata() const;
+    // Get the profile of each stage collected during the last execution
+    // when profiling was enabled.
+    MetadataNode getProfile() const;
     Options& commonOptions()
         { return m_commonOptions; }
     OptionsMap& stageOptions()
@@ -153,11 +191,12 @@ public:
 
 private:
     void setOptions(Stage& stage, const Options& addOps);
+    void pushdownDimensions(Stage& leaf) const;
     Options stageOptions(Stage& stage);
 
     std::unique_ptr<StageFactory> m_factory;
-    std::unique_ptr<PointTable> m_tablePtr;
-    PointTableRef m_table;
+    std::unique_ptr<BasePointTable> m_tablePtr;
+    BasePointTable *m_table;
     std::unique_ptr<FixedPointTable> m_streamTablePtr;
     StreamPointTable& m_streamTable;
     Options m_commonOptions;
@@ -165,6 +204,9 @@ private:
     PointViewSet m_viewSet;
     std::vector<Stage*> m_stages; // stage observer, never owner
     int m_progressFd;
+    size_t m_threads;
+    size_t m_readAhead;
+    bool m_profile;
     std::istream *m_input;
     LogPtr m_log;
 
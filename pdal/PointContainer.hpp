@@ -51,6 +51,26 @@ private:
         const void *val) = 0;
     virtual void getFieldInternal(Dimension::Id dim, PointId idx,
         void *val) const = 0;
+    // Copy the values of a dimension for the existing points [idx,
+    // idx + count) to or from a buffer of values of the dimension's type.
+    // Containers that store values next to each other override these to
+    // avoid a call for each point.
+    virtual void getFieldRangeInternal(Dimension::Id dim, PointId idx,
+        point_count_t count, void *val) const
+    {
+        const size_t size = layout()->dimSize(dim);
+        char *p = (char *)val;
+        for (PointId i = idx; i < idx + count; ++i, p += size)
+            getFieldInternal(dim, i, p);
+    }
+    virtual void setFieldRangeInternal(Dimension::Id dim, PointId idx,
+        point_count_t count, const void *val)
+    {
+        const size_t size = layout()->dimSize(dim);
+        const char *p = (const char *)val;
+        for (PointId i = idx; i < idx + count; ++i, p += size)
+            setFieldInternal(dim, i, p);
+    }
     virtual void swapItems(PointId id1, PointId id2)
         { throw pdal_error("Can't swap items in this container."); }
     virtual void setItem(PointId dst, PointId src)
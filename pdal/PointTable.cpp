@@ -35,9 +35,65 @@
 #include <pdal/ArtifactManager.hpp>
 #include <pdal/PointTable.hpp>
 
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace pdal
 {
 
+namespace
+{
+
+// Copy values of 'size' bytes between buffers whose values are 'srcStride'
+// and 'dstStride' bytes apart.
+template<size_t SIZE>
+void copyStrided(const char *src, size_t srcStride, char *dst,
+    size_t dstStride, point_count_t count)
+{
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        std::memcpy(dst, src, SIZE);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+void copyStrided(const char *src, size_t srcStride, char *dst,
+    size_t dstStride, point_count_t count, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        copyStrided<1>(src, srcStride, dst, dstStride, count);
+        break;
+    case 2:
+        copyStrided<2>(src, srcStride, dst, dstStride, count);
+        break;
+    case 4:
+        copyStrided<4>(src, srcStride, dst, dstStride, count);
+        break;
+    case 8:
+        copyStrided<8>(src, srcStride, dst, dstStride, count);
+        break;
+    default:
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            std::memcpy(dst, src, size);
+            src += srcStride;
+            dst += dstStride;
+        }
+        break;
+    }
+}
+
+} // unnamed namespace
+
 BasePointTable::BasePointTable(PointLayout& layout) :
     m_metadata(new Metadata()), m_layoutRef(layout)
 {}
@@ -99,21 +155,61 @@ void SimplePointTable::getFieldInternal(Dimension::Id id, PointId idx,
 }
 
 
+// Points in a block are stored one after another, so the values of a
+// dimension are copied a block at a time.
+void SimplePointTable::getFieldRangeInternal(Dimension::Id id, PointId idx,
+    point_count_t count, void *value) const
+{
+    const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+    const size_t pointSize = m_layoutRef.pointSize();
+    const point_count_t blockCnt = blockPointCount();
+    char *dst = (char *)value;
+    while (count)
+    {
+        point_count_t n = blockCnt ?
+            (std::min)(count, blockCnt - idx % blockCnt) : count;
+        copyStrided(getDimension(d, idx), pointSize, dst, d->size(), n,
+            d->size());
+        dst += n * d->size();
+        idx += n;
+        count -= n;
+    }
+}
+
+
+void SimplePointTable::setFieldRangeInternal(Dimension::Id id, PointId idx,
+    point_count_t count, const void *value)
+{
+    const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+    const size_t pointSize = m_layoutRef.pointSize();
+    const point_count_t blockCnt = blockPointCount();
+    const char *src = (const char *)value;
+    while (count)
+    {
+        point_count_t n = blockCnt ?
+            (std::min)(count, blockCnt - idx % blockCnt) : count;
+        copyStrided(src, d->size(), getDimension(d, idx), pointSize, n,
+            d->size());
+        src += n * d->size();
+        idx += n;
+        count -= n;
+    }
+}
+
+
+const point_count_t PointTable::DefaultBlockPtCnt;
+
 PointTable::~PointTable()
 {
+    size_t size = pointsToBytes(m_blockPtCnt);
     for (auto vi = m_blocks.begin(); vi != m_blocks.end(); ++vi)
-        delete [] *vi;
+        m_allocator.release(*vi, size);
 }
 
 PointId PointTable::addPoint()
 {
     if (m_numPts % m_blockPtCnt == 0)
-    {
-        size_t size = pointsToBytes(m_blockPtCnt);
-        char *buf = new char[size];
-        memset(buf, 0, size);
-        m_blocks.push_back(buf);
-    }
+        m_blocks.push_back(m_allocator.allocate(pointsToBytes(m_blockPtCnt)));
     return m_numPts++;
 }
 
@@ -142,6 +238,263 @@ char *ContiguousPointTable::getPoint(PointId idx)
 }
 
 
+MappedPointTable::MappedPointTable(std::size_t residentBytes,
+        const std::string& tempDir) :
+    SimplePointTable(m_layout), m_numPts(0), m_residentBytes(residentBytes),
+    m_released(0), m_tempDir(tempDir), m_fd(-1)
+{
+#ifdef _WIN32
+    throw pdal_error("MappedPointTable isn't supported on this platform.");
+#endif
+}
+
+
+MappedPointTable::~MappedPointTable()
+{
+#ifndef _WIN32
+    size_t size = pointsToBytes(m_blockPtCnt);
+    for (char *block : m_blocks)
+        if (block)
+            ::munmap(block, size);
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+
+PointId MappedPointTable::addPoint()
+{
+    if (m_numPts % m_blockPtCnt == 0)
+        addBlock();
+    return m_numPts++;
+}
+
+
+char *MappedPointTable::getPoint(PointId idx)
+{
+    char *buf = m_blocks[idx / m_blockPtCnt];
+    return buf + pointsToBytes(idx % m_blockPtCnt);
+}
+
+
+void MappedPointTable::addBlock()
+{
+#ifndef _WIN32
+    // The file is removed as soon as it's created so that it goes away
+    // when the table is destroyed, even if we crash.
+    if (m_fd < 0)
+    {
+        std::string dir(m_tempDir);
+        if (dir.empty())
+            Utils::getenv("TMPDIR", dir);
+        if (dir.empty())
+            dir = "/tmp";
+        std::string filename = dir + "/pdal_points_XXXXXX";
+        std::vector<char> name(filename.begin(), filename.end());
+        name.push_back(0);
+        m_fd = ::mkstemp(name.data());
+        if (m_fd < 0)
+            throw pdal_error("Unable to create point table file in '" + dir +
+                "': " + std::strerror(errno) + ".");
+        ::unlink(name.data());
+    }
+
+    // Block sizes are a multiple of 65536 bytes, so block offsets are
+    // always page-aligned.
+    size_t size = pointsToBytes(m_blockPtCnt);
+    if (size == 0)
+    {
+        m_blocks.push_back(nullptr);
+        return;
+    }
+    off_t offset = (off_t)(m_blocks.size() * size);
+    if (::ftruncate(m_fd, offset + size) != 0)
+        throw pdal_error(std::string("Unable to extend point table file: ") +
+            std::strerror(errno) + ".");
+    void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        m_fd, offset);
+    if (addr == MAP_FAILED)
+        throw pdal_error(std::string("Unable to map point table file: ") +
+            std::strerror(errno) + ".");
+    m_blocks.push_back(reinterpret_cast<char *>(addr));
+
+    // Push the oldest blocks out of memory when over budget.
+    if (m_residentBytes)
+    {
+        size_t maxResident = (std::max)(m_residentBytes / size, (size_t)1);
+        while (m_blocks.size() - m_released > maxResident)
+            releaseBlock(m_released++);
+    }
+#endif
+}
+
+
+// Write a block back to the file and drop its pages.  The block stays
+// mapped and is read back from the file if it's accessed again.
+void MappedPointTable::releaseBlock(std::size_t block)
+{
+#ifndef _WIN32
+    size_t size = pointsToBytes(m_blockPtCnt);
+    char *addr = m_blocks[block];
+    ::msync(addr, size, MS_SYNC);
+    ::madvise(addr, size, MADV_DONTNEED);
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(m_fd, (off_t)(block * size), size, POSIX_FADV_DONTNEED);
+#endif
+#endif
+}
+
+
+ColumnPointTable::~ColumnPointTable()
+{}
+
+
+void ColumnPointTable::finalize()
+{
+    BasePointTable::finalize();
+    if (m_columnIndex.empty())
+        createColumns();
+}
+
+
+void ColumnPointTable::createColumns()
+{
+    const Dimension::IdList& dims = m_layout.dims();
+
+    int maxId = 0;
+    for (Dimension::Id id : dims)
+        maxId = (std::max)(maxId, (int)Utils::toNative(id));
+
+    m_columnIndex.assign(maxId + 1, -1);
+    m_columns.resize(dims.size());
+    for (size_t i = 0; i < dims.size(); ++i)
+    {
+        m_columnIndex[Utils::toNative(dims[i])] = (int)i;
+        m_columns[i].resize(m_layout.dimSize(dims[i]) * m_numPts);
+    }
+}
+
+
+void ColumnPointTable::reserve(point_count_t numPts)
+{
+    if (m_columnIndex.empty())
+        createColumns();
+    const Dimension::IdList& dims = m_layout.dims();
+    for (size_t i = 0; i < dims.size(); ++i)
+        m_columns[i].reserve(m_layout.dimSize(dims[i]) * numPts);
+}
+
+
+std::size_t ColumnPointTable::memoryUsage() const
+{
+    std::size_t size = 0;
+    for (const std::vector<char>& col : m_columns)
+        size += col.capacity();
+    return size;
+}
+
+
+PointId ColumnPointTable::addPoint()
+{
+    if (m_columnIndex.empty())
+        createColumns();
+    const Dimension::IdList& dims = m_layout.dims();
+    for (size_t i = 0; i < dims.size(); ++i)
+        m_columns[i].resize(m_columns[i].size() + m_layout.dimSize(dims[i]));
+    return m_numPts++;
+}
+
+
+// Points aren't stored packed, so the fields of a point are gathered into
+// a buffer of the calling thread.
+char *ColumnPointTable::getPoint(PointId idx)
+{
+    thread_local std::vector<char> buf;
+
+    buf.resize(m_layout.pointSize());
+    for (Dimension::Id id : m_layout.dims())
+        getFieldInternal(id, idx, buf.data() + m_layout.dimOffset(id));
+    return buf.data();
+}
+
+
+int ColumnPointTable::columnIndex(Dimension::Id id) const
+{
+    size_t pos = Utils::toNative(id);
+    if (pos >= m_columnIndex.size() || m_columnIndex[pos] < 0)
+        throw pdal_error("ColumnPointTable: dimension '" +
+            m_layout.dimName(id) + "' isn't part of the table.");
+    return m_columnIndex[pos];
+}
+
+
+void ColumnPointTable::checkColumnType(Dimension::Id id,
+    Dimension::Type type) const
+{
+    if (m_layout.dimType(id) != type)
+        throw pdal_error("ColumnPointTable: dimension '" +
+            m_layout.dimName(id) + "' has type " +
+            Dimension::interpretationName(m_layout.dimType(id)) +
+            ", not " + Dimension::interpretationName(type) + ".");
+}
+
+
+char *ColumnPointTable::columnData(Dimension::Id id)
+{
+    if (m_columnIndex.empty())
+        createColumns();
+    return m_columns[columnIndex(id)].data();
+}
+
+
+const char *ColumnPointTable::columnData(Dimension::Id id) const
+{
+    return m_columns.at(columnIndex(id)).data();
+}
+
+
+void ColumnPointTable::setFieldInternal(Dimension::Id id, PointId idx,
+    const void *value)
+{
+    const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+    const char *src = (const char *)value;
+    char *dst = m_columns[m_columnIndex[Utils::toNative(id)]].data() +
+        idx * d->size();
+    std::copy(src, src + d->size(), dst);
+}
+
+
+void ColumnPointTable::getFieldInternal(Dimension::Id id, PointId idx,
+    void *value) const
+{
+    const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+    const char *src = m_columns[m_columnIndex[Utils::toNative(id)]].data() +
+        idx * d->size();
+    char *dst = (char *)value;
+    std::copy(src, src + d->size(), dst);
+}
+
+
+void ColumnPointTable::getFieldRangeInternal(Dimension::Id id, PointId idx,
+    point_count_t count, void *value) const
+{
+    const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+    const char *src = m_columns[m_columnIndex[Utils::toNative(id)]].data() +
+        idx * d->size();
+    std::memcpy(value, src, count * d->size());
+}
+
+
+void ColumnPointTable::setFieldRangeInternal(Dimension::Id id, PointId idx,
+    point_count_t count, const void *value)
+{
+    const Dimension::Detail *d = m_layoutRef.dimDetail(id);
+    char *dst = m_columns[m_columnIndex[Utils::toNative(id)]].data() +
+        idx * d->size();
+    std::memcpy(dst, value, count * d->size());
+}
+
+
 MetadataNode BasePointTable::toMetadata() const
 {
     return layout()->toMetadata();
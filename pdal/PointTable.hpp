@@ -36,8 +36,10 @@
 
 #include <algorithm>
 #include <list>
+#include <string>
 #include <vector>
 
+#include "pdal/BlockAllocator.hpp"
 #include "pdal/SpatialReference.hpp"
 #include "pdal/Dimension.hpp"
 #include "pdal/PointContainer.hpp"
@@ -91,6 +93,9 @@ public:
     }
     virtual bool supportsView() const
         { return false; }
+    /// Approximate number of bytes of memory allocated to hold point data.
+    virtual std::size_t memoryUsage() const
+        { return 0; }
     MetadataNode privateMetadata(const std::string& name);
     MetadataNode toMetadata() const;
     ArtifactManager& artifactManager();
@@ -122,11 +127,21 @@ protected:
     std::size_t pointsToBytes(point_count_t numPts) const
         { return m_layoutRef.pointSize() * numPts; }
 
+    // Number of points stored one after another in each block of memory,
+    // starting at a multiple of the count.  Zero means that all points are
+    // stored in a single block.
+    virtual point_count_t blockPointCount() const
+        { return 1; }
+
 private:
     virtual void setFieldInternal(Dimension::Id id, PointId idx,
         const void *value);
     virtual void getFieldInternal(Dimension::Id id, PointId idx,
         void *value) const;
+    virtual void getFieldRangeInternal(Dimension::Id id, PointId idx,
+        point_count_t count, void *value) const;
+    virtual void setFieldRangeInternal(Dimension::Id id, PointId idx,
+        point_count_t count, const void *value);
 
     // The number of points in each memory block.
     char *getDimension(const Dimension::Detail *d, PointId idx)
@@ -147,17 +162,33 @@ private:
     // Point storage.
     std::vector<char *> m_blocks;
     point_count_t m_numPts;
-    static const point_count_t m_blockPtCnt = 65536;
+    point_count_t m_blockPtCnt;
+    BlockAllocator& m_allocator;
 
 public:
-    PointTable() : SimplePointTable(m_layout), m_numPts(0)
+    static const point_count_t DefaultBlockPtCnt = 65536;
+
+    PointTable() : SimplePointTable(m_layout), m_numPts(0),
+        m_blockPtCnt(DefaultBlockPtCnt), m_allocator(BlockAllocator::heap())
+        {}
+    /// \param blockPtCnt  Number of points stored in each block of memory.
+    /// \param allocator  Allocator from which blocks are obtained.  It must
+    ///     outlive the table.
+    PointTable(point_count_t blockPtCnt, BlockAllocator& allocator) :
+        SimplePointTable(m_layout), m_numPts(0),
+        m_blockPtCnt(blockPtCnt ? blockPtCnt : DefaultBlockPtCnt),
+        m_allocator(allocator)
         {}
     virtual ~PointTable();
     virtual bool supportsView() const
         { return true; }
+    virtual std::size_t memoryUsage() const
+        { return m_blocks.size() * pointsToBytes(m_blockPtCnt); }
 
 protected:
     virtual char *getPoint(PointId idx);
+    virtual point_count_t blockPointCount() const
+        { return m_blockPtCnt; }
 
 private:
     // Point data operations.
@@ -178,9 +209,13 @@ public:
     virtual ~ContiguousPointTable();
     virtual bool supportsView() const
         { return true; }
+    virtual std::size_t memoryUsage() const
+        { return m_buf.capacity(); }
 
 protected:
     virtual char *getPoint(PointId idx);
+    virtual point_count_t blockPointCount() const
+        { return 0; }
 
 private:
     virtual PointId addPoint();
@@ -188,6 +223,123 @@ private:
     PointLayout m_layout;
 };
 
+/// A point table whose points are stored in a temporary file that is mapped
+/// into memory.  The operating system can page point data out to the file,
+/// so the amount of data isn't limited by available memory.  Blocks of
+/// points beyond the resident budget are written back to the file and
+/// released from memory in the order they were allocated.  The budget is
+/// only enforced when blocks are allocated: a released block that is
+/// accessed again is read back into memory and isn't released a second
+/// time.
+class PDAL_DLL MappedPointTable : public SimplePointTable
+{
+public:
+    /// \param residentBytes  Approximate number of bytes of point data to
+    ///     keep in memory.  When zero, the operating system decides when
+    ///     point data is paged out.
+    /// \param tempDir  Directory in which to create the backing file.  When
+    ///     empty, the directory named by TMPDIR or /tmp is used.
+    MappedPointTable(std::size_t residentBytes = 0,
+        const std::string& tempDir = "");
+    virtual ~MappedPointTable();
+    virtual bool supportsView() const
+        { return true; }
+    virtual std::size_t memoryUsage() const
+    {
+        return (m_blocks.size() - m_released) * pointsToBytes(m_blockPtCnt);
+    }
+
+protected:
+    virtual char *getPoint(PointId idx);
+    virtual point_count_t blockPointCount() const
+        { return m_blockPtCnt; }
+
+private:
+    virtual PointId addPoint();
+    void addBlock();
+    void releaseBlock(std::size_t block);
+
+    std::vector<char *> m_blocks;
+    point_count_t m_numPts;
+    static const point_count_t m_blockPtCnt = 65536;
+    std::size_t m_residentBytes;
+    std::size_t m_released;
+    std::string m_tempDir;
+    int m_fd;
+    PointLayout m_layout;
+};
+
+/// A point table that stores the values of each dimension in a separate
+/// contiguous array (structure of arrays) rather than storing points
+/// one after another.  Algorithms that use only a few dimensions touch only
+/// the memory for those dimensions.  Packed point data
+/// (PointView::getPoint()) is a copy gathered from the columns.  It's valid
+/// until the next such call on the same thread, and changes to it aren't
+/// stored in the table.
+class PDAL_DLL ColumnPointTable : public BasePointTable
+{
+public:
+    ColumnPointTable() : BasePointTable(m_layout), m_numPts(0)
+        {}
+    virtual ~ColumnPointTable();
+    virtual bool supportsView() const
+        { return true; }
+    virtual std::size_t memoryUsage() const;
+    virtual void finalize();
+
+    /// Reserve space for a number of points in each column.
+    /// \param numPts  Number of points.
+    void reserve(point_count_t numPts);
+
+    /// Get a pointer to the values of a dimension.  Values are stored in
+    /// point ID order using the dimension's type.  The pointer is
+    /// invalidated when points are added to the table.
+    /// \param id  ID of the dimension.
+    /// \return  Pointer to the first value of the dimension.
+    char *columnData(Dimension::Id id);
+    const char *columnData(Dimension::Id id) const;
+
+    /// Get a typed pointer to the values of a dimension.  The type must
+    /// match the type of the dimension in the layout.
+    /// \param id  ID of the dimension.
+    /// \return  Pointer to the first value of the dimension.
+    template<typename T>
+    T *column(Dimension::Id id)
+    {
+        checkColumnType(id, Dimension::typeOf<T>());
+        return reinterpret_cast<T *>(columnData(id));
+    }
+    template<typename T>
+    const T *column(Dimension::Id id) const
+    {
+        checkColumnType(id, Dimension::typeOf<T>());
+        return reinterpret_cast<const T *>(columnData(id));
+    }
+
+protected:
+    virtual char *getPoint(PointId idx);
+
+private:
+    std::vector<std::vector<char>> m_columns;
+    std::vector<int> m_columnIndex;
+    point_count_t m_numPts;
+    PointLayout m_layout;
+
+    virtual PointId addPoint();
+    virtual void setFieldInternal(Dimension::Id id, PointId idx,
+        const void *value);
+    virtual void getFieldInternal(Dimension::Id id, PointId idx,
+        void *value) const;
+    virtual void getFieldRangeInternal(Dimension::Id id, PointId idx,
+        point_count_t count, void *value) const;
+    virtual void setFieldRangeInternal(Dimension::Id id, PointId idx,
+        point_count_t count, const void *value);
+
+    void createColumns();
+    int columnIndex(Dimension::Id id) const;
+    void checkColumnType(Dimension::Id id, Dimension::Type type) const;
+};
+
 /// A StreamPointTable must provide storage for point data up to its capacity.
 /// It must implement getPoint() which returns a pointer to a buffer of
 /// sufficient size to contain a point's data.  The minimum size required
@@ -234,6 +386,9 @@ public:
     point_count_t capacity() const
         { return m_capacity; }
 
+    virtual std::size_t memoryUsage() const
+        { return pointsToBytes(m_capacity); }
+
     /// During a given call to reset(), this indicates the number of points
     /// populated in the table.  This value will always be less then or equal
     /// to capacity(), and also includes skipped points.
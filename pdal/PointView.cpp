@@ -42,16 +42,17 @@
 namespace pdal
 {
 
-int PointView::m_lastId = 0;
+std::atomic<int> PointView::m_lastId(0);
 
 PointView::PointView(PointTableRef pointTable) : m_pointTable(pointTable),
-m_size(0), m_id(0)
+m_contiguous(true), m_start(0), m_size(0), m_id(0)
 {
 	m_id = ++m_lastId;
 }
 
 PointView::PointView(PointTableRef pointTable, const SpatialReference& srs) :
-	m_pointTable(pointTable), m_size(0), m_id(0), m_spatialReference(srs)
+	m_pointTable(pointTable), m_contiguous(true), m_start(0), m_size(0),
+	m_id(0), m_spatialReference(srs)
 {
 	m_id = ++m_lastId;
 }
@@ -80,9 +81,7 @@ void PointView::setFieldInternal(Dimension::Id dim, PointId idx,
     if (idx == size())
     {
         rawId = m_pointTable.addPoint();
-        m_index.push_back(rawId);
-        m_size++;
-        assert(m_temps.empty());
+        appendRaw(rawId);
     }
     else if (idx > size())
     {
@@ -92,7 +91,7 @@ void PointView::setFieldInternal(Dimension::Id dim, PointId idx,
     }
     else
     {
-        rawId = m_index[idx];
+        rawId = this->rawId(idx);
     }
     m_pointTable.setFieldInternal(dim, rawId, buf);
 }
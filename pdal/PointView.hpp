@@ -42,10 +42,14 @@
 #include <pdal/PointTable.hpp>
 #include <pdal/PointRef.hpp>
 
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <set>
 #include <deque>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
 
 //#pragma warning(disable: 4244)  // conversion from 'type1' to 'type2', possible loss of data
 
@@ -96,12 +100,34 @@ public:
     inline void appendPoint(const PointView& buffer, PointId id);
     void append(const PointView& buf)
     {
+        // Appending the points that immediately follow ours in the table
+        // leaves the view contiguous.
+        if (m_contiguous && buf.m_contiguous &&
+            (empty() || buf.m_start == m_start + size()))
+        {
+            if (empty())
+                m_start = buf.m_start;
+            m_size += buf.size();
+            clearTemps();
+            return;
+        }
+
         // We use size() instead of the index end because temp points
         // might have been placed at the end of the buffer.
         // We're essentially ditching temp points.
+        materialize();
         auto thisEnd = m_index.begin() + size();
-        auto bufEnd = buf.m_index.begin() + buf.size();
-        m_index.insert(thisEnd, buf.m_index.begin(), bufEnd);
+        if (buf.m_contiguous)
+        {
+            std::deque<PointId> ids(buf.size());
+            std::iota(ids.begin(), ids.end(), buf.m_start);
+            m_index.insert(thisEnd, ids.begin(), ids.end());
+        }
+        else
+        {
+            auto bufEnd = buf.m_index.begin() + buf.size();
+            m_index.insert(thisEnd, buf.m_index.begin(), bufEnd);
+        }
         m_size += buf.size();
         clearTemps();
     }
@@ -128,6 +154,27 @@ public:
     inline void setField(Dimension::Id dim, Dimension::Type type,
         PointId idx, const void *val);
 
+    /// Fetch the values of a dimension for a range of points, converted
+    /// to the requested type.
+    /// \param dim    Dimension to fetch.
+    /// \param begin  ID of the first point.
+    /// \param count  Number of points.
+    /// \param out    Buffer to fill.  Must have room for \a count values.
+    template<typename T>
+    void getFieldArray(Dimension::Id dim, PointId begin, point_count_t count,
+        T *out) const;
+
+    /// Set the values of a dimension for a range of points, converting
+    /// from the provided type.
+    /// \param dim    Dimension to set.
+    /// \param begin  ID of the first point.  Points are added to the view
+    ///    as necessary.
+    /// \param count  Number of points.
+    /// \param in     Buffer containing \a count values.
+    template<typename T>
+    void setFieldArray(Dimension::Id dim, PointId begin, point_count_t count,
+        const T *in);
+
     template <typename T>
     bool compare(Dimension::Id dim, PointId id1, PointId id2) const
     {
@@ -247,20 +294,28 @@ public:
     /// Provides access to the memory storing the point data.  Though this
     /// function is public, other access methods are safer and preferred.
     char *getPoint(PointId id)
-        { return m_pointTable.getPoint(m_index[id]); }
+        { return m_pointTable.getPoint(rawId(id)); }
 
     /// Provides access to the memory storing the point data.  Though this
     /// function is public, other access methods are safer and preferred.
     char *getOrAddPoint(PointId id)
     {
         if (id == size())
-        {
-            m_index.push_back(m_pointTable.addPoint());
-            ++m_size;
-            assert(m_temps.empty());
-        }
+            appendRaw(m_pointTable.addPoint());
+        else if (id > size())
+            throw std::out_of_range("PointView::getOrAddPoint: invalid "
+                "point ID.");
 
-        return m_pointTable.getPoint(m_index.at(id));
+        return m_pointTable.getPoint(rawId(id));
+    }
+
+    /// Add points to the end of the view without touching their data, so
+    /// that their fields can be set later, possibly from several threads.
+    /// \param count  Number of points to add.
+    void addPoints(point_count_t count)
+    {
+        for (point_count_t i = 0; i < count; ++i)
+            appendRaw(m_pointTable.addPoint());
     }
 
     // The standard idiom is swapping with a stack-created empty queue, but
@@ -297,9 +352,13 @@ public:
 
 protected:
     PointTableRef m_pointTable;
+    // When a view is contiguous, point N of the view is point m_start + N
+    // of the table and m_index is unused.  Otherwise m_index maps view point
+    // IDs to table point IDs.  The index might be larger than the size to
+    // support temporary point references.
+    bool m_contiguous;
+    PointId m_start;
     std::deque<PointId> m_index;
-    // The index might be larger than the size to support temporary point
-    // references.
     point_count_t m_size;
     int m_id;
     std::queue<PointId> m_temps;
@@ -309,27 +368,59 @@ protected:
     std::unique_ptr<KD2Index> m_index2;
 
 private:
-    static int m_lastId;
+    static std::atomic<int> m_lastId;
 
     template<typename T_IN, typename T_OUT>
     bool convertAndSet(Dimension::Id dim, PointId idx, T_IN in);
+    template<typename T_IN, typename T_OUT>
+    void getFieldArrayAs(Dimension::Id dim, PointId begin,
+        point_count_t count, T_OUT *out) const;
+    template<typename T_IN, typename T_OUT>
+    void getFieldArrayAs(Dimension::Id dim, PointId begin,
+        point_count_t count, T_OUT *out, std::true_type) const;
+    template<typename T_IN, typename T_OUT>
+    void getFieldArrayAs(Dimension::Id dim, PointId begin,
+        point_count_t count, T_OUT *out, std::false_type) const;
+    template<typename T_IN, typename T_OUT>
+    void setFieldArrayAs(Dimension::Id dim, PointId begin,
+        point_count_t count, const T_IN *in);
+    template<typename T_IN, typename T_OUT>
+    void setFieldArrayAs(Dimension::Id dim, PointId begin,
+        point_count_t count, const T_IN *in, std::true_type);
+    template<typename T_IN, typename T_OUT>
+    void setFieldArrayAs(Dimension::Id dim, PointId begin,
+        point_count_t count, const T_IN *in, std::false_type);
 
     virtual void setFieldInternal(Dimension::Id dim, PointId idx,
         const void *buf);
     virtual void getFieldInternal(Dimension::Id dim, PointId idx,
             void *buf) const
-        { m_pointTable.getFieldInternal(dim, m_index[idx], buf); }
+        { m_pointTable.getFieldInternal(dim, rawId(idx), buf); }
     virtual void swapItems(PointId id1, PointId id2)
     {
+        materialize();
         PointId temp = m_index[id2];
         m_index[id2] = m_index[id1];
         m_index[id1] = temp;
     }
     virtual void setItem(PointId dst, PointId src)
     {
+        materialize();
         m_index[dst] = m_index[src];
     }
 
+    PointId rawId(PointId idx) const
+        { return m_contiguous ? m_start + idx : m_index[idx]; }
+    inline void appendRaw(PointId id);
+    void materialize()
+    {
+        if (!m_contiguous)
+            return;
+        m_index.resize(m_size);
+        std::iota(m_index.begin(), m_index.end(), m_start);
+        m_contiguous = false;
+    }
+
     template<class T>
     T getFieldInternal(Dimension::Id dim, PointId pointIndex) const;
     inline PointId getTemp(PointId id);
@@ -340,7 +431,7 @@ private:
 
     // For testing only.
     PointId index(PointId id) const
-        { return m_index[id]; }
+        { return rawId(id); }
 };
 
 struct PointViewLess
@@ -583,11 +674,245 @@ void PointView::setField(Dimension::Id dim, PointId idx, T val)
     }
 }
 
+template<typename T>
+void PointView::getFieldArray(Dimension::Id dim, PointId begin,
+    point_count_t count, T *out) const
+{
+    assert(begin + count <= m_size);
+    const Dimension::Detail *dd = layout()->dimDetail(dim);
+
+    switch (dd->type())
+    {
+    case Dimension::Type::Float:
+        getFieldArrayAs<float, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Double:
+        getFieldArrayAs<double, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Signed8:
+        getFieldArrayAs<int8_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Signed16:
+        getFieldArrayAs<int16_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Signed32:
+        getFieldArrayAs<int32_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Signed64:
+        getFieldArrayAs<int64_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned8:
+        getFieldArrayAs<uint8_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned16:
+        getFieldArrayAs<uint16_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned32:
+        getFieldArrayAs<uint32_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned64:
+        getFieldArrayAs<uint64_t, T>(dim, begin, count, out);
+        break;
+    case Dimension::Type::None:
+    default:
+        std::fill(out, out + count, T(0));
+        break;
+    }
+}
+
+
+template<typename T_IN, typename T_OUT>
+void PointView::getFieldArrayAs(Dimension::Id dim, PointId begin,
+    point_count_t count, T_OUT *out) const
+{
+    getFieldArrayAs<T_IN, T_OUT>(dim, begin, count, out,
+        typename std::is_same<T_IN, T_OUT>::type());
+}
+
+
+// When the requested type matches the stored type and the view's points
+// are contiguous in the table, the table copies the values of the whole
+// range into the output buffer.
+template<typename T_IN, typename T_OUT>
+void PointView::getFieldArrayAs(Dimension::Id dim, PointId begin,
+    point_count_t count, T_OUT *out, std::true_type) const
+{
+    if (!count)
+        return;
+    if (m_contiguous)
+        m_pointTable.getFieldRangeInternal(dim, m_start + begin, count, out);
+    else
+        for (PointId idx = begin; idx < begin + count; ++idx)
+            m_pointTable.getFieldInternal(dim, rawId(idx), out++);
+}
+
+
+// Values are fetched in batches of the stored type and then converted.
+template<typename T_IN, typename T_OUT>
+void PointView::getFieldArrayAs(Dimension::Id dim, PointId begin,
+    point_count_t count, T_OUT *out, std::false_type) const
+{
+    const point_count_t BatchSize = 1024;
+    T_IN in[BatchSize];
+
+    while (count)
+    {
+        point_count_t n = (std::min)(count, BatchSize);
+        getFieldArrayAs<T_IN, T_IN>(dim, begin, n, in, std::true_type());
+        for (point_count_t i = 0; i < n; ++i)
+        {
+            if (!Utils::numericCast(in[i], *out++))
+            {
+                std::ostringstream oss;
+                oss << "Unable to fetch data and convert as requested: ";
+                oss << Dimension::name(dim) << ":" <<
+                    Dimension::interpretationName(Dimension::typeOf<T_IN>()) <<
+                    "(" << (double)in[i] << ") -> " <<
+                    Utils::typeidName<T_OUT>();
+                throw pdal_error(oss.str());
+            }
+        }
+        begin += n;
+        count -= n;
+    }
+}
+
+
+template<typename T>
+void PointView::setFieldArray(Dimension::Id dim, PointId begin,
+    point_count_t count, const T *in)
+{
+    const Dimension::Detail *dd = layout()->dimDetail(dim);
+
+    switch (dd->type())
+    {
+    case Dimension::Type::Float:
+        setFieldArrayAs<T, float>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Double:
+        setFieldArrayAs<T, double>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Signed8:
+        setFieldArrayAs<T, int8_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Signed16:
+        setFieldArrayAs<T, int16_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Signed32:
+        setFieldArrayAs<T, int32_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Signed64:
+        setFieldArrayAs<T, int64_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned8:
+        setFieldArrayAs<T, uint8_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned16:
+        setFieldArrayAs<T, uint16_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned32:
+        setFieldArrayAs<T, uint32_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned64:
+        setFieldArrayAs<T, uint64_t>(dim, begin, count, in);
+        break;
+    case Dimension::Type::None:
+        break;
+    }
+}
+
+
+template<typename T_IN, typename T_OUT>
+void PointView::setFieldArrayAs(Dimension::Id dim, PointId begin,
+    point_count_t count, const T_IN *in)
+{
+    setFieldArrayAs<T_IN, T_OUT>(dim, begin, count, in,
+        typename std::is_same<T_IN, T_OUT>::type());
+}
+
+
+// When the provided type matches the stored type, points missing from the
+// view are added first.  If the view's points are then contiguous in the
+// table, the table copies the values of the whole range from the buffer.
+template<typename T_IN, typename T_OUT>
+void PointView::setFieldArrayAs(Dimension::Id dim, PointId begin,
+    point_count_t count, const T_IN *in, std::true_type)
+{
+    if (!count)
+        return;
+    if (begin <= size())
+    {
+        while (size() < begin + count)
+            appendRaw(m_pointTable.addPoint());
+        if (m_contiguous)
+        {
+            m_pointTable.setFieldRangeInternal(dim, m_start + begin, count,
+                in);
+            return;
+        }
+    }
+
+    // setFieldInternal() adds points to the view as necessary.
+    for (PointId idx = begin; idx < begin + count; ++idx)
+        setFieldInternal(dim, idx, in++);
+}
+
+
+// Values are converted in batches of the stored type and then set.
+template<typename T_IN, typename T_OUT>
+void PointView::setFieldArrayAs(Dimension::Id dim, PointId begin,
+    point_count_t count, const T_IN *in, std::false_type)
+{
+    const point_count_t BatchSize = 1024;
+    T_OUT out[BatchSize];
+
+    while (count)
+    {
+        point_count_t n = (std::min)(count, BatchSize);
+        for (point_count_t i = 0; i < n; ++i)
+        {
+            if (!Utils::numericCast(in[i], out[i]))
+            {
+                // Values before the one that failed are set, as they
+                // would be one at a time.
+                setFieldArrayAs<T_OUT, T_OUT>(dim, begin, i, out,
+                    std::true_type());
+                std::ostringstream oss;
+                oss << "Unable to set data and convert as requested: ";
+                oss << Dimension::name(dim) << ":" <<
+                    Utils::typeidName<T_IN>() << "(" << (double)in[i] <<
+                    ") -> " <<
+                    Dimension::interpretationName(Dimension::typeOf<T_OUT>());
+                throw pdal_error(oss.str());
+            }
+        }
+        setFieldArrayAs<T_OUT, T_OUT>(dim, begin, n, out, std::true_type());
+        begin += n;
+        in += n;
+        count -= n;
+    }
+}
+
 inline void PointView::appendPoint(const PointView& buffer, PointId id)
 {
     // Invalid 'id' is a programmer error.
-    PointId rawId = buffer.m_index[id];
-    m_index.push_back(rawId);
+    appendRaw(buffer.rawId(id));
+}
+
+
+// Add a table point to the end of the view.  The view stays contiguous as
+// long as points are added in table order.
+inline void PointView::appendRaw(PointId id)
+{
+    if (m_contiguous)
+    {
+        if (m_size == 0)
+            m_start = id;
+        else if (id != m_start + m_size)
+            materialize();
+    }
+    if (!m_contiguous)
+        m_index.push_back(id);
     m_size++;
     assert(m_temps.empty());
 }
@@ -596,6 +921,8 @@ inline void PointView::appendPoint(const PointView& buffer, PointId id)
 // Make a temporary copy of a point by adding an entry to the index.
 inline PointId PointView::getTemp(PointId id)
 {
+    materialize();
+
     PointId newid;
     if (m_temps.size())
     {
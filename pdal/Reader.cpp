@@ -76,6 +76,23 @@ void Reader::setSpatialReference(MetadataNode& m, const SpatialReference& srs)
 }
 
 
+bool Reader::dimUsed(const std::string& name) const
+{
+    using namespace Dimension;
+
+    if (m_allDims)
+        return true;
+
+    const Id id = Dimension::id(name);
+    if (id == Id::X || id == Id::Y || id == Id::Z)
+        return true;
+    for (const std::string& used : m_usedDims)
+        if (Utils::iequals(used, name))
+            return true;
+    return false;
+}
+
+
 void Reader::readerInitialize(PointTableRef)
 {
     if (m_overrideSrs.valid() && m_defaultSrs.valid())
@@ -57,6 +57,28 @@ public:
     point_count_t count() const
         { return m_count; }
 
+    /**
+      Limit the dimensions that the reader provides to those named in a
+      list.  Readers that support this skip registering and decoding
+      other dimensions.  X, Y and Z are always provided.
+
+      \param dims  Names of the dimensions to provide.
+    */
+    void setUsedDims(const StringList& dims)
+    {
+        m_usedDims = dims;
+        m_allDims = false;
+    }
+
+    /**
+      Remove any limit set with \ref setUsedDims().
+    */
+    void clearUsedDims()
+    {
+        m_usedDims.clear();
+        m_allDims = true;
+    }
+
     using Stage::setSpatialReference;
 
 protected:
@@ -72,7 +94,20 @@ protected:
     virtual void setSpatialReference(MetadataNode& m,
             const SpatialReference& srs);
 
+    /**
+      Determine whether a dimension should be provided by the reader.
+
+      \param name  Name of the dimension.
+      \return  Whether the dimension should be provided.
+    */
+    bool dimUsed(const std::string& name) const;
+    bool dimUsed(Dimension::Id id) const
+        { return dimUsed(Dimension::name(id)); }
+
 private:
+    StringList m_usedDims;
+    bool m_allDims = true;
+
     virtual PointViewSet run(PointViewPtr view)
     {
         PointViewSet viewSet;
@@ -40,6 +40,8 @@
 #include <pdal/util/Algorithm.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include "private/StageProfile.hpp"
+#include "private/Executor.hpp"
 #include "private/StageRunner.hpp"
 
 #include <iterator>
@@ -49,7 +51,7 @@ namespace pdal
 {
 
 Stage::Stage() : m_progressFd(-1), m_verbose(0), m_pointCount(0),
-    m_faceCount(0)
+    m_faceCount(0), m_threads(1), m_readAhead(0)
 {}
 
 
@@ -57,6 +59,14 @@ Stage::~Stage()
 {}
 
 
+void Stage::setProfiling(bool profile)
+{
+    m_profile.reset(profile ? new StageProfile : nullptr);
+    for (Stage *s : m_inputs)
+        s->setProfiling(profile);
+}
+
+
 void Stage::addConditionalOptions(const Options& opts)
 {
     for (const auto& o : opts.getOptions())
@@ -138,6 +148,14 @@ QuickInfo Stage::preview()
 }
 
 
+bool Stage::findUsedDimensions(StringList& dims)
+{
+    m_args.reset(new ProgramArgs);
+    handleOptions();
+    return usedDimensions(dims);
+}
+
+
 void Stage::prepare(PointTableRef table)
 {
     m_args.reset(new ProgramArgs);
@@ -186,6 +204,15 @@ PointViewSet Stage::execute(PointTableRef table)
     m_log->get(LogLevel::Debug) << "Executing pipeline in standard mode." <<
         std::endl;
 
+    // Views of all stages of the pipeline run on the shared executor.
+    std::unique_ptr<TaskGroup> group;
+    if (m_threads > 1)
+    {
+        m_log->get(LogLevel::Debug) << "Running point views on " <<
+            Executor::global().threads() << " threads." << std::endl;
+        group.reset(new TaskGroup);
+    }
+
     pending.push(StageInstance(this, stageInstanceId++));
 
     // Linearize stage execution.
@@ -212,7 +239,7 @@ PointViewSet Stage::execute(PointTableRef table)
         PointViewSet& inViews = sets[si];
         if (inViews.empty())
             inViews.insert(PointViewPtr(new PointView(table)));
-        outViews = si.m_stage->execute(table, inViews);
+        outViews = si.m_stage->execute(table, inViews, group.get());
 
         StageInstance child = children[si];
 
@@ -225,7 +252,8 @@ PointViewSet Stage::execute(PointTableRef table)
     return outViews;
 }
 
-PointViewSet Stage::execute(PointTableRef table, PointViewSet& views)
+PointViewSet Stage::execute(PointTableRef table, PointViewSet& views,
+    TaskGroup *group)
 {
 
     PointViewSet outViews;
@@ -259,23 +287,51 @@ PointViewSet Stage::execute(PointTableRef table, PointViewSet& views)
     }
     // Do the ready operation and then start running all the views
     // through the stage.
-    ready(table);
+    StageProfile *profile = m_profile.get();
+    {
+        StageProfile::Timer t(profile, StageProfile::Ready);
+        ready(table);
+    }
+    if (profile)
+        profile->updateMemory(table.memoryUsage());
+
+    // The run phase is timed as a whole for elapsed time.  CPU time is
+    // accumulated by each runner on the thread that runs it.
+    std::unique_ptr<StageProfile::Timer> runTimer(profile ?
+        new StageProfile::Timer(profile, StageProfile::Run,
+            StageProfile::WallTime) : nullptr);
     prerun(views);
+
+    const bool concurrent = group && views.size() > 1 && reentrant();
+    const int lastViewId = PointView::m_lastId;
     for (auto const& it : views)
     {
         StageRunnerPtr runner(new StageRunner(this, it));
         runners.push_back(runner);
-        runner->run();
+        if (concurrent)
+            runner->run(*group);
+        else
+            runner->run();
     }
+    if (concurrent)
+        group->wait();
 
-    // As the stages complete (synchronously at this time), propagate the
-    // spatial reference and merge the output views.
+    // As the stages complete, propagate the spatial reference and merge
+    // the output views.
     srs = getSpatialReference();
     for (auto const& it : runners)
     {
         StageRunnerPtr runner(it);
         PointViewSet temp = runner->wait();
 
+        // Views created by concurrent runs were numbered in whatever order
+        // the threads created them.  Renumber them in runner order so that
+        // the output set is ordered as it would be for a synchronous run.
+        if (concurrent)
+            for (PointViewPtr v : temp)
+                if (v->m_id > lastViewId)
+                    v->m_id = ++PointView::m_lastId;
+
         // If our stage has a spatial reference, the view takes it on once
         // the stage has been run.
         if (!srs.empty())
@@ -283,7 +339,22 @@ PointViewSet Stage::execute(PointTableRef table, PointViewSet& views)
                 v->setSpatialReference(srs);
         outViews.insert(temp.begin(), temp.end());
     }
-    done(table);
+    runTimer.reset();
+    if (profile)
+        profile->updateMemory(table.memoryUsage());
+    {
+        StageProfile::Timer t(profile, StageProfile::Done);
+        done(table);
+    }
+    if (profile)
+    {
+        point_count_t outCount = 0;
+        for (auto const& v : outViews)
+            outCount += v->size();
+        profile->addPoints(m_pointCount, outCount);
+        profile->updateMemory(table.memoryUsage());
+        profile->toMetadata(m_metadata);
+    }
     stopLogging();
     m_pointCount = 0;
     m_faceCount = 0;
@@ -54,9 +54,11 @@ namespace pdal
 {
 
 class ProgramArgs;
+class StageProfile;
 class StageRunner;
 class StageWrapper;
 class Streamable;
+class TaskGroup;
 
 /**
   A stage performs the actual processing in PDAL.  Stages may read data,
@@ -99,6 +101,19 @@ public:
     */
     QuickInfo preview();
 
+    /**
+      Find the dimensions that this stage reads or writes but doesn't
+      register itself.  The stage's options are parsed, but the stage isn't
+      otherwise prepared.  Used by PipelineManager to let readers skip
+      dimensions that no stage of the pipeline needs.
+
+      \param dims  Names of the dimensions used by the stage are appended
+        to this list.
+      \return  Whether the stage knows which dimensions it uses.  If false,
+        the stage must be assumed to use every dimension.
+    */
+    bool findUsedDimensions(StringList& dims);
+
     /**
       Prepare a stage for execution.  This function needs to be called on the
       terminal stage of a pipeline (linked set of stages) before \ref execute
@@ -144,6 +159,56 @@ public:
     virtual const Stage *findNonstreamable() const
     { return this; }
 
+    /**
+      Determine whether this stage's \ref run function may be called
+      concurrently for different point views.  Stages that keep state
+      while processing a view, add points to the table or update metadata
+      from run() must not claim to be re-entrant.
+
+      \return  Whether run() can be called from several threads at once.
+    */
+    virtual bool reentrant() const
+    { return false; }
+
+    /**
+      Set the number of threads used to execute a pipeline.  In standard
+      mode, point views are run concurrently through stages that are
+      \ref reentrant.  In stream mode, runs of adjacent stages each get
+      their own thread.  This must be called on the terminal stage of the
+      pipeline before \ref execute.
+
+      \param threads  Number of threads.  A value less than two runs all
+        views on the calling thread.  In standard mode, views run on the
+        executor shared by the process, whose size is set separately.
+    */
+    void setThreads(size_t threads)
+        { m_threads = threads; }
+
+    /**
+      Set the number of tables the reader may fill ahead of the stages that
+      follow it in stream mode.  When non-zero, the reader runs on its own
+      thread, regardless of \ref setThreads, so that reading overlaps the
+      processing of points already read.  This must be called on the
+      terminal stage of the pipeline before \ref execute.
+
+      \param chunks  Number of tables to read ahead.  Zero reads points only
+        as they're needed, unless several threads have been requested.
+    */
+    void setReadAhead(size_t chunks)
+        { m_readAhead = chunks; }
+
+    /**
+      Enable or disable profiling of this stage and its inputs.  When
+      enabled, the time spent in ready(), run(), processOne() and done(),
+      the number of points passed in and out and the peak memory used by
+      the point table are recorded in the "profile" node of each stage's
+      metadata when the pipeline is executed.  Previously collected
+      values are discarded.
+
+      \param profile  Whether profiling should be enabled.
+    */
+    void setProfiling(bool profile);
+
     /**
       Set the spatial reference of a stage.
 
@@ -360,6 +425,9 @@ private:
     std::string m_userDataJSON;
     point_count_t m_pointCount;
     point_count_t m_faceCount;
+    size_t m_threads;
+    size_t m_readAhead;
+    std::unique_ptr<StageProfile> m_profile;
     // This is never used, but we want something to bind to the argument
     // we stick in ProgramArgs so that it shows up in help and an options list.
     std::string m_optionFile;
@@ -430,14 +498,28 @@ private:
     virtual void addDimensions(PointLayoutPtr /*layout*/)
         {}
 
+    /**
+      Add the names of dimensions that the stage reads or writes but doesn't
+      register to a list.  Called after options have been processed.
+      Implement in subclass.
+
+      \param dims  List to which dimension names should be added.
+      \return  Whether the list of dimensions is complete.  The default
+        implementation returns false, meaning all dimensions may be used.
+    */
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return false; }
+
     /**
       Execute a single stage.
 
       \param table  PointTable
       \param pvSet  Input PointViewSet
+      \param group  Group in which to run views if the stage is re-entrant.
       \return  Output PointViewSet
     */
-    PointViewSet execute(PointTableRef table, PointViewSet& pvSet);
+    PointViewSet execute(PointTableRef table, PointViewSet& pvSet,
+        TaskGroup *group = nullptr);
 
     /**
       Functions called after dimensions have been added.  Implement in
@@ -32,14 +32,97 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <condition_variable>
+#include <exception>
 #include <iterator>
+#include <mutex>
+#include <queue>
 
 #include <pdal/Streamable.hpp>
 #include <pdal/Reader.hpp>
 
+#include "private/StageProfile.hpp"
+#include "private/ThreadPool.hpp"
+
 namespace pdal
 {
 
+namespace
+{
+
+// Table used to pass points between stages that run on separate threads.
+class ChunkPointTable : public StreamPointTable
+{
+public:
+    ChunkPointTable(PointLayout& layout, point_count_t capacity) :
+        StreamPointTable(layout, capacity)
+    { m_buf.resize(pointsToBytes(capacity + 1)); }
+
+protected:
+    virtual void reset()
+        { std::fill(m_buf.begin(), m_buf.end(), 0); }
+
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + pointsToBytes(idx); }
+
+private:
+    std::vector<char> m_buf;
+};
+
+struct Chunk
+{
+    Chunk(PointLayout& layout, point_count_t capacity) :
+        m_table(layout, capacity), m_count(0)
+    {}
+
+    ChunkPointTable m_table;
+    point_count_t m_count;
+    SpatialReference m_srs;
+};
+
+// Chunks waiting to be processed by a thread.  A null chunk marks the end
+// of input.
+class ChunkQueue
+{
+public:
+    ChunkQueue() : m_stopped(false)
+    {}
+
+    void push(Chunk *c)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_chunks.push(c);
+        m_cv.notify_one();
+    }
+
+    // Wait for a chunk.  Returns false if the queue has been stopped.
+    bool pop(Chunk *& c)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this](){ return m_stopped || m_chunks.size(); });
+        if (m_stopped)
+            return false;
+        c = m_chunks.front();
+        m_chunks.pop();
+        return true;
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_cv.notify_all();
+    }
+
+private:
+    std::queue<Chunk *> m_chunks;
+    bool m_stopped;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+} // unnamed namespace
+
 Streamable::Streamable()
 {}
 
@@ -95,7 +178,13 @@ void Streamable::execute(StreamPointTable& table)
             for (auto s : *this)
             {
                 s->startLogging();
-                s->ready(table);
+                {
+                    StageProfile::Timer t(s->m_profile.get(),
+                        StageProfile::Ready);
+                    s->ready(table);
+                }
+                if (s->m_profile)
+                    s->m_profile->updateMemory(table.memoryUsage());
                 s->stopLogging();
                 SpatialReference srs = s->getSpatialReference();
                 if (!srs.empty())
@@ -108,7 +197,13 @@ void Streamable::execute(StreamPointTable& table)
             for (auto s : *this)
             {
                 s->startLogging();
-                s->done(table);
+                {
+                    StageProfile::Timer t(s->m_profile.get(),
+                        StageProfile::Done);
+                    s->done(table);
+                }
+                if (s->m_profile)
+                    s->m_profile->toMetadata(s->m_metadata);
                 s->stopLogging();
             }
         }
@@ -178,6 +273,12 @@ void Streamable::execute(StreamPointTable& table)
 void Streamable::execute(StreamPointTable& table,
     std::list<Streamable *>& stages, SrsMap& srsMap)
 {
+    if ((m_threads > 1 || m_readAhead) && stages.size() > 1)
+    {
+        executeParallel(table, stages, srsMap);
+        return;
+    }
+
     std::list<Streamable *> filters;
     SpatialReference srs;
 
@@ -214,14 +315,20 @@ void Streamable::execute(StreamPointTable& table,
         if (!pointLimit)
             finished = true;
 
-        for (PointId idx = 0; idx < pointLimit; idx++)
         {
-            point.setPointId(idx);
-            finished = !reader->processOne(point);
-            if (finished)
-                pointLimit = idx;
+            StageProfile::Timer t(reader->m_profile.get(),
+                StageProfile::ProcessOne);
+            for (PointId idx = 0; idx < pointLimit; idx++)
+            {
+                point.setPointId(idx);
+                finished = !reader->processOne(point);
+                if (finished)
+                    pointLimit = idx;
+            }
         }
         count -= pointLimit;
+        if (reader->m_profile)
+            reader->m_profile->addPoints(0, pointLimit);
 
         reader->stopLogging();
         srs = reader->getSpatialReference();
@@ -240,14 +347,7 @@ void Streamable::execute(StreamPointTable& table,
                 srsMap[s] = srs;
             }
             s->startLogging();
-            for (PointId idx = 0; idx < pointLimit; idx++)
-            {
-                if (table.skip(idx))
-                    continue;
-                point.setPointId(idx);
-                if (!s->processOne(point))
-                    table.setSkip(idx);
-            }
+            processPoints(s, table, point, pointLimit);
             const SpatialReference& tempSrs = s->getSpatialReference();
             if (!tempSrs.empty())
             {
@@ -261,5 +361,237 @@ void Streamable::execute(StreamPointTable& table,
     }
 }
 
-} // namespace pdal
 
+// Run the unskipped points of a table through a stage, marking those the
+// stage filters out as skipped.
+void Streamable::processPoints(Streamable *s, StreamPointTable& table,
+    PointRef& point, point_count_t count)
+{
+    StageProfile *profile = s->m_profile.get();
+    StageProfile::Timer t(profile, StageProfile::ProcessOne);
+
+    point_count_t in = 0;
+    point_count_t out = 0;
+    for (PointId idx = 0; idx < count; idx++)
+    {
+        if (table.skip(idx))
+            continue;
+        in++;
+        point.setPointId(idx);
+        if (s->processOne(point))
+            out++;
+        else
+            table.setSkip(idx);
+    }
+    if (profile)
+        profile->addPoints(in, out);
+}
+
+
+// Run adjacent runs of stages on their own threads.  Points are passed from
+// thread to thread in chunks the size of the provided table.  Chunks are
+// recycled once the last stage has processed them, so the number of chunks
+// created bounds memory use just as the single table does in serial mode.
+// With read-ahead, the reader gets a thread of its own and enough chunks to
+// fill that many tables ahead of the other stages.
+//
+// Once the last stage has processed a chunk, its points and skips are
+// copied into the provided table, in order, and the table is cleared, so
+// that the table's reset() sees every point as in serial mode.  The threads
+// block on each other, so they come from a ThreadPool rather than the
+// executor.
+void Streamable::executeParallel(StreamPointTable& table,
+    std::list<Streamable *>& stages, SrsMap& srsMap)
+{
+    using StageGroup = std::vector<Streamable *>;
+
+    size_t numGroups = m_threads;
+    if (m_readAhead)
+        numGroups = (std::max)(numGroups, (size_t)2);
+    std::vector<StageGroup> groups((std::min)(numGroups, stages.size()));
+    if (m_readAhead)
+    {
+        auto si = stages.begin();
+        groups[0].push_back(*si++);
+        const size_t numStages = stages.size() - 1;
+        const size_t numRest = groups.size() - 1;
+        size_t pos = 0;
+        for (; si != stages.end(); ++si)
+            groups[1 + pos++ * numRest / numStages].push_back(*si);
+    }
+    else
+    {
+        size_t pos = 0;
+        for (Streamable *s : stages)
+            groups[pos++ * groups.size() / stages.size()].push_back(s);
+    }
+
+    m_log->get(LogLevel::Debug) << "Streaming " << stages.size() <<
+        " stages on " << groups.size() << " threads." << std::endl;
+
+    Streamable *reader = stages.front();
+    point_count_t count = (std::numeric_limits<point_count_t>::max)();
+    if (Reader *r = dynamic_cast<Reader *>(reader))
+        count = r->count();
+
+    // Queue 0 holds free chunks and feeds the reader's thread.  Every other
+    // queue feeds the thread of the group with the same index.
+    std::vector<ChunkQueue> queues(groups.size());
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    const size_t numChunks =
+        groups.size() + (std::max)(m_readAhead, groups.size());
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        chunks.emplace_back(new Chunk(*table.layout(), table.capacity()));
+        queues[0].push(chunks.back().get());
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto fail = [&]()
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = std::current_exception();
+        for (ChunkQueue& q : queues)
+            q.stop();
+    };
+
+    // Hand a processed chunk to the provided table.  Only the thread of the
+    // last group calls this.
+    const DimTypeList dims = table.layout()->dimTypes();
+    std::vector<char> buf(table.layout()->pointSize());
+    auto deliver = [&table, &dims, &buf](Chunk& c)
+    {
+        StreamPointTable& t = c.m_table;
+        table.clearSpatialReferences();
+        if (!c.m_srs.empty())
+            table.setSpatialReference(c.m_srs);
+        for (PointId idx = 0; idx < c.m_count; ++idx)
+        {
+            PointRef(t, idx).getPackedData(dims, buf.data());
+            PointRef(table, idx).setPackedData(dims, buf.data());
+            if (t.skip(idx))
+                table.setSkip(idx);
+        }
+        table.clear(c.m_count);
+    };
+
+    // Each thread tracks the spatial reference last seen by its stages.
+    std::vector<SrsMap> srsMaps(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g)
+        for (Streamable *s : groups[g])
+        {
+            auto si = srsMap.find(s);
+            if (si != srsMap.end())
+                srsMaps[g].insert(*si);
+        }
+
+    auto work = [&](size_t g)
+    {
+        StageGroup& group = groups[g];
+        SrsMap& groupSrs = srsMaps[g];
+        ChunkQueue& in = queues[g];
+        ChunkQueue& out = queues[(g + 1) % groups.size()];
+        const bool last = (g == groups.size() - 1);
+
+        try
+        {
+            Chunk *c;
+            while (in.pop(c))
+            {
+                // End of input.
+                if (!c)
+                {
+                    if (!last)
+                        out.push(nullptr);
+                    break;
+                }
+
+                StreamPointTable& t = c->m_table;
+                PointRef point(t, 0);
+                auto si = group.begin();
+                bool finished = false;
+
+                if (g == 0)
+                {
+                    reader->startLogging();
+                    t.clearSpatialReferences();
+                    point_count_t pointLimit = (std::min)(count, t.capacity());
+                    if (!pointLimit)
+                        finished = true;
+                    {
+                        StageProfile::Timer timer(reader->m_profile.get(),
+                            StageProfile::ProcessOne);
+                        for (PointId idx = 0; idx < pointLimit; idx++)
+                        {
+                            point.setPointId(idx);
+                            finished = !reader->processOne(point);
+                            if (finished)
+                                pointLimit = idx;
+                        }
+                    }
+                    count -= pointLimit;
+                    if (reader->m_profile)
+                        reader->m_profile->addPoints(0, pointLimit);
+                    c->m_count = pointLimit;
+                    c->m_srs = reader->getSpatialReference();
+                    if (!c->m_srs.empty())
+                        t.setSpatialReference(c->m_srs);
+                    reader->stopLogging();
+                    si++;
+                }
+
+                for (; si != group.end(); ++si)
+                {
+                    Streamable *s = *si;
+                    s->startLogging();
+                    auto mi = groupSrs.find(s);
+                    if (mi == groupSrs.end() || mi->second != c->m_srs)
+                    {
+                        s->spatialReferenceChanged(c->m_srs);
+                        groupSrs[s] = c->m_srs;
+                    }
+                    processPoints(s, t, point, c->m_count);
+                    const SpatialReference& tempSrs = s->getSpatialReference();
+                    if (!tempSrs.empty())
+                    {
+                        c->m_srs = tempSrs;
+                        t.setSpatialReference(tempSrs);
+                    }
+                    s->stopLogging();
+                }
+
+                if (last)
+                {
+                    deliver(*c);
+                    t.clear(c->m_count);
+                }
+                out.push(c);
+                if (finished)
+                {
+                    out.push(nullptr);
+                    break;
+                }
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+    };
+
+    ThreadPool pool(groups.size(), groups.size());
+    for (size_t g = 0; g < groups.size(); ++g)
+        pool.add([&work, g]() { work(g); });
+    pool.join();
+
+    for (SrsMap& m : srsMaps)
+        for (auto& si : m)
+            srsMap[si.first] = si.second;
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace pdal
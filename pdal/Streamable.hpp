@@ -60,6 +60,15 @@ public:
       Streaming points can reduce memory consumption, but will limit access
       to algorithms that need to operate on full point sets.
 
+      If more than one thread has been requested with \ref setThreads,
+      runs of adjacent stages are executed on separate threads and points
+      are passed between them in internal tables with the layout and
+      capacity of the provided table.  Once points have been through every
+      stage, they're copied into the provided table in order and the table
+      is cleared, just as in serial mode.  The same is done, with the reader
+      on a thread of its own, if read-ahead has been requested with
+      \ref setReadAhead.
+
       \param table  Streaming point table used for stage pipeline.  This must be
         the same \ref table used in the \ref prepare function.
 
@@ -82,6 +91,10 @@ protected:
 
     void execute(StreamPointTable& table, std::list<Streamable *>& stages,
         SrsMap& srsMap);
+    void executeParallel(StreamPointTable& table,
+        std::list<Streamable *>& stages, SrsMap& srsMap);
+    static void processPoints(Streamable *s, StreamPointTable& table,
+        PointRef& point, point_count_t count);
 
     /**
       Process a single point (streaming mode).  Implement in subclass.
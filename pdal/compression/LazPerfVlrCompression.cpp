@@ -56,6 +56,15 @@
 
 #include "LazPerfVlrCompression.hpp"
 
+#include <deque>
+#include <future>
+#include <limits>
+#include <sstream>
+
+#include <pdal/private/Executor.hpp>
+#include <pdal/util/Charbuf.hpp>
+#include <pdal/util/IStream.hpp>
+
 namespace pdal
 {
 
@@ -69,6 +78,9 @@ namespace pdal
 // The compressor uses the schema of the point data in order to compress
 // the point stream.  The schema is also stored in a VLR that isn't
 // handled as part of the compression process itself.
+// With a chunk size of the maximum uint32 value, chunks vary in size and
+// end only when endChunk() is called.  The chunk table then holds the
+// number of points in each chunk as well as its size.
 class LazPerfVlrCompressorImpl
 {
     typedef laszip::io::__ofstream_wrapper<std::ostream> OutputStream;
@@ -78,14 +90,18 @@ class LazPerfVlrCompressorImpl
 
 public:
     LazPerfVlrCompressorImpl(std::ostream& stream, const Schema& schema,
-            uint32_t chunksize) :
+            uint32_t chunksize, size_t threads) :
         m_stream(stream), m_outputStream(stream), m_schema(schema),
         m_chunksize(chunksize), m_chunkPointsWritten(0), m_chunkInfoPos(0),
-        m_chunkOffset(0)
+        m_chunkOffset(0), m_threads(threads), m_started(false),
+        m_variable(chunksize == (std::numeric_limits<uint32_t>::max)())
     {}
 
+    // Chunks still being compressed use our state, so wait for them.
     ~LazPerfVlrCompressorImpl()
     {
+        for (auto& f : m_chunks)
+            Executor::global().wait(f);
         if (m_encoder)
             std::cerr << "LazPerfVlrCompressor destroyed without a call "
                "to done()";
@@ -94,16 +110,22 @@ public:
 
     void compress(const char *inbuf)
     {
-        // First time through.
-        if (!m_encoder || !m_compressor)
+        if (m_threads > 1)
         {
-            // Get the position
-            m_chunkInfoPos = m_stream.tellp();
-            // Seek over the chunk info offset value
-            m_stream.seekp(sizeof(uint64_t), std::ios::cur);
-            m_chunkOffset = m_stream.tellp();
-            resetCompressor();
+            if (!m_started)
+                start();
+            m_chunkBuf.insert(m_chunkBuf.end(), inbuf,
+                inbuf + m_schema.size_in_bytes());
+            if (++m_chunkPointsWritten == m_chunksize)
+                queueChunk();
+            return;
         }
+
+        // First time through, or first point after endChunk().
+        if (!m_started)
+            start();
+        if (!m_encoder || !m_compressor)
+            resetCompressor();
         else if (m_chunkPointsWritten == m_chunksize)
         {
             resetCompressor();
@@ -113,13 +135,33 @@ public:
         m_chunkPointsWritten++;
     }
 
-    void done()
+    void endChunk()
     {
-        // Close and clear the point encoder.
-        m_encoder->done();
-        m_encoder.reset();
+        if (m_threads > 1)
+        {
+            if (m_chunkPointsWritten)
+                queueChunk();
+        }
+        else if (m_encoder)
+        {
+            // Close and clear the point encoder.  The next point starts
+            // a new one.
+            m_encoder->done();
+            m_compressor.reset();
+            m_encoder.reset();
 
-        newChunk();
+            newChunk();
+        }
+    }
+
+    void done()
+    {
+        if (!m_started)
+            start();
+        endChunk();
+        if (m_threads > 1)
+            while (m_chunks.size())
+                writeChunk();
 
         // Save our current position.  Go to the location where we need
         // to write the chunk table offset at the beginning of the point data.
@@ -141,17 +183,37 @@ public:
         laszip::compressors::integer compressor(32, 2);
         compressor.init();
 
+        uint32_t countPredictor = 0;
         uint32_t predictor = 0;
-        for (uint32_t offset : m_chunkTable)
+        for (size_t i = 0; i < m_chunkTable.size(); ++i)
         {
-            offset = htole32(offset);
+            if (m_variable)
+            {
+                uint32_t count = htole32(m_chunkCounts[i]);
+                compressor.compress(encoder, countPredictor, count, 0);
+                countPredictor = count;
+            }
+            uint32_t offset = htole32(m_chunkTable[i]);
             compressor.compress(encoder, predictor, offset, 1);
             predictor = offset;
         }
         encoder.done();
     }
 
+    const std::vector<uint32_t>& chunkSizes() const
+        { return m_chunkTable; }
+
 private:
+    void start()
+    {
+        // Get the position
+        m_chunkInfoPos = m_stream.tellp();
+        // Seek over the chunk info offset value
+        m_stream.seekp(sizeof(uint64_t), std::ios::cur);
+        m_chunkOffset = m_stream.tellp();
+        m_started = true;
+    }
+
     void resetCompressor()
     {
         if (m_encoder)
@@ -164,10 +226,59 @@ private:
     {
         std::streampos offset = m_stream.tellp();
         m_chunkTable.push_back((uint32_t)(offset - m_chunkOffset));
+        m_chunkCounts.push_back(m_chunkPointsWritten);
         m_chunkOffset = offset;
         m_chunkPointsWritten = 0;
     }
 
+    // Hand the buffered points of the current chunk to the executor.
+    // At most two chunks per thread are kept pending, so writing the
+    // oldest one blocks until it's been compressed.
+    void queueChunk()
+    {
+        if (m_chunks.size() >= 2 * m_threads)
+            writeChunk();
+
+        std::shared_ptr<std::vector<char>> buf(
+            new std::vector<char>(std::move(m_chunkBuf)));
+        m_chunkBuf.clear();
+        m_chunkCounts.push_back(m_chunkPointsWritten);
+        m_chunkPointsWritten = 0;
+
+        m_chunks.push_back(Executor::global().async([this, buf]()
+            { return compressChunk(*buf); }));
+    }
+
+    // Write the oldest pending chunk to the output.  Chunks complete
+    // out of order, but are always written in the order they were queued.
+    void writeChunk()
+    {
+        Executor::global().wait(m_chunks.front());
+        std::vector<char> chunk = m_chunks.front().get();
+        m_chunks.pop_front();
+        m_stream.write(chunk.data(), chunk.size());
+        m_chunkTable.push_back((uint32_t)chunk.size());
+    }
+
+    // Compress a chunk of points with a fresh encoder.  Only reads shared
+    // state, so can be run on several chunks at once.
+    std::vector<char> compressChunk(const std::vector<char>& buf) const
+    {
+        std::ostringstream out;
+        OutputStream outputStream(out);
+        Encoder encoder(outputStream);
+        Compressor::ptr compressor =
+            laszip::factory::build_compressor(encoder, m_schema);
+
+        const size_t pointSize = m_schema.size_in_bytes();
+        for (size_t pos = 0; pos < buf.size(); pos += pointSize)
+            compressor->compress(buf.data() + pos);
+        encoder.done();
+
+        std::string s = out.str();
+        return std::vector<char>(s.begin(), s.end());
+    }
+
     std::ostream& m_stream;
     OutputStream m_outputStream;
     std::unique_ptr<Encoder> m_encoder;
@@ -178,12 +289,18 @@ private:
     std::streampos m_chunkInfoPos;
     std::streampos m_chunkOffset;
     std::vector<uint32_t> m_chunkTable;
+    std::vector<uint32_t> m_chunkCounts;
+    size_t m_threads;
+    bool m_started;
+    bool m_variable;
+    std::vector<char> m_chunkBuf;
+    std::deque<std::future<std::vector<char>>> m_chunks;
 };
 
 
 LazPerfVlrCompressor::LazPerfVlrCompressor(std::ostream& stream,
-        const Schema& schema, uint32_t chunksize) :
-    m_impl(new LazPerfVlrCompressorImpl(stream, schema, chunksize))
+        const Schema& schema, uint32_t chunksize, size_t threads) :
+    m_impl(new LazPerfVlrCompressorImpl(stream, schema, chunksize, threads))
 {}
 
 
@@ -197,12 +314,24 @@ void LazPerfVlrCompressor::compress(const char *inbuf)
 }
 
 
+void LazPerfVlrCompressor::endChunk()
+{
+    m_impl->endChunk();
+}
+
+
 void LazPerfVlrCompressor::done()
 {
     m_impl->done();
 }
 
 
+const std::vector<uint32_t>& LazPerfVlrCompressor::chunkSizes() const
+{
+    return m_impl->chunkSizes();
+}
+
+
 class LazPerfVlrDecompressorImpl
 {
 public:
@@ -274,5 +403,124 @@ void LazPerfVlrDecompressor::decompress(char *outbuf)
     m_impl->decompress(outbuf);
 }
 
+
+LazPerfVlrChunkDecompressor::LazPerfVlrChunkDecompressor(const char *vlrData)
+{
+    laszip::io::laz_vlr zipvlr(vlrData);
+    m_chunksize = zipvlr.chunk_size;
+    // The maximum value indicates chunks of varying size.
+    if (m_chunksize == (std::numeric_limits<uint32_t>::max)())
+        m_chunksize = 0;
+    m_schema.reset(new Schema(laszip::io::laz_vlr::to_schema(zipvlr)));
+}
+
+
+LazPerfVlrChunkDecompressor::~LazPerfVlrChunkDecompressor()
+{}
+
+
+size_t LazPerfVlrChunkDecompressor::pointSize() const
+{
+    return (size_t)m_schema->size_in_bytes();
+}
+
+
+uint32_t LazPerfVlrChunkDecompressor::chunkSize() const
+{
+    return m_chunksize;
+}
+
+
+void LazPerfVlrChunkDecompressor::decompress(char *inbuf, size_t inbufSize,
+    char *outbuf, size_t count)
+{
+    typedef laszip::io::__ifstream_wrapper<std::istream> InputStream;
+    typedef laszip::decoders::arithmetic<InputStream> Decoder;
+
+    Charbuf buf(inbuf, inbufSize);
+    std::istream in(&buf);
+    InputStream inputStream(in);
+    Decoder decoder(inputStream);
+    auto decompressor = laszip::factory::build_decompressor(decoder,
+        *m_schema);
+
+    const size_t size = pointSize();
+    for (size_t i = 0; i < count; ++i)
+    {
+        decompressor->decompress(outbuf);
+        outbuf += size;
+    }
+}
+
+
+std::vector<uint64_t> LazPerfVlrChunkDecompressor::chunkTable(
+    std::istream& stream, std::streamoff pointOffset,
+    std::vector<uint64_t> *counts)
+{
+    typedef laszip::io::__ifstream_wrapper<std::istream> InputStream;
+    typedef laszip::decoders::arithmetic<InputStream> Decoder;
+
+    std::vector<uint64_t> offsets;
+    try
+    {
+        ILeStream in(&stream);
+
+        // The chunk table offset is stored at the start of the point data.
+        // Writers that couldn't seek back to fill it in leave it as -1.
+        int64_t tablePos;
+        stream.seekg(pointOffset);
+        in >> tablePos;
+        if (!stream || tablePos <= pointOffset)
+            return offsets;
+
+        uint32_t version;
+        uint32_t numChunks;
+        stream.seekg(tablePos);
+        in >> version >> numChunks;
+        if (!stream || version != 0)
+            return offsets;
+
+        // Each entry is the size of a chunk, compressed relative to the
+        // previous entry, preceded by the number of points in the chunk
+        // when chunks vary in size.  See LazPerfVlrCompressorImpl::done().
+        InputStream inputStream(stream);
+        Decoder decoder(inputStream);
+        decoder.readInitBytes();
+        laszip::decompressors::integer decompressor(32, 2);
+        decompressor.init();
+
+        uint64_t offset = pointOffset + sizeof(int64_t);
+        offsets.push_back(offset);
+        if (counts)
+            counts->clear();
+        uint32_t countPredictor = 0;
+        uint32_t predictor = 0;
+        for (uint32_t i = 0; i < numChunks; ++i)
+        {
+            if (counts)
+            {
+                uint32_t count =
+                    decompressor.decompress(decoder, countPredictor, 0);
+                countPredictor = count;
+                counts->push_back(count);
+            }
+            uint32_t size = decompressor.decompress(decoder, predictor, 1);
+            predictor = size;
+            offset += size;
+            offsets.push_back(offset);
+        }
+        if (offset > (uint64_t)tablePos)
+            offsets.clear();
+    }
+    catch (...)
+    {
+        offsets.clear();
+    }
+    if (offsets.empty() && counts)
+        counts->clear();
+    stream.clear();
+    return offsets;
+}
+
 } // namespace pdal
 
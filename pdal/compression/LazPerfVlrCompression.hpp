@@ -33,7 +33,10 @@
 ****************************************************************************/
 #pragma once
 
+#include <istream>
 #include <memory>
+#include <vector>
+
 #include <pdal/util/OStream.hpp>
 
 namespace laszip
@@ -58,18 +61,28 @@ namespace pdal
 // The compressor uses the schema of the point data in order to compress
 // the point stream.  The schema is also stored in a VLR that isn't
 // handled as part of the compression process itself.
+// When more than one thread is requested, points are buffered a chunk at
+// a time and chunks are compressed concurrently, then written in order.
+// A chunk size of the maximum uint32 value makes chunks of varying size,
+// each ended by a call to endChunk().
 class LazPerfVlrCompressor
 {
     typedef laszip::factory::record_schema Schema;
 
 public:
     PDAL_DLL LazPerfVlrCompressor(std::ostream& stream, const Schema& schema,
-        uint32_t chunksize);
+        uint32_t chunksize, size_t threads = 1);
     PDAL_DLL ~LazPerfVlrCompressor();
 
     PDAL_DLL void compress(const char *inbuf);
+    // End the current chunk.  The next point compressed starts a new one.
+    PDAL_DLL void endChunk();
     PDAL_DLL void done();
 
+    // Compressed size of each chunk written, in the order written.  Valid
+    // after done().
+    PDAL_DLL const std::vector<uint32_t>& chunkSizes() const;
+
 private:
     std::unique_ptr<LazPerfVlrCompressorImpl> m_impl;
 };
@@ -91,5 +104,42 @@ private:
     std::unique_ptr<LazPerfVlrDecompressorImpl> m_impl;
 };
 
+
+// Decompresses individual chunks of point data written by a compressor like
+// the one above.  Chunks are compressed independently, so a chunk can be
+// decompressed without the data that precedes it, and separate instances
+// can decompress different chunks at the same time.
+class LazPerfVlrChunkDecompressor
+{
+    typedef laszip::factory::record_schema Schema;
+
+public:
+    PDAL_DLL LazPerfVlrChunkDecompressor(const char *vlrData);
+    PDAL_DLL ~LazPerfVlrChunkDecompressor();
+
+    PDAL_DLL size_t pointSize() const;
+
+    // Number of points in each chunk.  The last chunk may have fewer.
+    // Zero if chunks have varying numbers of points.
+    PDAL_DLL uint32_t chunkSize() const;
+
+    // Decompress 'count' points from the compressed chunk in 'inbuf' to
+    // 'outbuf', which must have room for count * pointSize() bytes.
+    PDAL_DLL void decompress(char *inbuf, size_t inbufSize, char *outbuf,
+        size_t count);
+
+    // Read the chunk table of compressed point data that starts at
+    // 'pointOffset'.  Returns the file offset of each chunk followed by
+    // the offset of the end of the last chunk, or an empty list if the
+    // table can't be read.  For chunks of varying size, 'counts' must be
+    // provided and is filled with the number of points in each chunk.
+    PDAL_DLL static std::vector<uint64_t> chunkTable(std::istream& stream,
+        std::streamoff pointOffset, std::vector<uint64_t> *counts = nullptr);
+
+private:
+    std::unique_ptr<Schema> m_schema;
+    uint32_t m_chunksize;
+};
+
 } // namespace pdal
 
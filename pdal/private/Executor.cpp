@@ -0,0 +1,298 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "Executor.hpp"
+
+#include <pdal/util/Utils.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+// The executor whose thread this is, if any, and the index of the thread.
+thread_local Executor *t_executor = nullptr;
+thread_local std::size_t t_index = 0;
+
+std::mutex s_globalMutex;
+std::unique_ptr<Executor> s_global;
+std::size_t s_threads = 0;
+
+// Call with s_globalMutex held.
+std::size_t threadCount()
+{
+    if (s_global)
+        return s_global->threads();
+    if (s_threads)
+        return s_threads;
+
+    std::string env;
+    int threads = 0;
+    if (Utils::getenv("PDAL_NUM_THREADS", env) == 0 &&
+            Utils::fromString(env, threads) && threads > 0)
+        return (std::size_t)threads;
+    return (std::max)(std::thread::hardware_concurrency(), 1U);
+}
+
+} // unnamed namespace
+
+
+Executor::Executor(std::size_t threads) : m_queued(0), m_stop(false)
+{
+    threads = (std::max)(threads, (std::size_t)1);
+    for (std::size_t i = 0; i <= threads; ++i)
+        m_queues.emplace_back(new Queue);
+    for (std::size_t i = 0; i < threads; ++i)
+        m_threads.emplace_back([this, i]() { work(i); });
+}
+
+
+// Threads run the tasks still queued before they exit.
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (std::thread& t : m_threads)
+        t.join();
+}
+
+
+Executor& Executor::global()
+{
+    std::lock_guard<std::mutex> lock(s_globalMutex);
+    if (!s_global)
+        s_global.reset(new Executor(threadCount()));
+    return *s_global;
+}
+
+
+void Executor::setThreads(std::size_t threads)
+{
+    std::lock_guard<std::mutex> lock(s_globalMutex);
+    s_threads = threads;
+}
+
+
+std::size_t Executor::defaultThreads()
+{
+    std::lock_guard<std::mutex> lock(s_globalMutex);
+    return threadCount();
+}
+
+
+// A thread of this executor adds tasks to its own queue.  Other threads add
+// them to the shared queue.
+void Executor::submit(std::function<void()> task)
+{
+    const std::size_t index = (t_executor == this) ? t_index :
+        m_threads.size();
+    {
+        Queue& q = *m_queues[index];
+        std::lock_guard<std::mutex> lock(q.m_mutex);
+        q.m_tasks.push_back(std::move(task));
+        m_queued++;
+    }
+
+    // Taking the lock makes sure that a thread about to wait sees the task.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_cv.notify_one();
+}
+
+
+// Take the newest task of our own queue, or else the oldest task of the
+// shared queue or of another thread's queue.
+bool Executor::pop(std::size_t index, std::function<void()>& task)
+{
+    if (m_queued == 0)
+        return false;
+
+    const std::size_t count = m_queues.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Queue& q = *m_queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(q.m_mutex);
+        if (q.m_tasks.empty())
+            continue;
+        if (i == 0 && index < m_threads.size())
+        {
+            task = std::move(q.m_tasks.back());
+            q.m_tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(q.m_tasks.front());
+            q.m_tasks.pop_front();
+        }
+        m_queued--;
+        return true;
+    }
+    return false;
+}
+
+
+bool Executor::runOne()
+{
+    const std::size_t index = (t_executor == this) ? t_index :
+        m_threads.size();
+    std::function<void()> task;
+    if (!pop(index, task))
+        return false;
+    try
+    {
+        task();
+    }
+    catch (...)
+    {}
+    return true;
+}
+
+
+void Executor::work(std::size_t index)
+{
+    t_executor = this;
+    t_index = index;
+
+    while (true)
+    {
+        if (runOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_queued || m_stop; });
+        if (m_stop && !m_queued)
+            return;
+    }
+}
+
+
+TaskGroup::TaskGroup(Executor& executor) : m_executor(executor),
+    m_pending(0)
+{}
+
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {}
+}
+
+
+void TaskGroup::run(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending++;
+    }
+    m_executor.submit([this, task]()
+    {
+        std::exception_ptr error;
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // Notify with the lock held, since the group may be destroyed as
+        // soon as the waiter sees that no tasks are pending.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (error && !m_error)
+            m_error = error;
+        m_pending--;
+        m_cv.notify_all();
+    });
+}
+
+
+void TaskGroup::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_pending)
+    {
+        lock.unlock();
+        const bool ran = m_executor.runOne();
+        lock.lock();
+        if (!ran && m_pending)
+            m_cv.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    if (m_error)
+    {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+
+// Ranges are made a few per thread so that uneven ranges balance out.
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& f,
+    Executor& executor)
+{
+    if (end <= begin)
+        return;
+
+    const std::size_t count = end - begin;
+    grain = (std::max)(grain, (std::size_t)1);
+    std::size_t ranges = (std::min)((count + grain - 1) / grain,
+        executor.threads() * 4);
+    if (ranges <= 1)
+    {
+        f(begin, end);
+        return;
+    }
+
+    const std::size_t size = (count + ranges - 1) / ranges;
+    TaskGroup group(executor);
+    for (std::size_t first = begin; first < end; first += size)
+    {
+        const std::size_t last = (std::min)(first + size, end);
+        group.run([&f, first, last]() { f(first, last); });
+    }
+    group.wait();
+}
+
+} // namespace pdal
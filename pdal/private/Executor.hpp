@@ -0,0 +1,170 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// A pool of threads that runs short, CPU-bound tasks.  Each thread has a
+// queue of tasks.  A thread runs the newest task of its own queue and, when
+// its queue is empty, steals the oldest task of another queue, so nested
+// work stays local and a thread is never idle while there's work.  Threads
+// that wait on the executor run queued tasks while they wait, so tasks may
+// start and wait for tasks of their own.
+//
+// Tasks that block on I/O or on other threads should run on a ThreadPool,
+// since a blocked task holds one of the executor's threads.
+class PDAL_DLL Executor
+{
+public:
+    Executor(std::size_t threads);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // The executor shared by the process.  It's created on first use with
+    // the number of threads set by setThreads(), or else by the environment
+    // variable PDAL_NUM_THREADS, or else one per core.
+    static Executor& global();
+
+    // Set the number of threads of the shared executor.  Has no effect once
+    // the shared executor has been created.
+    static void setThreads(std::size_t threads);
+
+    // The number of threads the shared executor has or will have.
+    static std::size_t defaultThreads();
+
+    std::size_t threads() const
+        { return m_threads.size(); }
+
+    // Queue a task.  Exceptions thrown by the task are discarded; use
+    // TaskGroup or async() to handle them.
+    void submit(std::function<void()> task);
+
+    // Run a queued task on the calling thread, if there's one.  Returns
+    // true if a task was run.
+    bool runOne();
+
+    // Run a function on the executor and return a future for its result.
+    template<typename F>
+    auto async(F f) -> std::future<decltype(f())>
+    {
+        typedef std::packaged_task<decltype(f())()> Task;
+
+        std::shared_ptr<Task> task(new Task(std::move(f)));
+        auto future = task->get_future();
+        submit([task](){ (*task)(); });
+        return future;
+    }
+
+    // Wait for a future, running queued tasks in the meantime.
+    template<typename T>
+    void wait(const std::future<T>& future)
+    {
+        while (future.wait_for(std::chrono::seconds(0)) !=
+                std::future_status::ready)
+            if (!runOne())
+                future.wait_for(std::chrono::milliseconds(1));
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex m_mutex;
+        std::deque<std::function<void()>> m_tasks;
+    };
+
+    void work(std::size_t index);
+    bool pop(std::size_t index, std::function<void()>& task);
+
+    // One queue per thread, then one for tasks submitted by other threads.
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_queued;
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+
+// Tasks run on an executor that can be waited for together.  Tasks of a
+// group may start groups of their own.
+class PDAL_DLL TaskGroup
+{
+public:
+    TaskGroup(Executor& executor = Executor::global());
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+
+    // Wait for the tasks run so far, running queued tasks in the meantime.
+    // If any of the tasks threw, the first exception is rethrown.
+    void wait();
+
+private:
+    Executor& m_executor;
+    std::size_t m_pending;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+
+// Call f(first, last) for ranges of [begin, end) in parallel.  Ranges hold
+// at least 'grain' items, except perhaps the last.
+PDAL_DLL void parallelFor(std::size_t begin, std::size_t end,
+    std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& f,
+    Executor& executor = Executor::global());
+
+} // namespace pdal
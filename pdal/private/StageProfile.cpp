@@ -0,0 +1,150 @@
+/******************************************************************************
+ * Copyright (c) 2020, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#include "StageProfile.hpp"
+
+#include <ctime>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace pdal
+{
+
+StageProfile::Timer::Timer(StageProfile *profile, Phase phase, Clock clock) :
+    m_profile(profile), m_phase(phase), m_clock(clock), m_cpuStart(0)
+{
+    if (!m_profile)
+        return;
+    if (m_clock & WallTime)
+        m_wallStart = std::chrono::steady_clock::now();
+    if (m_clock & CpuTime)
+        m_cpuStart = cpuTime();
+}
+
+
+StageProfile::Timer::~Timer()
+{
+    if (!m_profile)
+        return;
+    if (m_clock & WallTime)
+        m_profile->addWall(m_phase, std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_wallStart).count());
+    if (m_clock & CpuTime)
+        m_profile->addCpu(m_phase, cpuTime() - m_cpuStart);
+}
+
+
+StageProfile::StageProfile() : m_pointsIn(0), m_pointsOut(0), m_peakBytes(0)
+{
+    for (int i = 0; i < NumPhases; ++i)
+    {
+        m_wall[i] = 0;
+        m_cpu[i] = 0;
+        m_used[i] = false;
+    }
+}
+
+
+double StageProfile::cpuTime()
+{
+#ifdef _WIN32
+    // Process time.  Inexact when stages run on several threads.
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+        return 0;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+
+void StageProfile::addWall(Phase phase, double seconds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_wall[phase] += seconds;
+    m_used[phase] = true;
+}
+
+
+void StageProfile::addCpu(Phase phase, double seconds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_cpu[phase] += seconds;
+    m_used[phase] = true;
+}
+
+
+void StageProfile::addPoints(point_count_t in, point_count_t out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_pointsIn += in;
+    m_pointsOut += out;
+}
+
+
+void StageProfile::updateMemory(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (bytes > m_peakBytes)
+        m_peakBytes = bytes;
+}
+
+
+// Replace the "profile" node of 'parent' with the current values.
+void StageProfile::toMetadata(MetadataNode parent) const
+{
+    static const char *names[] = { "ready", "run", "process_one", "done" };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    MetadataNode profile("profile");
+    for (int i = 0; i < NumPhases; ++i)
+    {
+        if (!m_used[i])
+            continue;
+        MetadataNode phase = profile.add(names[i]);
+        phase.add("wall", m_wall[i], "Elapsed time (seconds)");
+        phase.add("cpu", m_cpu[i], "CPU time (seconds)");
+    }
+    profile.add("points_in", m_pointsIn);
+    profile.add("points_out", m_pointsOut);
+    profile.add("peak_table_bytes", m_peakBytes,
+        "Peak memory used for point data by the point table");
+    parent.addOrUpdate(profile);
+}
+
+} // namespace pdal
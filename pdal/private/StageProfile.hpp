@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (c) 2020, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#include <pdal/Metadata.hpp>
+
+namespace pdal
+{
+
+// Timing, point counts and memory use collected for a stage when profiling
+// is enabled.  Times are accumulated over all executions of the stage.
+class StageProfile
+{
+public:
+    enum Phase
+    {
+        Ready,
+        Run,
+        ProcessOne,
+        Done,
+        NumPhases
+    };
+
+    enum Clock
+    {
+        WallTime = 1,
+        CpuTime = 2,
+        AllTime = 3
+    };
+
+    // Accumulates the time from construction to destruction into a phase
+    // of a profile.  Does nothing if the profile is null.
+    class Timer
+    {
+    public:
+        Timer(StageProfile *profile, Phase phase, Clock clock = AllTime);
+        ~Timer();
+
+    private:
+        StageProfile *m_profile;
+        Phase m_phase;
+        Clock m_clock;
+        std::chrono::steady_clock::time_point m_wallStart;
+        double m_cpuStart;
+    };
+
+    StageProfile();
+
+    void addPoints(point_count_t in, point_count_t out);
+    void updateMemory(std::size_t bytes);
+    void toMetadata(MetadataNode parent) const;
+
+    // CPU time used by the calling thread, in seconds.
+    static double cpuTime();
+
+private:
+    void addWall(Phase phase, double seconds);
+    void addCpu(Phase phase, double seconds);
+
+    mutable std::mutex m_mutex;
+    double m_wall[NumPhases];
+    double m_cpu[NumPhases];
+    bool m_used[NumPhases];
+    point_count_t m_pointsIn;
+    point_count_t m_pointsOut;
+    std::size_t m_peakBytes;
+};
+
+} // namespace pdal
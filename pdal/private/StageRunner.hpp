@@ -34,10 +34,14 @@
 
 #pragma once
 
+#include <exception>
 #include <memory>
 
 #include <pdal/Stage.hpp>
 
+#include "Executor.hpp"
+#include "StageProfile.hpp"
+
 namespace pdal
 {
 
@@ -48,17 +52,45 @@ public:
         m_stage(s), m_view(view)
     {}
 
-    // For now this is all synchronous
+    // Run the view through the stage on the calling thread.
     void run()
-        { m_viewSet = m_stage->run(m_view); }
+    {
+        StageProfile::Timer t(m_stage->m_profile.get(), StageProfile::Run,
+            StageProfile::CpuTime);
+        m_viewSet = m_stage->run(m_view);
+    }
+
+    // Queue the view to be run through the stage in a task group.  The
+    // group must be waited for before calling wait().
+    void run(TaskGroup& group)
+    {
+        group.run([this]()
+        {
+            try
+            {
+                StageProfile::Timer t(m_stage->m_profile.get(),
+                    StageProfile::Run, StageProfile::CpuTime);
+                m_viewSet = m_stage->run(m_view);
+            }
+            catch (...)
+            {
+                m_error = std::current_exception();
+            }
+        });
+    }
 
     PointViewSet wait()
-        { return m_viewSet; }
+    {
+        if (m_error)
+            std::rethrow_exception(m_error);
+        return m_viewSet;
+    }
 
 private:
     Stage *m_stage;
     PointViewPtr m_view;
     PointViewSet m_viewSet;
+    std::exception_ptr m_error;
 };
 typedef std::shared_ptr<StageRunner> StageRunnerPtr;
 
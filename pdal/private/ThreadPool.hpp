@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright (c) 2020, Hobu Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following
+ * conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ ****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pdal/Log.hpp>
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+class PDAL_DLL ThreadPool
+{
+public:
+    // After numThreads tasks are actively running, and queueSize tasks have
+    // been enqueued to wait for an available worker thread, subsequent calls
+    // to ThreadPool::add will block until an enqueued task has been popped
+    // from the queue.  Errors thrown by tasks are kept in errors() and,
+    // if a log is provided, written to it.
+    ThreadPool(std::size_t numThreads, std::size_t queueSize = 1,
+            LogPtr log = LogPtr()) :
+        m_log(log), m_numThreads(std::max<std::size_t>(numThreads, 1)),
+        m_queueSize(std::max<std::size_t>(queueSize, 1))
+    {
+        go();
+    }
+
+    ~ThreadPool()
+        { join(); }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Start worker threads.
+    void go();
+
+    // Disallow the addition of new tasks and wait for all currently running
+    // tasks to complete.
+    void join();
+
+    // Wait for all current tasks to complete.  As opposed to join, tasks may
+    // continue to be added while a thread is await()-ing the queue to empty.
+    void await();
+
+    // Add a threaded task, blocking until a thread is available.  If join() is
+    // called, add() may not be called again until go() is called and
+    // completes.
+    void add(std::function<void()> task);
+
+    // Not thread-safe, pool should be joined or awaited before calling.
+    const std::vector<std::string>& errors() const
+        { return m_errors; }
+
+    std::size_t size() const
+        { return m_numThreads; }
+    std::size_t numThreads() const
+        { return m_numThreads; }
+
+private:
+    // Worker thread function.  Wait for a task and run it - or if join() is
+    // called, complete any outstanding task and return.
+    void work();
+
+    LogPtr m_log;
+    std::size_t m_numThreads;
+    std::size_t m_queueSize;
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void()>> m_tasks;
+    std::vector<std::string> m_errors;
+    std::size_t m_outstanding = 0;
+    bool m_running = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_produceCv;
+    std::condition_variable m_consumeCv;
+};
+
+} // namespace pdal
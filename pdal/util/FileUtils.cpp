@@ -34,10 +34,15 @@
 
 #include <sys/stat.h>
 
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #ifndef _WIN32
+#include <fcntl.h>
 #include <glob.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #else
 #include <codecvt>
 #include <Windows.h>
@@ -444,6 +449,118 @@ std::vector<std::string> glob(std::string path)
     return filenames;
 }
 
+
+MapContext mapFile(const std::string& filename)
+{
+    MapContext ctx;
+
+#ifndef _WIN32
+    ctx.m_fd = ::open(filename.c_str(), O_RDONLY);
+    if (ctx.m_fd == -1)
+    {
+        ctx.m_error = "Unable to open '" + filename + "': " +
+            std::strerror(errno) + ".";
+        return ctx;
+    }
+
+    struct stat st;
+    if (::fstat(ctx.m_fd, &st) != 0 || st.st_size == 0)
+    {
+        ctx.m_error = "Unable to map empty or unreadable file '" +
+            filename + "'.";
+        ::close(ctx.m_fd);
+        ctx.m_fd = -1;
+        return ctx;
+    }
+    ctx.m_size = (uintmax_t)st.st_size;
+
+    void *addr = ::mmap(nullptr, ctx.m_size, PROT_READ, MAP_SHARED,
+        ctx.m_fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        ctx.m_error = "Unable to map '" + filename + "': " +
+            std::strerror(errno) + ".";
+        ::close(ctx.m_fd);
+        ctx.m_fd = -1;
+        ctx.m_size = 0;
+        return ctx;
+    }
+    ::posix_madvise(addr, ctx.m_size, POSIX_MADV_SEQUENTIAL);
+    ctx.m_addr = reinterpret_cast<char *>(addr);
+#else
+    HANDLE fh = CreateFileW(toNative(filename).data(), GENERIC_READ,
+        FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fh == INVALID_HANDLE_VALUE)
+    {
+        ctx.m_error = "Unable to open '" + filename + "'.";
+        return ctx;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fh, &size) || size.QuadPart == 0)
+    {
+        ctx.m_error = "Unable to map empty or unreadable file '" +
+            filename + "'.";
+        CloseHandle(fh);
+        return ctx;
+    }
+    ctx.m_size = (uintmax_t)size.QuadPart;
+
+    HANDLE mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fh);
+    if (mh == NULL)
+    {
+        ctx.m_error = "Unable to map '" + filename + "'.";
+        ctx.m_size = 0;
+        return ctx;
+    }
+    ctx.m_addr = reinterpret_cast<char *>(
+        MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0));
+    if (!ctx.m_addr)
+    {
+        ctx.m_error = "Unable to map '" + filename + "'.";
+        ctx.m_size = 0;
+        CloseHandle(mh);
+        return ctx;
+    }
+    ctx.m_handle = mh;
+#endif
+    return ctx;
+}
+
+
+void unmapFile(MapContext& ctx)
+{
+#ifndef _WIN32
+    if (ctx.m_addr)
+        ::munmap(ctx.m_addr, ctx.m_size);
+    if (ctx.m_fd != -1)
+        ::close(ctx.m_fd);
+#else
+    if (ctx.m_addr)
+        UnmapViewOfFile(ctx.m_addr);
+    if (ctx.m_handle)
+        CloseHandle((HANDLE)ctx.m_handle);
+#endif
+    ctx = MapContext();
+}
+
+
+void prefetchMap(const MapContext& ctx, uintmax_t pos, uintmax_t size)
+{
+#ifndef _WIN32
+    if (!ctx.m_addr || pos >= ctx.m_size)
+        return;
+    size = (std::min)(size, ctx.m_size - pos);
+
+    // The advised range must start on a page boundary.
+    static const uintmax_t pageSize = (uintmax_t)::sysconf(_SC_PAGESIZE);
+    uintmax_t start = pos - (pos % pageSize);
+    ::posix_madvise(ctx.m_addr + start, size + (pos - start),
+        POSIX_MADV_WILLNEED);
+#endif
+}
+
 } // namespace FileUtils
 
 } // namespace pdal
@@ -258,6 +258,59 @@ namespace FileUtils
       \return  List of files that correspond to provided file specification.
     */
     PDAL_DLL std::vector<std::string> glob(std::string filespec);
+
+    /**
+      State of a read-only memory mapping of a file.  The address is null
+      if the mapping failed, in which case 'm_error' describes the problem.
+    */
+    struct MapContext
+    {
+        MapContext() : m_addr(nullptr), m_size(0), m_fd(-1)
+        {}
+
+        char *addr() const
+            { return m_addr; }
+        uintmax_t size() const
+            { return m_size; }
+        std::string what() const
+            { return m_error; }
+
+        char *m_addr;
+        uintmax_t m_size;
+        int m_fd;
+#ifdef _WIN32
+        void *m_handle = nullptr;
+#endif
+        std::string m_error;
+    };
+
+    /**
+      Map a file read-only into memory.  The kernel is advised that the
+      mapping will be read sequentially.
+
+      \param filename  Name of file to map.
+      \return  Context of the mapping.  Check 'addr()' for success.
+    */
+    PDAL_DLL MapContext mapFile(const std::string& filename);
+
+    /**
+      Unmap a file mapped with mapFile() and close it.
+
+      \param ctx  Context of the mapping.  Reset on return.
+    */
+    PDAL_DLL void unmapFile(MapContext& ctx);
+
+    /**
+      Advise the kernel that a range of a mapped file will be read soon,
+      so that it can be paged in ahead of access.  Has no effect where
+      not supported.
+
+      \param ctx  Context of the mapping.
+      \param pos  Offset of the start of the range.
+      \param size  Size of the range in bytes.
+    */
+    PDAL_DLL void prefetchMap(const MapContext& ctx, uintmax_t pos,
+        uintmax_t size);
 }
 
 } // namespace pdal
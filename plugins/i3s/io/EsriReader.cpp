@@ -36,11 +36,11 @@
 
 #include <Eigen/Geometry>
 #include <pdal/private/SrsTransform.hpp>
+#include <pdal/private/ThreadPool.hpp>
 
 #include "../lepcc/src/include/lepcc_types.h"
 
 #include "EsriUtil.hpp"
-#include "pool.hpp"
 #include "SlpkExtractor.hpp"
 
 
@@ -359,7 +359,7 @@ point_count_t EsriReader::read(PointViewPtr view, point_count_t count)
     // Will create a thread pool on the createview class and iterate
     // through the node list for the nodes to be pulled.
     log()->get(LogLevel::Debug) << "Fetching binaries" << std::endl;
-    Pool p(m_args.threads);
+    ThreadPool p(m_args.threads, 1, log());
     for (std::size_t i = 0; i < nodes.size(); i++)
     {
         log()->get(LogLevel::Debug) << "\r" << i << "/" << nodes.size();
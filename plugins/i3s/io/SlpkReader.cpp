@@ -35,7 +35,6 @@
 #include "SlpkReader.hpp"
 #include <pdal/util/FileUtils.hpp>
 
-#include "pool.hpp"
 #include "EsriUtil.hpp"
 #include "SlpkExtractor.hpp"
 
@@ -1,219 +0,0 @@
-/******************************************************************************
- * Copyright (c) 2018, Connor Manning
- *
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following
- * conditions are met:
- *
- *     * Redistributions of source code must retain the above copyright
- *       notice, this list of conditions and the following disclaimer.
- *     * Redistributions in binary form must reproduce the above copyright
- *       notice, this list of conditions and the following disclaimer in
- *       the documentation and/or other materials provided
- *       with the distribution.
- *     * Neither the name of the Martin Isenburg or Iowa Department
- *       of Natural Resources nor the names of its contributors may be
- *       used to endorse or promote products derived from this software
- *       without specific prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
- * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
- * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
- * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
- * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
- * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
- * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
- * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
- * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
- * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
- * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
- * OF SUCH DAMAGE.
- ****************************************************************************/
-
-#pragma once
-#include <condition_variable>
-#include <queue>
-#include <functional>
-#include <vector>
-#include <mutex>
-#include <thread>
-#include <iostream>
-
-namespace pdal
-{
-
-class PDAL_DLL Pool
-{
-public:
-    // After numThreads tasks are actively running, and queueSize tasks have
-    // been enqueued to wait for an available worker thread, subsequent calls
-    // to Pool::add will block until an enqueued task has been popped from the
-    // queue.
-    Pool(
-            std::size_t numThreads,
-            std::size_t queueSize = 1,
-            bool verbose = true)
-        : m_verbose(verbose)
-        , m_numThreads(std::max<std::size_t>(numThreads, 1))
-        , m_queueSize(std::max<std::size_t>(queueSize, 1))
-    {
-        go();
-    }
-
-    ~Pool() { join(); }
-
-    // Start worker threads.
-    void go()
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_running) return;
-        m_running = true;
-
-        for (std::size_t i(0); i < m_numThreads; ++i)
-        {
-            m_threads.emplace_back([this]() { work(); });
-        }
-    }
-
-    // Disallow the addition of new tasks and wait for all currently running
-    // tasks to complete.
-    void join()
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (!m_running) return;
-        m_running = false;
-        lock.unlock();
-
-        m_consumeCv.notify_all();
-        for (auto& t : m_threads) t.join();
-        m_threads.clear();
-    }
-
-    // Wait for all current tasks to complete.  As opposed to join, tasks may
-    // continue to be added while a thread is await()-ing the queue to empty.
-    void await()
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_produceCv.wait(lock, [this]()
-        {
-            return !m_outstanding && m_tasks.empty();
-        });
-    }
-
-    // Join and restart.
-    void cycle() { join(); go(); }
-
-    // Change the number of threads.  Current threads will be joined.
-    void resize(const std::size_t numThreads)
-    {
-        join();
-        m_numThreads = numThreads;
-        go();
-    }
-
-    // Not thread-safe, pool should be joined before calling.
-    const std::vector<std::string>& errors() const { return m_errors; }
-
-    // Add a threaded task, blocking until a thread is available.  If join() is
-    // called, add() may not be called again until go() is called and completes.
-    void add(std::function<void()> task)
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (!m_running)
-        {
-            throw std::runtime_error(
-                    "Attempted to add a task to a stopped Pool");
-        }
-
-        m_produceCv.wait(lock, [this]()
-        {
-            return m_tasks.size() < m_queueSize;
-        });
-
-        m_tasks.emplace(task);
-
-        // Notify worker that a task is available.
-        lock.unlock();
-        m_consumeCv.notify_all();
-    }
-
-
-    std::size_t size() const { return m_numThreads; }
-    std::size_t numThreads() const { return m_numThreads; }
-
-private:
-    // Worker thread function.  Wait for a task and run it - or if stop() is
-    // called, complete any outstanding task and return.
-    void work()
-    {
-        while (true)
-        {
-            std::unique_lock<std::mutex> lock(m_mutex);
-            m_consumeCv.wait(lock, [this]()
-            {
-                return m_tasks.size() || !m_running;
-            });
-
-            if (m_tasks.size())
-            {
-                ++m_outstanding;
-                auto task(std::move(m_tasks.front()));
-                m_tasks.pop();
-
-                lock.unlock();
-
-                // Notify add(), which may be waiting for a spot in the queue.
-                m_produceCv.notify_all();
-
-                std::string err;
-                try { task(); }
-                catch (std::exception& e) { err = e.what(); }
-                catch (...) { err = "Unknown error"; }
-
-                lock.lock();
-                --m_outstanding;
-                if (err.size())
-                {
-                    if (m_verbose)
-                    {
-                        std::cout << "Exception in pool task: " << err <<
-                            std::endl;
-                    }
-                    m_errors.push_back(err);
-                }
-                lock.unlock();
-
-                // Notify await(), which may be waiting for a running task.
-                m_produceCv.notify_all();
-            }
-            else if (!m_running)
-            {
-                return;
-            }
-        }
-    }
-
-    bool m_verbose;
-    std::size_t m_numThreads;
-    std::size_t m_queueSize;
-    std::vector<std::thread> m_threads;
-    std::queue<std::function<void()>> m_tasks;
-
-    std::vector<std::string> m_errors;
-    std::mutex m_errorMutex;
-
-    std::size_t m_outstanding = 0;
-    bool m_running = false;
-
-    mutable std::mutex m_mutex;
-    std::condition_variable m_produceCv;
-    std::condition_variable m_consumeCv;
-
-    // Disable copy/assignment.
-    Pool(const Pool& other);
-    Pool& operator=(const Pool& other);
-};
-
-} // namespace pdal
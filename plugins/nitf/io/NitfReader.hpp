@@ -110,6 +110,8 @@ class PDAL_DLL NitfReader : public LasReader
         NitfStreamIf(const std::string& filename, ShiftStream::off_type off)
         {
             m_istream = new ShiftStream(filename, off);
+            m_filename = filename;
+            m_offset = off;
         }
 
         virtual ~NitfStreamIf()
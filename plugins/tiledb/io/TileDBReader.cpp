@@ -159,9 +159,14 @@ void TileDBReader::addDimensions(PointLayoutPtr layout)
         m_dims.push_back(di);
     }
 
+    // Attributes that aren't used aren't added to the query, so they're
+    // never read from the array.
     auto attrs = m_array->schema().attributes();
     for (const auto& a : attrs)
     {
+        if (!dimUsed(a.first))
+            continue;
+
         DimInfo di;
 
         di.m_name = a.first;
@@ -0,0 +1,513 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+// pdal_bench: throughput benchmarks for common readers, writers and filters.
+//
+// Input data is generated with readers.faux, so no test data is needed.
+// Each benchmark is run several times and the fastest run is reported in
+// points per second along with the number of bytes per point (file bytes
+// for readers and writers, in-memory point size otherwise).
+
+#include <chrono>
+#include <functional>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <pdal/KDIndex.hpp>
+#include <pdal/Options.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/pdal_config.hpp>
+#include <pdal/pdal_features.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <io/BufferReader.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Measurement of a single run of a benchmark.
+struct Sample
+{
+    Sample() : points(0), seconds(0), bytes(0)
+    {}
+
+    point_count_t points;
+    double seconds;
+    uintmax_t bytes;
+};
+
+struct Result
+{
+    std::string name;
+    Sample best;
+    int runs;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+
+class Bench
+{
+public:
+    Bench();
+
+    int run(int argc, char *argv[]);
+
+private:
+    using Func = std::function<Sample()>;
+
+    void addArgs(ProgramArgs& args);
+    void addBenchmarks();
+    void add(const std::string& name, Func f);
+    std::string tempFile(const std::string& name) const;
+    Options fauxOptions() const;
+    PointViewPtr generate(PointTableRef table);
+    Sample write(const std::string& driver, const std::string& filename,
+        Options opts);
+    Sample read(const std::string& driver, const std::string& filename,
+        const Func& create);
+    Sample filter(const std::string& driver, Options opts);
+    Sample execute(bool stream);
+    void report(std::ostream& out, const std::vector<Result>& results);
+
+    point_count_t m_count;
+    int m_repeat;
+    std::string m_format;
+    std::string m_output;
+    std::string m_match;
+    std::string m_tempDir;
+    bool m_list;
+    std::vector<std::pair<std::string, Func>> m_benchmarks;
+    std::vector<std::string> m_files;
+};
+
+
+Bench::Bench() : m_count(0), m_repeat(0), m_list(false)
+{}
+
+
+void Bench::addArgs(ProgramArgs& args)
+{
+    args.add("count", "Number of points in each benchmark", m_count,
+        (point_count_t)1000000);
+    args.add("repeat", "Number of runs of each benchmark.  The fastest run "
+        "is reported.", m_repeat, 3);
+    args.add("format", "Output format ('json' or 'csv')", m_format, "json");
+    args.add("output", "Output filename (default is stdout)", m_output);
+    args.add("match", "Run only benchmarks whose name contains this string",
+        m_match);
+    args.add("temp-dir", "Directory for temporary files", m_tempDir);
+    args.add("list", "List benchmarks and exit", m_list);
+}
+
+
+void Bench::add(const std::string& name, Func f)
+{
+    m_benchmarks.push_back(std::make_pair(name, f));
+}
+
+
+std::string Bench::tempFile(const std::string& name) const
+{
+    std::string dir = m_tempDir;
+    if (dir.empty())
+        Utils::getenv("TMPDIR", dir);
+    if (dir.empty())
+        dir = ".";
+    return dir + "/pdal_bench_" + name;
+}
+
+
+Options Bench::fauxOptions() const
+{
+    Options opts;
+    opts.add("count", m_count);
+    opts.add("mode", "random");
+    opts.add("bounds", BOX3D(-10, 40, 0, -9, 41, 1000));
+    opts.add("number_of_returns", 3);
+    return opts;
+}
+
+
+PointViewPtr Bench::generate(PointTableRef table)
+{
+    StageFactory f;
+
+    Stage *faux = f.createStage("readers.faux");
+    faux->setOptions(fauxOptions());
+    faux->prepare(table);
+    PointViewSet s = faux->execute(table);
+    return *s.begin();
+}
+
+
+Sample Bench::write(const std::string& driver, const std::string& filename,
+    Options opts)
+{
+    PointTable table;
+    PointViewPtr view = generate(table);
+
+    StageFactory f;
+    BufferReader r;
+    r.addView(view);
+
+    Stage *w = f.createStage(driver);
+    opts.add("filename", filename);
+    w->setOptions(opts);
+    w->setInput(r);
+    w->prepare(table);
+
+    Sample s;
+    Clock::time_point start = Clock::now();
+    w->execute(table);
+    s.seconds = elapsed(start);
+    s.points = view->size();
+    s.bytes = FileUtils::fileSize(filename);
+    return s;
+}
+
+
+// Read 'filename', first running 'create' to write it if it doesn't exist.
+Sample Bench::read(const std::string& driver, const std::string& filename,
+    const Func& create)
+{
+    if (!FileUtils::fileExists(filename))
+        create();
+
+    StageFactory f;
+    PointTable table;
+
+    Stage *r = f.createStage(driver);
+    Options opts;
+    opts.add("filename", filename);
+    r->setOptions(opts);
+    r->prepare(table);
+
+    Sample s;
+    Clock::time_point start = Clock::now();
+    PointViewSet views = r->execute(table);
+    s.seconds = elapsed(start);
+    s.points = (*views.begin())->size();
+    s.bytes = FileUtils::fileSize(filename);
+    return s;
+}
+
+
+Sample Bench::filter(const std::string& driver, Options opts)
+{
+    PointTable table;
+    PointViewPtr view = generate(table);
+
+    StageFactory f;
+    BufferReader r;
+    r.addView(view);
+
+    Stage *filter = f.createStage(driver);
+    filter->setOptions(opts);
+    filter->setInput(r);
+    filter->prepare(table);
+
+    Sample s;
+    Clock::time_point start = Clock::now();
+    filter->execute(table);
+    s.seconds = elapsed(start);
+    s.points = view->size();
+    s.bytes = view->size() * table.layout()->pointSize();
+    return s;
+}
+
+
+// Generate points, compute statistics and discard the points, either in
+// standard or in stream mode.
+Sample Bench::execute(bool stream)
+{
+    StageFactory f;
+
+    Stage *faux = f.createStage("readers.faux");
+    faux->setOptions(fauxOptions());
+    Stage *stats = f.createStage("filters.stats");
+    stats->setInput(*faux);
+    Stage *null = f.createStage("writers.null");
+    null->setInput(*stats);
+
+    Sample s;
+    s.points = m_count;
+    if (stream)
+    {
+        FixedPointTable table(10000);
+        null->prepare(table);
+        Clock::time_point start = Clock::now();
+        null->execute(table);
+        s.seconds = elapsed(start);
+        s.bytes = m_count * table.layout()->pointSize();
+    }
+    else
+    {
+        PointTable table;
+        null->prepare(table);
+        Clock::time_point start = Clock::now();
+        null->execute(table);
+        s.seconds = elapsed(start);
+        s.bytes = m_count * table.layout()->pointSize();
+    }
+    return s;
+}
+
+
+void Bench::addBenchmarks()
+{
+    const std::string las = tempFile("points.las");
+    const std::string laz = tempFile("points.laz");
+    const std::string bpf = tempFile("points.bpf");
+    const std::string txt = tempFile("points.txt");
+    m_files = { las, laz, bpf, txt };
+
+    Options lasOpts;
+    lasOpts.add("scale_x", .0000001);
+    lasOpts.add("scale_y", .0000001);
+    lasOpts.add("offset_x", "auto");
+    lasOpts.add("offset_y", "auto");
+    Func lasWrite = [=](){ return write("writers.las", las, lasOpts); };
+    add("writers.las", lasWrite);
+    add("readers.las", [=](){ return read("readers.las", las, lasWrite); });
+
+#if defined(PDAL_HAVE_LASZIP) || defined(PDAL_HAVE_LAZPERF)
+    Options lazOpts(lasOpts);
+#ifdef PDAL_HAVE_LAZPERF
+    lazOpts.add("compression", "lazperf");
+#else
+    lazOpts.add("compression", "laszip");
+#endif
+    Func lazWrite = [=](){ return write("writers.las", laz, lazOpts); };
+    add("writers.las.laz", lazWrite);
+    add("readers.las.laz",
+        [=](){ return read("readers.las", laz, lazWrite); });
+#endif
+
+    Func bpfWrite = [=](){ return write("writers.bpf", bpf, Options()); };
+    add("writers.bpf", bpfWrite);
+    add("readers.bpf", [=](){ return read("readers.bpf", bpf, bpfWrite); });
+
+    Options txtOpts;
+    txtOpts.add("precision", 7);
+    Func txtWrite = [=](){ return write("writers.text", txt, txtOpts); };
+    add("writers.text", txtWrite);
+    add("readers.text", [=](){ return read("readers.text", txt, txtWrite); });
+
+    add("kdindex.build", [this]()
+    {
+        PointTable table;
+        PointViewPtr view = generate(table);
+
+        Sample s;
+        Clock::time_point start = Clock::now();
+        KD3Index index(*view);
+        index.build();
+        s.seconds = elapsed(start);
+        s.points = view->size();
+        s.bytes = view->size() * table.layout()->pointSize();
+        return s;
+    });
+
+    add("kdindex.knn", [this]()
+    {
+        PointTable table;
+        PointViewPtr view = generate(table);
+        KD3Index index(*view);
+        index.build();
+
+        PointIdList ids(view->size());
+        for (PointId i = 0; i < view->size(); ++i)
+            ids[i] = i;
+
+        Sample s;
+        Clock::time_point start = Clock::now();
+        NeighborResults res = index.knnSearch(ids, 8);
+        s.seconds = elapsed(start);
+        s.points = res.size();
+        s.bytes = view->size() * table.layout()->pointSize();
+        return s;
+    });
+
+    Options sortOpts;
+    sortOpts.add("dimension", "X");
+    add("filters.sort", [=](){ return filter("filters.sort", sortOpts); });
+    add("filters.chipper",
+        [=](){ return filter("filters.chipper", Options()); });
+    Options splitOpts;
+    splitOpts.add("length", .1);
+    add("filters.splitter",
+        [=](){ return filter("filters.splitter", splitOpts); });
+    add("filters.stats", [=](){ return filter("filters.stats", Options()); });
+    Options reproOpts;
+    reproOpts.add("in_srs", "EPSG:4326");
+    reproOpts.add("out_srs", "EPSG:3857");
+    add("filters.reprojection",
+        [=](){ return filter("filters.reprojection", reproOpts); });
+
+    add("execute.standard", [this](){ return execute(false); });
+    add("execute.stream", [this](){ return execute(true); });
+}
+
+
+void Bench::report(std::ostream& out, const std::vector<Result>& results)
+{
+    out << std::fixed;
+    if (m_format == "csv")
+    {
+        out << "name,points,runs,seconds,points_per_sec,bytes_per_point\n";
+        for (const Result& r : results)
+        {
+            const Sample& s = r.best;
+            out << r.name << "," << s.points << "," << r.runs << "," <<
+                std::setprecision(6) << s.seconds << "," <<
+                std::setprecision(0) << (s.points / s.seconds) << "," <<
+                std::setprecision(2) << ((double)s.bytes / s.points) << "\n";
+        }
+        return;
+    }
+
+    out << "{\n  \"pdal_version\": \"" << Config::fullVersionString() <<
+        "\",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r = results[i];
+        const Sample& s = r.best;
+        out << (i ? "," : "") << "\n    {\n" <<
+            "      \"name\": \"" << r.name << "\",\n" <<
+            "      \"points\": " << s.points << ",\n" <<
+            "      \"runs\": " << r.runs << ",\n" <<
+            "      \"seconds\": " << std::setprecision(6) << s.seconds <<
+                ",\n" <<
+            "      \"points_per_sec\": " << std::setprecision(0) <<
+                (s.points / s.seconds) << ",\n" <<
+            "      \"bytes_per_point\": " << std::setprecision(2) <<
+                ((double)s.bytes / s.points) << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+
+int Bench::run(int argc, char *argv[])
+{
+    ProgramArgs args;
+    addArgs(args);
+    try
+    {
+        StringList argList;
+        for (int i = 1; i < argc; ++i)
+            argList.push_back(argv[i]);
+        args.parse(argList);
+        if (m_format != "json" && m_format != "csv")
+            throw arg_error("Invalid output format '" + m_format + "'.");
+        if (m_count == 0 || m_repeat < 1)
+            throw arg_error("'count' and 'repeat' must be positive.");
+    }
+    catch (const arg_error& err)
+    {
+        std::cerr << "pdal_bench: " << err.what() << "\n\n";
+        std::cerr << "usage: pdal_bench [options]\n";
+        args.dump(std::cerr, 2, 80);
+        return -1;
+    }
+
+    addBenchmarks();
+    if (m_list)
+    {
+        for (auto& b : m_benchmarks)
+            std::cout << b.first << "\n";
+        return 0;
+    }
+
+    std::vector<Result> results;
+    int status = 0;
+    for (auto& b : m_benchmarks)
+    {
+        if (b.first.find(m_match) == std::string::npos)
+            continue;
+
+        Result r;
+        r.name = b.first;
+        r.runs = m_repeat;
+        try
+        {
+            for (int i = 0; i < m_repeat; ++i)
+            {
+                Sample s = b.second();
+                if (i == 0 || s.seconds < r.best.seconds)
+                    r.best = s;
+            }
+        }
+        catch (const std::exception& err)
+        {
+            std::cerr << "pdal_bench: " << b.first << " failed: " <<
+                err.what() << "\n";
+            status = 1;
+            continue;
+        }
+        std::cerr << r.name << ": " << std::fixed << std::setprecision(0) <<
+            (r.best.points / r.best.seconds) << " points/sec\n";
+        results.push_back(r);
+    }
+
+    for (const std::string& filename : m_files)
+        FileUtils::deleteFile(filename);
+
+    if (m_output.empty())
+        report(std::cout, results);
+    else
+    {
+        std::ofstream out(m_output);
+        report(out, results);
+    }
+    return status;
+}
+
+} // unnamed namespace
+
+
+int main(int argc, char *argv[])
+{
+    return Bench().run(argc, argv);
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+
+#include <pdal/private/Executor.hpp>
+#include <pdal/private/ThreadPool.hpp>
+
+using namespace pdal;
+
+TEST(ExecutorTest, nested)
+{
+    Executor executor(3);
+    EXPECT_EQ(executor.threads(), 3U);
+
+    // Tasks that wait for tasks of their own must not deadlock, even with
+    // more tasks waiting than there are threads.
+    std::atomic<size_t> count(0);
+    parallelFor(0, 100, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            parallelFor(0, 100, 1, [&](size_t b, size_t e)
+                { count += e - b; }, executor);
+    }, executor);
+    EXPECT_EQ(count, 10000U);
+}
+
+TEST(ExecutorTest, ranges)
+{
+    Executor executor(2);
+
+    std::vector<int> hits(1001);
+    parallelFor(0, hits.size(), 10, [&](size_t begin, size_t end)
+    {
+        EXPECT_LT(begin, end);
+        for (size_t i = begin; i < end; ++i)
+            hits[i]++;
+    }, executor);
+    for (int h : hits)
+        EXPECT_EQ(h, 1);
+
+    bool called = false;
+    parallelFor(5, 5, 1, [&](size_t, size_t){ called = true; }, executor);
+    EXPECT_FALSE(called);
+}
+
+TEST(ExecutorTest, errors)
+{
+    Executor executor(2);
+
+    TaskGroup group(executor);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 10; ++i)
+        group.run([&count, i]()
+        {
+            count++;
+            if (i == 5)
+                throw std::runtime_error("Task failed.");
+        });
+    EXPECT_THROW(group.wait(), std::runtime_error);
+    EXPECT_EQ(count, 10);
+
+    // The error is reported once.
+    group.run([](){});
+    EXPECT_NO_THROW(group.wait());
+
+    auto f = executor.async([]() -> int { throw std::runtime_error("x"); });
+    executor.wait(f);
+    EXPECT_THROW(f.get(), std::runtime_error);
+}
+
+TEST(ExecutorTest, async)
+{
+    Executor executor(1);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 20; ++i)
+        results.push_back(executor.async([i]() { return i * i; }));
+    for (int i = 0; i < 20; ++i)
+    {
+        executor.wait(results[i]);
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+}
+
+// Errors thrown by ThreadPool tasks are kept and written to the pool's log.
+TEST(ExecutorTest, threadPoolErrors)
+{
+    std::ostringstream out;
+    LogPtr log(Log::makeLog("", &out));
+
+    ThreadPool pool(2, 1, log);
+    pool.add([](){ throw std::runtime_error("task failed"); });
+    pool.add([](){});
+    pool.join();
+
+    ASSERT_EQ(pool.errors().size(), 1U);
+    EXPECT_EQ(pool.errors().front(), "task failed");
+    EXPECT_NE(out.str().find("task failed"), std::string::npos);
+}
@@ -318,3 +318,30 @@ TEST(FileUtilsTest, test_file_ops_with_unicode_paths)
         EXPECT_FALSE(FileUtils::directoryExists(japanese_dir));
     }
 }
+
+TEST(FileUtilsTest, mapFile)
+{
+    std::string tmp(Support::temppath("unittest_map.tmp"));
+
+    FileUtils::deleteFile(tmp);
+    std::ostream* ostr = FileUtils::createFile(tmp);
+    *ostr << "mapped data";
+    FileUtils::closeFile(ostr);
+
+    FileUtils::MapContext ctx = FileUtils::mapFile(tmp);
+    ASSERT_NE(ctx.addr(), nullptr);
+    EXPECT_EQ(ctx.size(), 11U);
+    EXPECT_EQ(std::string(ctx.addr(), ctx.size()), "mapped data");
+
+    // Prefetching past the end of the file is ignored.
+    FileUtils::prefetchMap(ctx, 7, 100);
+    FileUtils::prefetchMap(ctx, 100, 100);
+
+    FileUtils::unmapFile(ctx);
+    EXPECT_EQ(ctx.addr(), nullptr);
+    FileUtils::deleteFile(tmp);
+
+    ctx = FileUtils::mapFile(tmp);
+    EXPECT_EQ(ctx.addr(), nullptr);
+    EXPECT_FALSE(ctx.what().empty());
+}
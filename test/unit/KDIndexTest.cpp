@@ -378,3 +378,58 @@ TEST(KDIndex, radius3D)
     EXPECT_EQ(ids[2], 2u);
 }
 
+
+TEST(KDIndex, batch3D)
+{
+    PointTable table;
+    PointLayoutPtr layout = table.layout();
+    PointView view(table);
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointId id = 0;
+    for (int x = 0; x < 10; ++x)
+        for (int y = 0; y < 10; ++y)
+            for (int z = 0; z < 10; ++z)
+            {
+                view.setField(Dimension::Id::X, id, x + .1 * y);
+                view.setField(Dimension::Id::Y, id, y + .01 * z);
+                view.setField(Dimension::Id::Z, id, z * 1.5);
+                id++;
+            }
+
+    KD3Index index(view);
+    index.build();
+
+    PointIdList ids;
+    for (PointId i = 0; i < view.size(); i += 3)
+        ids.push_back(i);
+
+    NeighborResults knn = index.knnSearch(ids, 8, 4);
+    ASSERT_EQ(knn.size(), ids.size());
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        PointIdList expected = index.neighbors(ids[i], 8);
+        ASSERT_EQ(knn.count(i), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j)
+            EXPECT_EQ(knn.neighbors(i)[j], expected[j]);
+        EXPECT_EQ(knn.distances(i)[0], 0.0);
+    }
+
+    NeighborResults rad = index.radius(ids, 1.2, 4);
+    ASSERT_EQ(rad.size(), ids.size());
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        PointIdList expected = index.radius(ids[i], 1.2);
+        ASSERT_EQ(rad.count(i), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j)
+            EXPECT_EQ(rad.neighbors(i)[j], expected[j]);
+    }
+
+    // Single-threaded results match.
+    NeighborResults rad1 = index.radius(ids, 1.2);
+    EXPECT_EQ(rad1.offsets, rad.offsets);
+    EXPECT_EQ(rad1.indices, rad.indices);
+}
@@ -32,6 +32,8 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <thread>
+
 #include <pdal/pdal_test_main.hpp>
 #include <pdal/Log.hpp>
 #include <pdal/util/FileUtils.hpp>
@@ -86,4 +88,29 @@ TEST(Log, t2)
     FileUtils::deleteFile(out);
 }
 
+// Leaders are kept per thread.  A thread without leaders of its own uses
+// those of the thread that created the log.
+TEST(Log, threadLeaders)
+{
+    LogPtr l(Log::makeLog("main", "devnull"));
+    l->pushLeader("stage");
+
+    std::string inherited;
+    std::string pushed;
+    std::thread t([&]()
+    {
+        inherited = l->leader();
+        l->pushLeader("worker");
+        pushed = l->leader();
+        l->popLeader();
+    });
+    t.join();
+
+    EXPECT_EQ(inherited, "stage");
+    EXPECT_EQ(pushed, "worker");
+    EXPECT_EQ(l->leader(), "stage");
+    l->popLeader();
+    EXPECT_EQ(l->leader(), "main");
+}
+
 }
@@ -39,6 +39,7 @@
 #include <pdal/Stage.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/PipelineManager.hpp>
+#include <pdal/util/Algorithm.hpp>
 #include <pdal/util/FileUtils.hpp>
 
 using namespace pdal;
@@ -238,3 +239,208 @@ TEST(PipelineManagerTest, replace)
     EXPECT_EQ(w2->getInputs().size(), 1U);
     EXPECT_EQ(w2->getInputs().front(), f2);
 }
+
+// Make sure that running views concurrently produces the same views, in the
+// same order, as running them synchronously.
+TEST(PipelineManagerTest, threads)
+{
+    auto run = [](size_t threads)
+    {
+        PipelineManager mgr;
+
+        Options ro;
+        ro.add("bounds", BOX3D(0, 0, 0, 100, 100, 0));
+        ro.add("mode", "grid");
+        Stage& r = mgr.makeReader("", "readers.faux", ro);
+
+        Options so;
+        so.add("length", 10);
+        Stage& s = mgr.makeFilter("filters.splitter", r, so);
+
+        Options to;
+        to.add("matrix", "1 0 0 5  0 1 0 0  0 0 1 0  0 0 0 1");
+        Stage& t = mgr.makeFilter("filters.transformation", s, to);
+
+        Options rangeOpts;
+        rangeOpts.add("limits", "X[0:50]");
+        mgr.makeFilter("filters.range", t, rangeOpts);
+
+        mgr.setThreads(threads);
+        mgr.execute();
+
+        std::vector<std::vector<double>> out;
+        for (PointViewPtr v : mgr.views())
+        {
+            std::vector<double> xs;
+            for (PointId i = 0; i < v->size(); ++i)
+                xs.push_back(v->getFieldAs<double>(Dimension::Id::X, i));
+            out.push_back(xs);
+        }
+        return out;
+    };
+
+    std::vector<std::vector<double>> serial = run(1);
+    std::vector<std::vector<double>> parallel = run(4);
+
+    EXPECT_EQ(serial.size(), 100U);
+    EXPECT_EQ(serial.front().size(), 100U);
+    EXPECT_EQ(serial.back().size(), 0U);
+    EXPECT_EQ(serial, parallel);
+}
+
+// Column storage holds the same points as the default table, including
+// through stages that reorder points.
+TEST(PipelineManagerTest, columnStorage)
+{
+    auto run = [](bool columns)
+    {
+        PipelineManager mgr;
+
+        Options ro;
+        ro.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+        ro.add("mode", "ramp");
+        ro.add("count", 1000);
+        Stage& r = mgr.makeReader("", "readers.faux", ro);
+
+        Options so;
+        so.add("dimension", "X");
+        so.add("order", "DESC");
+        mgr.makeFilter("filters.sort", r, so);
+
+        if (columns)
+            mgr.setColumnStorage();
+        mgr.execute();
+        EXPECT_EQ(columns, dynamic_cast<ColumnPointTable *>(
+            &mgr.pointTable()) != nullptr);
+
+        PointViewPtr v = *mgr.views().begin();
+        std::vector<double> out;
+        for (PointId i = 0; i < v->size(); ++i)
+            for (Dimension::Id d : { Dimension::Id::X, Dimension::Id::Y,
+                    Dimension::Id::Z })
+                out.push_back(v->getFieldAs<double>(d, i));
+        return out;
+    };
+
+    std::vector<double> rows = run(false);
+    EXPECT_EQ(rows.size(), 3000U);
+    EXPECT_EQ(rows, run(true));
+}
+
+// Blocks are pooled only by an allocator passed in by the caller.  Blocks
+// released by one execution are reused by the next.
+TEST(PipelineManagerTest, blockPool)
+{
+    BlockAllocator pool(false, 64 * 1024 * 1024);
+
+    auto run = [&pool]()
+    {
+        PipelineManager mgr;
+
+        Options ro;
+        ro.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+        ro.add("mode", "ramp");
+        ro.add("count", 10000);
+        mgr.makeReader("", "readers.faux", ro);
+
+        mgr.setBlockAllocation(1000, pool);
+        mgr.execute();
+        EXPECT_EQ((*mgr.views().begin())->size(), 10000U);
+    };
+
+    run();
+    const size_t pooled = pool.pooledBytes();
+    EXPECT_GT(pooled, 0U);
+    run();
+    EXPECT_EQ(pool.pooledBytes(), pooled);
+}
+
+TEST(PipelineManagerTest, profile)
+{
+    auto run = [](ExecMode mode)
+    {
+        PipelineManager mgr;
+
+        Options ro;
+        ro.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+        ro.add("mode", "ramp");
+        ro.add("count", 1000);
+        Stage& r = mgr.makeReader("", "readers.faux", ro);
+
+        Options rangeOpts;
+        rangeOpts.add("limits", "X[0:49.99]");
+        Stage& f = mgr.makeFilter("filters.range", r, rangeOpts);
+        mgr.makeFilter("filters.stats", f);
+
+        mgr.setProfiling(true);
+        EXPECT_EQ(mgr.execute(mode).m_mode, mode);
+
+        MetadataNode profile = mgr.getProfile();
+        MetadataNodeList stages = profile.children("stages");
+        EXPECT_EQ(stages.size(), 3U);
+
+        auto count = [&stages](size_t i, const std::string& name)
+        {
+            return stages[i].findChild("profile").findChild(name).
+                value<point_count_t>();
+        };
+        EXPECT_EQ(stages[0].findChild("name").value(), "readers.faux");
+        EXPECT_EQ(count(0, "points_out"), 1000U);
+        EXPECT_EQ(count(1, "points_in"), 1000U);
+        EXPECT_EQ(count(1, "points_out"), 500U);
+        EXPECT_EQ(count(2, "points_in"), 500U);
+        EXPECT_EQ(count(2, "points_out"), 500U);
+
+        const std::string phase(mode == ExecMode::Stream ?
+            "process_one" : "run");
+        MetadataNode p = stages[1].findChild("profile");
+        EXPECT_TRUE(p.findChild(phase).findChild("wall").valid());
+        EXPECT_TRUE(p.findChild("ready").findChild("cpu").valid());
+        EXPECT_GT(p.findChild("peak_table_bytes").value<size_t>(), 0U);
+    };
+
+    run(ExecMode::Standard);
+    run(ExecMode::Stream);
+}
+
+TEST(PipelineManagerTest, usedDimensions)
+{
+    using namespace Dimension;
+
+    auto layout = [](const std::string& writer)
+    {
+        PipelineManager mgr;
+
+        Options ro;
+        ro.add("filename", Support::datapath("las/1.2-with-color.las"));
+        Stage& r = mgr.makeReader("", "readers.las", ro);
+
+        Options rangeOpts;
+        rangeOpts.add("limits", "Classification[1:1]");
+        Stage& f = mgr.makeFilter("filters.range", r, rangeOpts);
+        if (writer.size())
+            mgr.makeWriter(Support::temppath("used.las"), writer, f);
+
+        mgr.execute();
+        FileUtils::deleteFile(Support::temppath("used.las"));
+        return mgr.pointTable().layout()->dims();
+    };
+
+    // Every stage reports the dimensions it uses, so the reader only
+    // provides X, Y, Z and Classification.
+    IdList dims = layout("writers.null");
+    EXPECT_EQ(dims.size(), 4U);
+    EXPECT_TRUE(Utils::contains(dims, Id::Classification));
+    EXPECT_FALSE(Utils::contains(dims, Id::Intensity));
+    EXPECT_FALSE(Utils::contains(dims, Id::Red));
+
+    // writers.las doesn't limit the dimensions it uses.
+    dims = layout("writers.las");
+    EXPECT_TRUE(Utils::contains(dims, Id::Intensity));
+    EXPECT_TRUE(Utils::contains(dims, Id::Red));
+
+    // Without a writer, the resulting views have every dimension.
+    dims = layout("");
+    EXPECT_TRUE(Utils::contains(dims, Id::Intensity));
+    EXPECT_TRUE(Utils::contains(dims, Id::Red));
+}
@@ -32,6 +32,8 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <cstring>
+
 #include <pdal/pdal_test_main.hpp>
 
 #include <pdal/PointTable.hpp>
@@ -255,6 +257,126 @@ TEST(PointTable, simple)
 
     ContiguousPointTable t2;
     simpleTest(t2);
+
+    ColumnPointTable t3;
+    simpleTest(t3);
+
+#ifndef _WIN32
+    MappedPointTable t4;
+    simpleTest(t4);
+#endif
+}
+
+
+#ifndef _WIN32
+// Fill several blocks with a budget of one block so that blocks are
+// released to the file, and make sure every point reads back.
+TEST(PointTable, mapped)
+{
+    using namespace Dimension;
+
+    MappedPointTable t(1);
+    t.layout()->registerDims({Id::X, Id::Y, Id::Intensity});
+    t.finalize();
+
+    const point_count_t count = 5 * 65536 + 100;
+    PointView v(t);
+    for (PointId i = 0; i < count; ++i)
+    {
+        v.setField(Id::X, i, i * .5);
+        v.setField(Id::Y, i, (double)(count - i));
+        v.setField(Id::Intensity, i, (uint16_t)i);
+    }
+
+    const size_t blockBytes = 65536 * t.layout()->pointSize();
+    EXPECT_EQ(t.memoryUsage(), blockBytes);
+
+    for (PointId i = 0; i < count; ++i)
+    {
+        ASSERT_DOUBLE_EQ(v.getFieldAs<double>(Id::X, i), i * .5);
+        ASSERT_DOUBLE_EQ(v.getFieldAs<double>(Id::Y, i), (double)(count - i));
+        ASSERT_EQ(v.getFieldAs<uint16_t>(Id::Intensity, i), (uint16_t)i);
+    }
+}
+#endif
+
+
+TEST(PointTable, blockAllocator)
+{
+    BlockAllocator pool(false, 10000);
+
+    char *b = pool.allocate(4000);
+    std::fill(b, b + 4000, 'x');
+    pool.release(b, 4000);
+    EXPECT_EQ(pool.pooledBytes(), 4000u);
+
+    // Released blocks are reused and come back zeroed.
+    char *c = pool.allocate(4000);
+    EXPECT_EQ(b, c);
+    EXPECT_EQ(std::count(c, c + 4000, 0), 4000);
+    EXPECT_EQ(pool.pooledBytes(), 0u);
+
+    // Blocks beyond the pool limit are freed.
+    char *d = pool.allocate(8000);
+    pool.release(c, 4000);
+    pool.release(d, 8000);
+    EXPECT_EQ(pool.pooledBytes(), 4000u);
+    pool.setPoolLimit(0);
+    EXPECT_EQ(pool.pooledBytes(), 0u);
+
+    BlockAllocator huge(true);
+    char *h = huge.allocate(3 * 1024 * 1024);
+#ifdef __linux__
+    EXPECT_EQ(reinterpret_cast<std::size_t>(h) % (2 * 1024 * 1024), 0u);
+#endif
+    h[3 * 1024 * 1024 - 1] = 1;
+    huge.release(h, 3 * 1024 * 1024);
+
+    PointTable t(1000, pool);
+    simpleTest(t);
+
+    PointTable t2(1000, huge);
+    simpleTest(t2);
+}
+
+
+TEST(PointTable, columns)
+{
+    ColumnPointTable table;
+    PointLayoutPtr layout = table.layout();
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Intensity);
+    table.finalize();
+
+    PointView v(table);
+    for (PointId id = 0; id < 1000; id++)
+    {
+        v.setField(Dimension::Id::X, id, id * 2.5);
+        v.setField(Dimension::Id::Intensity, id, id);
+    }
+
+    const double *x = table.column<double>(Dimension::Id::X);
+    const uint16_t *inten = table.column<uint16_t>(Dimension::Id::Intensity);
+    for (PointId id = 0; id < 1000; id++)
+    {
+        EXPECT_DOUBLE_EQ(id * 2.5, x[id]);
+        EXPECT_EQ(id, inten[id]);
+    }
+
+    // Wrong type.
+    EXPECT_THROW(table.column<float>(Dimension::Id::X), pdal_error);
+    // Dimension not in the table.
+    EXPECT_THROW(table.columnData(Dimension::Id::Y), pdal_error);
+    // Packed point data is gathered from the columns.
+    const char *p = v.getPoint(10);
+    double xval;
+    uint16_t ival;
+    std::memcpy(&xval, p + layout->dimOffset(Dimension::Id::X), sizeof(xval));
+    std::memcpy(&ival, p + layout->dimOffset(Dimension::Id::Intensity),
+        sizeof(ival));
+    EXPECT_DOUBLE_EQ(25.0, xval);
+    EXPECT_EQ(10, ival);
 }
 
 } // namespace
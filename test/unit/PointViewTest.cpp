@@ -161,6 +161,164 @@ TEST(PointViewTest, getFloat)
 }
 
 
+TEST(PointViewTest, fieldArray)
+{
+    PointTable table;
+    PointViewPtr view = makeTestView(table);
+
+    std::vector<double> d(10);
+    view->getFieldArray(Dimension::Id::Y, 5, 10, d.data());
+    for (PointId i = 0; i < 10; i++)
+        EXPECT_DOUBLE_EQ(d[i], (i + 5) * 100.0);
+
+    std::vector<int32_t> x(17);
+    view->getFieldArray(Dimension::Id::X, 0, 17, x.data());
+    std::vector<uint16_t> c(17);
+    view->getFieldArray(Dimension::Id::Classification, 0, 17, c.data());
+    for (PointId i = 0; i < 17; i++)
+    {
+        EXPECT_EQ(x[i], (int32_t)(i * 10));
+        EXPECT_EQ(c[i], i + 1);
+    }
+
+    std::vector<uint8_t> u8(17);
+    EXPECT_THROW(view->getFieldArray(Dimension::Id::Y, 0, 17, u8.data()),
+        pdal_error);
+
+    // Set existing points and append new ones.
+    std::vector<int> vals { 7, 8, 9, 10 };
+    view->setFieldArray(Dimension::Id::Classification, 15, 4, vals.data());
+    EXPECT_EQ(view->size(), 19u);
+    for (PointId i = 15; i < 19; i++)
+    {
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Classification, i),
+            (int)i - 8);
+    }
+
+    std::vector<int> bad { 1000 };
+    EXPECT_THROW(
+        view->setFieldArray(Dimension::Id::Classification, 0, 1, bad.data()),
+        pdal_error);
+}
+
+
+
+// Ranges are copied by the table a block at a time, so they must cross
+// block boundaries and work for views whose points aren't contiguous.
+TEST(PointViewTest, fieldArrayBlocks)
+{
+    using namespace Dimension;
+
+    auto check = [](BasePointTable& table)
+    {
+        table.layout()->registerDims({Id::X, Id::Intensity});
+        table.finalize();
+
+        PointView contig(table);
+        std::vector<double> x(100);
+        for (PointId i = 0; i < 100; ++i)
+            x[i] = i * 1.5;
+        contig.setFieldArray(Id::X, 0, 100, x.data());
+        EXPECT_EQ(contig.size(), 100u);
+
+        std::vector<uint16_t> in(100);
+        for (PointId i = 0; i < 100; ++i)
+            in[i] = (uint16_t)(i * 3);
+        contig.setFieldArray(Id::Intensity, 0, 100, in.data());
+
+        std::vector<double> xout(90);
+        contig.getFieldArray(Id::X, 5, 90, xout.data());
+        std::vector<int> iout(90);
+        contig.getFieldArray(Id::Intensity, 5, 90, iout.data());
+        for (PointId i = 0; i < 90; ++i)
+        {
+            EXPECT_DOUBLE_EQ(xout[i], (i + 5) * 1.5);
+            EXPECT_EQ(iout[i], (int)(i + 5) * 3);
+        }
+
+        // Every other point of the table.
+        PointView sparse(table);
+        for (PointId i = 0; i < 100; i += 2)
+            sparse.appendPoint(contig, i);
+        std::vector<float> fout(50);
+        sparse.getFieldArray(Id::X, 0, 50, fout.data());
+        for (PointId i = 0; i < 50; ++i)
+            EXPECT_FLOAT_EQ(fout[i], i * 3.0f);
+        sparse.setFieldArray(Id::Intensity, 0, 50, in.data());
+        for (PointId i = 0; i < 100; i += 2)
+            EXPECT_EQ(contig.getFieldAs<int>(Id::Intensity, i), (int)i * 3 / 2);
+    };
+
+    PointTable table(7, BlockAllocator::heap());
+    check(table);
+
+    ColumnPointTable columns;
+    check(columns);
+}
+
+TEST(PointViewTest, index)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+
+    // Views whose points are interleaved in the table.
+    PointView v1(table);
+    PointView v2(table);
+    for (PointId i = 0; i < 10; ++i)
+    {
+        v1.setField(Id::X, i, i * 2);
+        v2.setField(Id::X, i, i * 2 + 1);
+    }
+    for (PointId i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(v1.getFieldAs<PointId>(Id::X, i), i * 2);
+        EXPECT_EQ(v2.getFieldAs<PointId>(Id::X, i), i * 2 + 1);
+    }
+
+    PointView v3(table);
+    v3.append(v1);
+    v3.append(v2);
+    ASSERT_EQ(v3.size(), 20u);
+    for (PointId i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(v3.getFieldAs<PointId>(Id::X, i), i * 2);
+        EXPECT_EQ(v3.getFieldAs<PointId>(Id::X, i + 10), i * 2 + 1);
+    }
+
+    // Appending adjacent views.
+    PointTable table2;
+    table2.layout()->registerDim(Id::X);
+    PointView a(table2);
+    PointView b(table2);
+    for (PointId i = 0; i < 10; ++i)
+        a.setField(Id::X, i, i);
+    for (PointId i = 0; i < 10; ++i)
+        b.setField(Id::X, i, i + 10);
+    a.append(b);
+    a.appendPoint(b, 0);
+    ASSERT_EQ(a.size(), 21u);
+    for (PointId i = 0; i < 20; ++i)
+        EXPECT_EQ(a.getFieldAs<PointId>(Id::X, i), i);
+    EXPECT_EQ(a.getFieldAs<PointId>(Id::X, 20), 10u);
+
+    // Sorting reorders the points of the view, not the table.
+    auto cmp = [](const PointRef& p1, const PointRef& p2)
+        { return p1.compare(Id::X, p2); };
+    PointView c(table2);
+    c.append(b);
+    std::reverse(c.begin(), c.end());
+    std::stable_sort(c.begin(), c.end(), cmp);
+    std::reverse(b.begin(), b.end());
+    for (PointId i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(c.getFieldAs<PointId>(Id::X, i), i + 10);
+        EXPECT_EQ(b.getFieldAs<PointId>(Id::X, i), 19 - i);
+    }
+}
+
+
 TEST(PointViewTest, bigfile)
 {
     PointTable table;
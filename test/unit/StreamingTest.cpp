@@ -31,6 +31,8 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <sstream>
+
 #include <pdal/pdal_test_main.hpp>
 
 #include <pdal/Filter.hpp>
@@ -38,7 +40,9 @@
 #include <io/FauxReader.hpp>
 #include <pdal/StageFactory.hpp>
 #include <filters/MergeFilter.hpp>
+#include <filters/RangeFilter.hpp>
 #include <filters/StreamCallbackFilter.hpp>
+#include <filters/TransformationFilter.hpp>
 #include "Support.hpp"
 
 using namespace pdal;
@@ -528,3 +532,164 @@ R"(
         EXPECT_NE(output.find("DBDCA"), std::string::npos);
     }
 }
+
+// Make sure that running stages on separate threads processes every point,
+// in order, and honors filtered points.
+TEST(Streaming, threads)
+{
+    Options ro;
+    ro.add("bounds", BOX3D(0, 0, 0, 9999, 9999, 9999));
+    ro.add("mode", "ramp");
+    ro.add("count", 10000);
+    FauxReader r;
+    r.setOptions(ro);
+
+    Options to;
+    to.add("matrix", "1 0 0 1  0 1 0 0  0 0 1 0  0 0 0 1");
+    TransformationFilter t;
+    t.setOptions(to);
+    t.setInput(r);
+
+    Options fo;
+    fo.add("limits", "Y[0:4999]");
+    RangeFilter range;
+    range.setOptions(fo);
+    range.setInput(t);
+
+    StreamCallbackFilter f;
+    int cnt = 0;
+    auto cb = [&cnt](PointRef& point)
+    {
+        EXPECT_EQ(point.getFieldAs<int>(Dimension::Id::X), cnt + 1);
+        EXPECT_EQ(point.getFieldAs<int>(Dimension::Id::Y), cnt);
+        cnt++;
+        return true;
+    };
+    f.setCallback(cb);
+    f.setInput(range);
+
+    FixedPointTable table(100);
+    f.prepare(table);
+    f.setThreads(3);
+    f.execute(table);
+    EXPECT_EQ(cnt, 5000);
+}
+
+// Reading ahead on a separate thread should pass every point, in order,
+// with or without additional threads for the other stages.
+TEST(Streaming, readAhead)
+{
+    for (size_t threads : { 1, 3 })
+    {
+        Options ro;
+        ro.add("bounds", BOX3D(0, 0, 0, 9999, 9999, 9999));
+        ro.add("mode", "ramp");
+        ro.add("count", 10000);
+        FauxReader r;
+        r.setOptions(ro);
+
+        Options fo;
+        fo.add("limits", "Y[0:4999]");
+        RangeFilter range;
+        range.setOptions(fo);
+        range.setInput(r);
+
+        StreamCallbackFilter f;
+        int cnt = 0;
+        auto cb = [&cnt](PointRef& point)
+        {
+            EXPECT_EQ(point.getFieldAs<int>(Dimension::Id::X), cnt);
+            cnt++;
+            return true;
+        };
+        f.setCallback(cb);
+        f.setInput(range);
+
+        FixedPointTable table(100);
+        f.prepare(table);
+        f.setThreads(threads);
+        f.setReadAhead(4);
+        f.execute(table);
+        EXPECT_EQ(cnt, 5000);
+    }
+}
+
+// In parallel stream mode, points reach the provided table's reset() in
+// order, and stages log with their own leaders.
+TEST(Streaming, parallelTable)
+{
+    class CountTable : public FixedPointTable
+    {
+    public:
+        CountTable() : FixedPointTable(100), m_count(0), m_ordered(true)
+        {}
+
+        point_count_t m_count;
+        bool m_ordered;
+
+    protected:
+        virtual void reset()
+        {
+            for (PointId idx = 0; idx < numPoints(); ++idx)
+            {
+                if (skip(idx))
+                    continue;
+                PointRef point(*this, idx);
+                if (point.getFieldAs<point_count_t>(Dimension::Id::X) !=
+                        m_count)
+                    m_ordered = false;
+                m_count++;
+            }
+            FixedPointTable::reset();
+        }
+    };
+
+    class LogFilter : public Filter, public Streamable
+    {
+    public:
+        LogFilter() : m_logged(false)
+        {}
+
+        std::string getName() const
+            { return "filters.logtest"; }
+
+    private:
+        virtual bool processOne(PointRef&)
+        {
+            if (!m_logged)
+                log()->get(LogLevel::Error) << "processing" << std::endl;
+            m_logged = true;
+            return true;
+        }
+
+        bool m_logged;
+    };
+
+    Options ro;
+    ro.add("bounds", BOX3D(0, 0, 0, 9999, 9999, 9999));
+    ro.add("mode", "ramp");
+    ro.add("count", 10000);
+    FauxReader r;
+    r.setOptions(ro);
+
+    Options fo;
+    fo.add("limits", "Y[0:4999]");
+    RangeFilter range;
+    range.setOptions(fo);
+    range.setInput(r);
+
+    std::ostringstream out;
+    LogPtr log(Log::makeLog("", &out));
+    LogFilter f;
+    f.setLog(log);
+    f.setInput(range);
+
+    CountTable table;
+    f.prepare(table);
+    f.setThreads(3);
+    f.execute(table);
+    EXPECT_EQ(table.m_count, 5000u);
+    EXPECT_TRUE(table.m_ordered);
+    EXPECT_NE(out.str().find("(filters.logtest Error) processing"),
+        std::string::npos);
+}
@@ -0,0 +1,117 @@
+/******************************************************************************
+* Copyright (c) 2026, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <limits>
+#include <random>
+
+#include <io/BufferReader.hpp>
+#include <filters/FarthestPointSamplingFilter.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Samples by comparing every point to every sample.
+PointIdList bruteForce(PointView& view, point_count_t count)
+{
+    PointIdList ids { 0 };
+    std::vector<double> minDists(view.size(),
+        (std::numeric_limits<double>::max)());
+    PointId idx = 0;
+    while (true)
+    {
+        double x = view.getFieldAs<double>(Dimension::Id::X, idx);
+        double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
+        double z = view.getFieldAs<double>(Dimension::Id::Z, idx);
+        for (PointId i = 0; i < view.size(); ++i)
+        {
+            double dx = view.getFieldAs<double>(Dimension::Id::X, i) - x;
+            double dy = view.getFieldAs<double>(Dimension::Id::Y, i) - y;
+            double dz = view.getFieldAs<double>(Dimension::Id::Z, i) - z;
+            minDists[i] = (std::min)(minDists[i], dx * dx + dy * dy + dz * dz);
+        }
+        if (ids.size() == count)
+            break;
+        idx = std::max_element(minDists.begin(), minDists.end()) -
+            minDists.begin();
+        ids.push_back(idx);
+    }
+    return ids;
+}
+
+} // unnamed namespace
+
+// Points are split among several subtrees and many lie at the same
+// distance, so samples must not depend on how the points are stored.
+TEST(FarthestPointSamplingFilterTest, matchesBruteForce)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDims({Id::X, Id::Y, Id::Z, Id::OriginId});
+
+    BufferReader reader;
+    FarthestPointSamplingFilter filter;
+    Options opts;
+    opts.add("count", 300);
+    filter.setInput(reader);
+    filter.setOptions(opts);
+    filter.prepare(table);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> grid(0, 50);
+    std::uniform_real_distribution<double> dist(0, 100);
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < 100000; ++i)
+    {
+        view->setField(Id::X, i, grid(gen));
+        view->setField(Id::Y, i, dist(gen));
+        view->setField(Id::Z, i, dist(gen) / 100);
+        view->setField(Id::OriginId, i, i);
+    }
+    reader.addView(view);
+
+    PointViewSet viewSet = filter.execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr outView = *viewSet.begin();
+
+    PointIdList expected = bruteForce(*view, 300);
+    ASSERT_EQ(outView->size(), expected.size());
+    for (PointId i = 0; i < outView->size(); ++i)
+        EXPECT_EQ(outView->getFieldAs<PointId>(Id::OriginId, i),
+            expected[i]);
+}
@@ -0,0 +1,134 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <random>
+
+#include <pdal/EigenUtils.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+
+#include <filters/private/Neighborhoods.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr makeView(PointTableRef table, point_count_t count)
+{
+    PointLayoutPtr layout = table.layout();
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+    table.finalize();
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(0, 100);
+    PointViewPtr view(new PointView(table));
+    for (PointId id = 0; id < count; ++id)
+    {
+        view->setField(Dimension::Id::X, id, dist(gen));
+        view->setField(Dimension::Id::Y, id, dist(gen));
+        view->setField(Dimension::Id::Z, id, dist(gen) / 10);
+    }
+    return view;
+}
+
+} // unnamed namespace
+
+// Neighborhoods span several blocks, so results of each block must land on
+// the right points.
+TEST(NeighborhoodsTest, knn)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::NormalX);
+    table.layout()->registerDim(Dimension::Id::Curvature);
+    PointViewPtr view = makeView(table, 150000);
+
+    Neighborhoods hoods(*view);
+    hoods.setKnn(8, 2);
+    hoods.run({ Dimension::Id::NormalX, Dimension::Id::Curvature },
+        [&hoods](const Neighborhood& n, double *values)
+        {
+            Eigen::Matrix3d cov = hoods.covariance(n);
+            values[0] = cov(0, 1);
+            values[1] = n.id;
+        });
+
+    const KD3Index& kdi = hoods.index();
+    for (PointId id = 0; id < view->size(); id += 101)
+    {
+        Eigen::Matrix3d cov = computeCovariance(*view, kdi.neighbors(id, 8, 2));
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::NormalX, id),
+            cov(0, 1));
+        EXPECT_EQ(view->getFieldAs<PointId>(Dimension::Id::Curvature, id),
+            id);
+    }
+}
+
+TEST(NeighborhoodsTest, radius)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::Intensity);
+    PointViewPtr view = makeView(table, 20000);
+
+    Neighborhoods hoods(*view);
+    hoods.setRadius(3);
+    hoods.run({ Dimension::Id::Intensity },
+        [](const Neighborhood& n, double *values)
+        { values[0] = n.count; });
+
+    const KD3Index& kdi = hoods.index();
+    for (PointId id = 0; id < view->size(); id += 13)
+        EXPECT_EQ(view->getFieldAs<size_t>(Dimension::Id::Intensity, id),
+            kdi.radius(id, 3).size());
+}
+
+TEST(NeighborhoodsTest, errors)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::Intensity);
+    PointViewPtr view = makeView(table, 1000);
+
+    Neighborhoods hoods(*view);
+    EXPECT_THROW(hoods.run({ Dimension::Id::Intensity },
+        [](const Neighborhood& n, double *)
+        {
+            if (n.id == 500)
+                throw pdal_error("Bad neighborhood.");
+        }), pdal_error);
+}
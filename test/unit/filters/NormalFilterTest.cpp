@@ -34,10 +34,13 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <random>
+
 #include <filters/NormalFilter.hpp>
 #include <io/BufferReader.hpp>
 #include <io/FauxReader.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
 
 #include "Support.hpp"
 
@@ -251,4 +254,60 @@ TEST(NormalFilterTest, RampPlane2)
     }
 }
 
+// Views run concurrently must each refine their own minimum spanning tree
+// and produce the same normals as views run one at a time.
+TEST(NormalFilterTest, threads)
+{
+    using namespace Dimension;
+
+    auto run = [](size_t threads)
+    {
+        PointTable table;
+        table.layout()->registerDims({Id::X, Id::Y, Id::Z});
+
+        BufferReader reader;
+        StageFactory factory;
+        Stage *splitter = factory.createStage("filters.splitter");
+        Options splitterOps;
+        splitterOps.add("length", 25);
+        splitter->setOptions(splitterOps);
+        splitter->setInput(reader);
+
+        NormalFilter filter;
+        filter.setInput(*splitter);
+        filter.setThreads(threads);
+        filter.prepare(table);
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> dist(0, 100);
+        PointViewPtr view(new PointView(table));
+        for (PointId i = 0; i < 4000; ++i)
+        {
+            view->setField(Id::X, i, dist(gen));
+            view->setField(Id::Y, i, dist(gen));
+            view->setField(Id::Z, i, dist(gen) / 10);
+        }
+        reader.addView(view);
+
+        const Dimension::Id dims[] = { Id::NormalX, Id::NormalY, Id::NormalZ,
+            Id::Curvature };
+        std::vector<std::vector<double>> out;
+        for (PointViewPtr v : filter.execute(table))
+        {
+            std::vector<double> values;
+            for (PointId i = 0; i < v->size(); ++i)
+                for (Dimension::Id d : dims)
+                    values.push_back(v->getFieldAs<double>(d, i));
+            out.push_back(values);
+        }
+        return out;
+    };
+
+    std::vector<std::vector<double>> serial = run(1);
+    std::vector<std::vector<double>> parallel = run(4);
+
+    EXPECT_EQ(serial.size(), 16U);
+    EXPECT_EQ(serial, parallel);
+}
+
 } // namespace pdal
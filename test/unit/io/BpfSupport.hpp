@@ -74,7 +74,7 @@ template<typename LeftIter, typename RightIter>
 
 
 
-void test_file_type_view(const std::string& filename)
+void test_file_type_view(const std::string& filename, bool mmap = false)
 {
     PointTable table;
 
@@ -89,6 +89,7 @@ void test_file_type_view(const std::string& filename)
 
     ops.add("filename", filename);
     ops.add("count", 506);
+    ops.add("use_mmap", mmap);
     std::shared_ptr<BpfReader> reader(new BpfReader);
     reader->setOptions(ops);
 
@@ -130,7 +131,7 @@ void test_file_type_view(const std::string& filename)
     }
 }
 
-void test_file_type_stream(const std::string& filename)
+void test_file_type_stream(const std::string& filename, bool mmap = false)
 {
     class Checker : public Filter, public Streamable
     {
@@ -194,6 +195,7 @@ void test_file_type_stream(const std::string& filename)
 
     ops.add("filename", filename);
     ops.add("count", 506);
+    ops.add("use_mmap", mmap);
     BpfReader reader;
     reader.setOptions(ops);
 
@@ -205,10 +207,10 @@ void test_file_type_stream(const std::string& filename)
 }
 
 
-void test_file_type(const std::string& filename)
+void test_file_type(const std::string& filename, bool mmap = false)
 {
-    test_file_type_view(filename);
-    test_file_type_stream(filename);
+    test_file_type_view(filename, mmap);
+    test_file_type_stream(filename, mmap);
 }
 
 
@@ -57,6 +57,18 @@ TEST(BpfTestBase, test_byte_major)
         Support::datapath("bpf/autzen-utm-chipped-25-v3-segregated.bpf"));
 }
 
+TEST(BpfTestBase, mmap)
+{
+    test_file_type(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"),
+        true);
+    test_file_type(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3.bpf"), true);
+    test_file_type(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-segregated.bpf"),
+        true);
+}
+
 TEST(BpfTestBase, roundtrip_byte)
 {
     Options ops;
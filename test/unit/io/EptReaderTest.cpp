@@ -33,6 +33,7 @@
  ****************************************************************************/
 
 #include <algorithm>
+#include <fstream>
 
 #include <nlohmann/json.hpp>
 
@@ -41,6 +42,7 @@
 #include <io/EptReader.hpp>
 #include <io/LasReader.hpp>
 #include <filters/CropFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
 #include <filters/ReprojectionFilter.hpp>
 #include <pdal/SrsBounds.hpp>
 #include <pdal/util/FileUtils.hpp>
@@ -629,6 +631,59 @@ TEST(EptReaderTest, zstandardStream)
 #endif
 }
 
+// A lookahead too small for even one node should still read every node,
+// and ordered streaming should deliver nodes in hierarchy order.
+TEST(EptReaderTest, streamLookahead)
+{
+    auto count = [](bool ordered)
+    {
+        Options ops;
+        ops.add("filename", ellipsoidEptBinaryPath);
+        ops.add("lookahead", 0);
+        ops.add("ordered", ordered);
+        ops.add("threads", 4);
+
+        EptReader reader;
+        reader.setOptions(ops);
+
+        FixedPointTable table(100);
+        const Dimension::Id nodeIdDim = table.layout()->registerOrAssignDim(
+            "EptNodeId", Dimension::Type::Unsigned32);
+
+        point_count_t count = 0;
+        uint32_t lastNodeId = 0;
+        bool inOrder = true;
+        StreamCallbackFilter f;
+        f.setInput(reader);
+        f.setCallback([&](PointRef& point)
+        {
+            const uint32_t nodeId =
+                point.getFieldAs<uint32_t>(nodeIdDim);
+            if (nodeId < lastNodeId)
+                inOrder = false;
+            lastNodeId = nodeId;
+            count++;
+            return true;
+        });
+        f.prepare(table);
+        f.execute(table);
+        if (ordered)
+            EXPECT_TRUE(inOrder);
+        return count;
+    };
+
+    Options ops;
+    ops.add("filename", ellipsoidEptBinaryPath);
+    PointTable table;
+    EptReader reader;
+    reader.setOptions(ops);
+    reader.prepare(table);
+    const point_count_t expected = reader.execute(table).begin()->get()->size();
+
+    EXPECT_EQ(count(true), expected);
+    EXPECT_EQ(count(false), expected);
+}
+
 TEST(EptReaderTest, boundedCrop)
 {
     std::string wkt = FileUtils::readFileIntoString(
@@ -796,6 +851,70 @@ TEST(EptReaderTest, ogrCrop)
     EXPECT_EQ(sourceNp, 86u);
 }
 
+namespace
+{
 
+void copyDirectory(const std::string& src, const std::string& dst)
+{
+    FileUtils::createDirectories(dst);
+    for (const std::string& path : FileUtils::directoryList(src))
+    {
+        const std::string target(dst + "/" + FileUtils::getFilename(path));
+        if (FileUtils::isDirectory(path))
+            copyDirectory(path, target);
+        else
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::ofstream out(target, std::ios::binary);
+            out << in.rdbuf();
+        }
+    }
+}
+
+point_count_t cachedRead(const std::string& path, const std::string& cacheDir,
+    uint64_t cacheSize)
+{
+    Options options;
+    options.add("filename", "ept://" + path);
+    options.add("cache_dir", cacheDir);
+    options.add("cache_size", cacheSize);
+
+    PointTable table;
+    EptReader reader;
+    reader.setOptions(options);
+    reader.prepare(table);
+    point_count_t np(0);
+    for (const PointViewPtr& view : reader.execute(table))
+        np += view->size();
+    return np;
+}
+
+} // unnamed namespace
+
+// Nodes fetched once are read from the cache even if the source goes away.
+TEST(EptReaderTest, cache)
+{
+    const std::string src(Support::temppath("ept_cache_src"));
+    const std::string cacheDir(Support::temppath("ept_cache"));
+    FileUtils::deleteDirectory(src);
+    FileUtils::deleteDirectory(cacheDir);
+    copyDirectory(Support::datapath("ept/lone-star-laszip"), src);
+
+    EXPECT_EQ(cachedRead(src, cacheDir, 1024), expNumPoints);
+    EXPECT_GT(FileUtils::directoryList(cacheDir).size(), 0u);
+
+    FileUtils::deleteDirectory(src + "/ept-data");
+    EXPECT_EQ(cachedRead(src, cacheDir, 1024), expNumPoints);
+
+    // Files in use aren't removed, even from a cache with no room.
+    const std::string smallDir(Support::temppath("ept_cache_small"));
+    FileUtils::deleteDirectory(smallDir);
+    EXPECT_EQ(cachedRead(Support::datapath("ept/lone-star-laszip"), smallDir,
+        0), expNumPoints);
+
+    FileUtils::deleteDirectory(src);
+    FileUtils::deleteDirectory(cacheDir);
+    FileUtils::deleteDirectory(smallDir);
+}
 
 } // namespace pdal
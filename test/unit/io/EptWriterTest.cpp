@@ -0,0 +1,183 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+
+#include <pdal/util/FileUtils.hpp>
+#include <io/EptReader.hpp>
+#include <io/EptWriter.hpp>
+#include <io/LasReader.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+const point_count_t NumPoints = 110000;
+
+std::string writeEpt(const std::string& name, Options opts, bool stream)
+{
+    const std::string dir(Support::temppath(name));
+    FileUtils::deleteDirectory(dir);
+    opts.add("filename", dir);
+
+    LasReader reader;
+    Options readerOpts;
+    readerOpts.add("filename", Support::datapath("las/autzen_trim.las"));
+    reader.setOptions(readerOpts);
+
+    EptWriter writer;
+    writer.setOptions(opts);
+    writer.setInput(reader);
+
+    if (stream)
+    {
+        FixedPointTable table(1000);
+        writer.prepare(table);
+        writer.execute(table);
+    }
+    else
+    {
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+    return dir;
+}
+
+PointViewPtr readEpt(PointTable& table, const std::string& dir,
+    double resolution = 0)
+{
+    EptReader reader;
+    Options opts;
+    opts.add("filename", "ept://" + dir);
+    if (resolution)
+        opts.add("resolution", resolution);
+    reader.setOptions(opts);
+    reader.prepare(table);
+    return *reader.execute(table).begin();
+}
+
+// Check that the EPT dataset holds the same points as the source file.
+void compare(const std::string& dir)
+{
+    using D = Dimension::Id;
+
+    PointTable lasTable;
+    LasReader lasReader;
+    Options lasOpts;
+    lasOpts.add("filename", Support::datapath("las/autzen_trim.las"));
+    lasReader.setOptions(lasOpts);
+    lasReader.prepare(lasTable);
+    PointViewPtr las = *lasReader.execute(lasTable).begin();
+
+    PointTable eptTable;
+    PointViewPtr ept = readEpt(eptTable, dir);
+    ASSERT_EQ(ept->size(), NumPoints);
+    ASSERT_EQ(las->size(), NumPoints);
+
+    const std::vector<D> dims { D::X, D::Y, D::Z, D::Intensity,
+        D::Classification, D::GpsTime, D::Red };
+    auto sorted = [&dims](const PointView& v)
+    {
+        std::vector<std::vector<double>> points;
+        for (PointId i = 0; i < v.size(); ++i)
+        {
+            std::vector<double> p;
+            for (D d : dims)
+                p.push_back(v.getFieldAs<double>(d, i));
+            points.push_back(p);
+        }
+        std::sort(points.begin(), points.end());
+        return points;
+    };
+    const auto lasPoints = sorted(*las);
+    const auto eptPoints = sorted(*ept);
+    for (size_t i = 0; i < lasPoints.size(); ++i)
+        for (size_t j = 0; j < dims.size(); ++j)
+            ASSERT_NEAR(lasPoints[i][j], eptPoints[i][j], .0001);
+
+    // A coarse resolution reads only the shallow nodes.
+    PointTable coarseTable;
+    PointViewPtr coarse = readEpt(coarseTable, dir, 20);
+    EXPECT_GT(coarse->size(), 0u);
+    EXPECT_LT(coarse->size(), NumPoints);
+}
+
+} // unnamed namespace
+
+TEST(EptWriterTest, binary)
+{
+    Options opts;
+    opts.add("data_type", "binary");
+    compare(writeEpt("ept_writer_binary", opts, false));
+}
+
+// Spooling points to disk and splitting the hierarchy don't change the
+// points.
+TEST(EptWriterTest, streamSpooled)
+{
+    Options opts;
+    opts.add("memory_points", 10000);
+    opts.add("hierarchy_step", 2);
+    const std::string dir(writeEpt("ept_writer_spooled", opts, true));
+    compare(dir);
+    EXPECT_GT(FileUtils::directoryList(dir + "/ept-hierarchy").size(), 1u);
+}
+
+TEST(EptWriterTest, laszip)
+{
+    Options opts;
+    opts.add("data_type", "laszip");
+    compare(writeEpt("ept_writer_laszip", opts, false));
+}
+
+#ifdef PDAL_HAVE_ZSTD
+TEST(EptWriterTest, zstandard)
+{
+    Options opts;
+    opts.add("data_type", "zstandard");
+    compare(writeEpt("ept_writer_zstandard", opts, false));
+}
+#endif
+
+TEST(EptWriterTest, badDataType)
+{
+    Options opts;
+    opts.add("data_type", "text");
+    EXPECT_THROW(writeEpt("ept_writer_bad", opts, false), pdal_error);
+}
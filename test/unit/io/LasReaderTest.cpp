@@ -39,7 +39,9 @@
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/Streamable.hpp>
+#include <io/LasIndex.hpp>
 #include <io/LasReader.hpp>
+#include <filters/StreamCallbackFilter.hpp>
 #include "Support.hpp"
 
 using namespace pdal;
@@ -474,6 +476,403 @@ TEST(LasReaderTest, stream)
 #endif
 }
 
+#ifdef PDAL_HAVE_LAZPERF
+// Decode the chunks of autzen_trim.laz on the shared executor, both in
+// standard and stream mode, and check the points against the LAS file.
+TEST(LasReaderTest, chunks)
+{
+    Options ops1;
+    ops1.add("filename", Support::datapath("las/autzen_trim.las"));
+
+    LasReader lasReader;
+    lasReader.setOptions(ops1);
+
+    PointTable t1;
+    lasReader.prepare(t1);
+    PointViewSet s = lasReader.execute(t1);
+    PointViewPtr lasView = *s.begin();
+
+    DimTypeList dims = lasView->dimTypes();
+    size_t pointSize = lasView->pointSize();
+    std::vector<char> buf1(pointSize);
+    std::vector<char> buf2(pointSize);
+
+    // Read a count that ends in the middle of a chunk.
+    for (point_count_t count : { (point_count_t)110000, (point_count_t)75000 })
+    {
+        Options ops2;
+        ops2.add("filename", Support::datapath("laz/autzen_trim.laz"));
+        ops2.add("compression", "lazperf");
+        ops2.add("count", count);
+
+        LasReader lazReader;
+        lazReader.setOptions(ops2);
+
+        PointTable t2;
+        lazReader.prepare(t2);
+        s = lazReader.execute(t2);
+        PointViewPtr lazView = *s.begin();
+        EXPECT_EQ(lazView->size(), count);
+
+        for (PointId i = 0; i < lazView->size(); i += 100)
+        {
+            lasView->getPackedPoint(dims, i, buf1.data());
+            lazView->getPackedPoint(dims, i, buf2.data());
+            EXPECT_EQ(memcmp(buf1.data(), buf2.data(), pointSize), 0);
+        }
+    }
+
+    Options ops3;
+    ops3.add("filename", Support::datapath("laz/autzen_trim.laz"));
+    ops3.add("compression", "lazperf");
+
+    LasReader streamReader;
+    streamReader.setOptions(ops3);
+
+    PointId idx = 0;
+    StreamCallbackFilter f;
+    f.setInput(streamReader);
+    f.setCallback([&](PointRef& point)
+    {
+        lasView->getPackedPoint(dims, idx++, buf1.data());
+        point.getPackedData(dims, buf2.data());
+        EXPECT_EQ(memcmp(buf1.data(), buf2.data(), pointSize), 0);
+        return true;
+    });
+
+    FixedPointTable fixed(100);
+    f.prepare(fixed);
+    f.execute(fixed);
+    EXPECT_EQ(idx, 110000u);
+}
+#endif
+
+
+// Points decoded from a memory-mapped file, in standard or stream mode,
+// should match those read from the stream.
+TEST(LasReaderTest, mmap)
+{
+    auto read = [](const std::string& file, bool mmap)
+    {
+        Options ops;
+        ops.add("filename", file);
+        ops.add("use_mmap", mmap);
+
+        LasReader reader;
+        reader.setOptions(ops);
+
+        PointTable t;
+        reader.prepare(t);
+        PointViewSet s = reader.execute(t);
+        return *s.begin();
+    };
+
+    std::string file(Support::datapath("las/autzen_trim.las"));
+    PointViewPtr view = read(file, false);
+
+    DimTypeList dims = view->dimTypes();
+    size_t pointSize = view->pointSize();
+    std::vector<char> buf1(pointSize);
+    std::vector<char> buf2(pointSize);
+
+    PointViewPtr mapped = read(file, true);
+    EXPECT_EQ(mapped->size(), view->size());
+    for (PointId i = 0; i < view->size(); i += 100)
+    {
+        view->getPackedPoint(dims, i, buf1.data());
+        mapped->getPackedPoint(dims, i, buf2.data());
+        EXPECT_EQ(memcmp(buf1.data(), buf2.data(), pointSize), 0);
+    }
+
+    Options ops;
+    ops.add("filename", file);
+    ops.add("use_mmap", true);
+
+    LasReader reader;
+    reader.setOptions(ops);
+
+    PointId idx = 0;
+    StreamCallbackFilter f;
+    f.setInput(reader);
+    f.setCallback([&](PointRef& point)
+    {
+        view->getPackedPoint(dims, idx++, buf1.data());
+        point.getPackedData(dims, buf2.data());
+        EXPECT_EQ(memcmp(buf1.data(), buf2.data(), pointSize), 0);
+        return true;
+    });
+
+    FixedPointTable fixed(100);
+    f.prepare(fixed);
+    f.execute(fixed);
+    EXPECT_EQ(idx, view->size());
+
+    // The header of this file claims more points than it holds.
+    PointViewPtr clipped =
+        read(Support::datapath("las/1.2-with-color-clipped.las"), true);
+    EXPECT_EQ(1064u, clipped->size());
+}
+
+
+// Points decoded in parallel are added to the view before they're filled,
+// which must work with tables that don't store packed points.
+TEST(LasReaderTest, columnTable)
+{
+    auto read = [](BasePointTable& table, const std::string& file,
+        bool mmap)
+    {
+        Options ops;
+        ops.add("filename", file);
+        ops.add("use_mmap", mmap);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet s = reader.execute(table);
+        return *s.begin();
+    };
+
+    auto check = [](PointViewPtr expected, PointViewPtr view)
+    {
+        using namespace Dimension;
+
+        ASSERT_EQ(view->size(), expected->size());
+        for (PointId i = 0; i < view->size(); i += 100)
+            for (Id d : { Id::X, Id::Y, Id::Z, Id::Intensity,
+                    Id::Classification, Id::GpsTime })
+                EXPECT_EQ(view->getFieldAs<double>(d, i),
+                    expected->getFieldAs<double>(d, i));
+    };
+
+    std::string las(Support::datapath("las/autzen_trim.las"));
+    PointTable t;
+    PointViewPtr expected = read(t, las, false);
+
+    ColumnPointTable mapped;
+    check(expected, read(mapped, las, true));
+
+#ifdef PDAL_HAVE_LAZPERF
+    ColumnPointTable compressed;
+    check(expected, read(compressed,
+        Support::datapath("laz/autzen_trim.laz"), false));
+#endif
+}
+
+namespace
+{
+
+// Identifying values of a file, as recorded in its index.
+LasIndex::Source indexSource(const std::string& file)
+{
+    Options ops;
+    ops.add("filename", file);
+
+    LasReader reader;
+    reader.setOptions(ops);
+    PointTable t;
+    reader.prepare(t);
+    return LasIndex::source(file, reader.header());
+}
+
+} // unnamed namespace
+
+TEST(LasReaderTest, bounds)
+{
+    auto read = [](const std::string& file, const std::string& bounds)
+    {
+        Options ops;
+        ops.add("filename", file);
+        if (bounds.size())
+            ops.add("bounds", bounds);
+
+        LasReader reader;
+        reader.setOptions(ops);
+
+        PointTable t;
+        reader.prepare(t);
+        PointViewSet s = reader.execute(t);
+        return *s.begin();
+    };
+
+    auto streamCount = [](const std::string& file, const std::string& bounds)
+    {
+        Options ops;
+        ops.add("filename", file);
+        ops.add("bounds", bounds);
+
+        LasReader reader;
+        reader.setOptions(ops);
+
+        point_count_t count = 0;
+        StreamCallbackFilter f;
+        f.setInput(reader);
+        f.setCallback([&count](PointRef&)
+        {
+            count++;
+            return true;
+        });
+
+        FixedPointTable fixed(100);
+        f.prepare(fixed);
+        f.execute(fixed);
+        return count;
+    };
+
+    std::vector<std::string> files { "las/autzen_trim.las" };
+#ifdef PDAL_HAVE_LAZPERF
+    files.push_back("laz/autzen_trim.laz");
+#endif
+    for (const std::string& name : files)
+    {
+        std::string file(Support::temppath(FileUtils::getFilename(name)));
+        FileUtils::deleteFile(file);
+        FileUtils::deleteFile(LasIndex::filename(file));
+        {
+            std::ifstream in(Support::datapath(name), std::ios::binary);
+            std::ofstream out(file, std::ios::binary);
+            out << in.rdbuf();
+        }
+
+        PointViewPtr all = read(file, "");
+        BOX2D box;
+        all->calculateBounds(box);
+        box.minx += (box.maxx - box.minx) / 4;
+        box.maxx -= (box.maxx - box.minx) / 3;
+        box.miny += (box.maxy - box.miny) / 4;
+        box.maxy -= (box.maxy - box.miny) / 3;
+        std::string bounds = "([" + std::to_string(box.minx) + "," +
+            std::to_string(box.maxx) + "],[" + std::to_string(box.miny) +
+            "," + std::to_string(box.maxy) + "])";
+        // Use the box as parsed by the reader.
+        std::istringstream iss(bounds);
+        iss >> box;
+
+        std::vector<PointId> expected;
+        for (PointId i = 0; i < all->size(); ++i)
+            if (box.contains(all->getFieldAs<double>(Dimension::Id::X, i),
+                    all->getFieldAs<double>(Dimension::Id::Y, i)))
+                expected.push_back(i);
+        ASSERT_GT(expected.size(), 0u);
+        ASSERT_LT(expected.size(), all->size());
+
+        auto check = [&]()
+        {
+            PointViewPtr view = read(file, bounds);
+            ASSERT_EQ(view->size(), expected.size());
+            for (PointId i = 0; i < view->size(); ++i)
+            {
+                PointId j = expected[i];
+                EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, i),
+                    all->getFieldAs<double>(Dimension::Id::X, j));
+                EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::Y, i),
+                    all->getFieldAs<double>(Dimension::Id::Y, j));
+                EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::Z, i),
+                    all->getFieldAs<double>(Dimension::Id::Z, j));
+            }
+            EXPECT_EQ(streamCount(file, bounds), expected.size());
+        };
+
+        // Without an index, all points are read and filtered.
+        check();
+
+        LasIndex index;
+        index.build(*all, indexSource(file), 3);
+        index.write(LasIndex::filename(file));
+        check();
+
+        FileUtils::deleteFile(file);
+        FileUtils::deleteFile(LasIndex::filename(file));
+    }
+}
+
+// An index built before a file is rewritten with the same number of
+// points must be ignored rather than used to skip points.
+TEST(LasReaderTest, staleIndex)
+{
+    auto read = [](const std::string& file, const std::string& bounds)
+    {
+        Options ops;
+        ops.add("filename", file);
+        if (bounds.size())
+            ops.add("bounds", bounds);
+
+        LasReader reader;
+        reader.setOptions(ops);
+
+        PointTable t;
+        reader.prepare(t);
+        PointViewSet s = reader.execute(t);
+        return *s.begin();
+    };
+
+    std::string src(Support::datapath("las/autzen_trim.las"));
+    std::string file(Support::temppath("stale_index.las"));
+    FileUtils::deleteFile(file);
+    FileUtils::deleteFile(LasIndex::filename(file));
+    {
+        std::ifstream in(src, std::ios::binary);
+        std::ofstream out(file, std::ios::binary);
+        out << in.rdbuf();
+    }
+
+    PointViewPtr all = read(file, "");
+    LasIndex index;
+    index.build(*all, indexSource(file), 3);
+    index.write(LasIndex::filename(file));
+
+    // Rewrite the file with its points moved half its width along X.
+    BOX2D box;
+    all->calculateBounds(box);
+    const double shift = (box.maxx - box.minx) / 2;
+    {
+        StageFactory factory;
+        Stage *reader = factory.createStage("readers.las");
+        Options ro;
+        ro.add("filename", src);
+        reader->setOptions(ro);
+
+        Stage *xform = factory.createStage("filters.transformation");
+        Options xo;
+        xo.add("matrix", "1 0 0 " + std::to_string(shift) +
+            "  0 1 0 0  0 0 1 0  0 0 0 1");
+        xform->setOptions(xo);
+        xform->setInput(*reader);
+
+        Stage *writer = factory.createStage("writers.las");
+        Options wo;
+        wo.add("filename", file);
+        wo.add("offset_x", "auto");
+        wo.add("offset_y", "auto");
+        wo.add("offset_z", "auto");
+        writer->setOptions(wo);
+        writer->setInput(*xform);
+
+        PointTable t;
+        writer->prepare(t);
+        writer->execute(t);
+    }
+    ASSERT_NE(indexSource(file), index.source());
+
+    box.maxx = box.minx + shift * 1.5;
+    box.minx += shift / 2;
+    std::string bounds = "([" + std::to_string(box.minx) + "," +
+        std::to_string(box.maxx) + "],[" + std::to_string(box.miny) +
+        "," + std::to_string(box.maxy) + "])";
+    std::istringstream iss(bounds);
+    iss >> box;
+
+    PointViewPtr rewritten = read(file, "");
+    point_count_t expected = 0;
+    for (PointId i = 0; i < rewritten->size(); ++i)
+        if (box.contains(rewritten->getFieldAs<double>(Dimension::Id::X, i),
+                rewritten->getFieldAs<double>(Dimension::Id::Y, i)))
+            expected++;
+    ASSERT_GT(expected, 0u);
+    EXPECT_EQ(read(file, bounds)->size(), expected);
+
+    FileUtils::deleteFile(file);
+    FileUtils::deleteFile(LasIndex::filename(file));
+}
 
 // The header of 1.2-with-color-clipped says that it has 1065 points,
 // but it really only has 1064.
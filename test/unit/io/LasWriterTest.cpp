@@ -35,6 +35,8 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <stdlib.h>
+#include <array>
+#include <sstream>
 
 #include <pdal/pdal_features.hpp>
 #include <pdal/PointView.hpp>
@@ -727,6 +729,199 @@ TEST(LasWriterTest, lazperf)
 }
 #endif
 
+#if defined(PDAL_HAVE_LAZPERF)
+// Chunks compressed on the shared executor should produce the same output
+// in standard and stream mode, holding the points of the source.
+TEST(LasWriterTest, lazperf_chunks)
+{
+    auto write = [](const std::string& filename, bool stream)
+    {
+        Options readerOps;
+        readerOps.add("filename", Support::datapath("las/autzen_trim.las"));
+
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        FileUtils::deleteFile(filename);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("compression", "lazperf");
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(reader);
+
+        if (stream)
+        {
+            FixedPointTable t(100);
+            writer.prepare(t);
+            writer.execute(t);
+        }
+        else
+        {
+            PointTable t;
+            writer.prepare(t);
+            writer.execute(t);
+        }
+    };
+
+    std::string standard(Support::temppath("standard.laz"));
+    std::string streamed(Support::temppath("streamed.laz"));
+
+    write(standard, false);
+    write(streamed, true);
+
+    EXPECT_TRUE(Support::compare_files(standard, streamed));
+
+    auto read = [](const std::string& filename)
+    {
+        Options ops;
+        ops.add("filename", filename);
+
+        LasReader r;
+        r.setOptions(ops);
+
+        PointTable t;
+        r.prepare(t);
+        PointViewSet s = r.execute(t);
+        return *s.begin();
+    };
+
+    PointViewPtr source = read(Support::datapath("las/autzen_trim.las"));
+    PointViewPtr written = read(standard);
+    ASSERT_EQ(written->size(), source->size());
+
+    DimTypeList dims = source->dimTypes();
+    size_t pointSize = source->pointSize();
+    std::vector<char> buf1(pointSize);
+    std::vector<char> buf2(pointSize);
+    for (PointId i = 0; i < source->size(); i += 100)
+    {
+        source->getPackedPoint(dims, i, buf1.data());
+        written->getPackedPoint(dims, i, buf2.data());
+        EXPECT_EQ(memcmp(buf1.data(), buf2.data(), pointSize), 0);
+    }
+}
+#endif
+
+#if defined(PDAL_HAVE_LAZPERF)
+// An octree file holds the same points as its source, and the same file is
+// written whether or not points are spooled to disk.  Bounded reads give
+// the points in the bounds and resolution reads give a sample.
+TEST(LasWriterTest, octree)
+{
+    auto write = [](const std::string& filename, point_count_t memoryPoints)
+    {
+        Options readerOps;
+        readerOps.add("filename", Support::datapath("las/autzen_trim.las"));
+
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        FileUtils::deleteFile(filename);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("octree", true);
+        writerOps.add("octree_memory_points", memoryPoints);
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(reader);
+
+        PointTable t;
+        writer.prepare(t);
+        writer.execute(t);
+    };
+
+    auto read = [](const std::string& filename, const Options& extra)
+    {
+        Options ops(extra);
+        ops.add("filename", filename);
+
+        LasReader reader;
+        reader.setOptions(ops);
+
+        PointTable t;
+        reader.prepare(t);
+        PointViewSet s = reader.execute(t);
+        return *s.begin();
+    };
+
+    auto points = [](const PointView& v)
+    {
+        std::vector<std::array<double, 3>> p;
+        for (PointId i = 0; i < v.size(); ++i)
+            p.push_back({{ v.getFieldAs<double>(Dimension::Id::X, i),
+                v.getFieldAs<double>(Dimension::Id::Y, i),
+                v.getFieldAs<double>(Dimension::Id::Z, i) }});
+        std::sort(p.begin(), p.end());
+        return p;
+    };
+
+    std::string serial(Support::temppath("octree.laz"));
+    std::string spooled(Support::temppath("octree_spooled.laz"));
+
+    write(serial, 10000000);
+    write(spooled, 20000);
+    EXPECT_TRUE(Support::compare_files(serial, spooled));
+
+    PointViewPtr source =
+        read(Support::datapath("las/autzen_trim.las"), Options());
+    PointViewPtr all = read(serial, Options());
+    ASSERT_EQ(all->size(), source->size());
+    EXPECT_TRUE(points(*all) == points(*source));
+
+    BOX2D box;
+    all->calculateBounds(box);
+    box.minx += (box.maxx - box.minx) / 4;
+    box.maxx -= (box.maxx - box.minx) / 3;
+    box.miny += (box.maxy - box.miny) / 4;
+    box.maxy -= (box.maxy - box.miny) / 3;
+    std::string bounds = "([" + std::to_string(box.minx) + "," +
+        std::to_string(box.maxx) + "],[" + std::to_string(box.miny) +
+        "," + std::to_string(box.maxy) + "])";
+    std::istringstream iss(bounds);
+    iss >> box;
+
+    PointViewPtr expected = all->makeNew();
+    for (PointId i = 0; i < all->size(); ++i)
+        if (box.contains(all->getFieldAs<double>(Dimension::Id::X, i),
+                all->getFieldAs<double>(Dimension::Id::Y, i)))
+            expected->appendPoint(*all, i);
+    ASSERT_GT(expected->size(), 0u);
+
+    Options boundsOps;
+    boundsOps.add("bounds", bounds);
+    PointViewPtr bounded = read(serial, boundsOps);
+    EXPECT_TRUE(points(*bounded) == points(*expected));
+
+    Options resOps;
+    resOps.add("resolution", (box.maxx - box.minx) / 10);
+    PointViewPtr coarse = read(serial, resOps);
+    EXPECT_GT(coarse->size(), 0u);
+    EXPECT_LT(coarse->size(), all->size());
+
+    FileUtils::deleteFile(serial);
+    FileUtils::deleteFile(spooled);
+}
+
+// Octree output is always LAZ, so a '.las' filename is refused.
+TEST(LasWriterTest, octreeLasName)
+{
+    Options ops;
+    ops.add("filename", Support::temppath("octree.las"));
+    ops.add("octree", true);
+
+    LasWriter w;
+    w.setOptions(ops);
+
+    PointTable t;
+    EXPECT_THROW(w.prepare(t), pdal_error);
+}
+#endif
+
 #if defined(PDAL_HAVE_LASZIP)
 // LAZ files are normally written in chunks of 50,000, so a file of size
 // 110,000 ensures we read some whole chunks and a partial.
@@ -1003,6 +1198,55 @@ void compareFiles(const std::string& name1, const std::string& name2,
     }
 }
 
+// Points are encoded a batch at a time in standard mode and one at a time
+// in stream mode.  Both should produce the same file for each point format.
+TEST(LasWriterTest, formats)
+{
+    auto write = [](const std::string& filename, int format, bool stream)
+    {
+        Options readerOps;
+        readerOps.add("filename", Support::datapath("las/autzen_trim.las"));
+
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        FileUtils::deleteFile(filename);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("minor_version", 4);
+        writerOps.add("dataformat_id", format);
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(reader);
+
+        if (stream)
+        {
+            FixedPointTable t(100);
+            writer.prepare(t);
+            writer.execute(t);
+        }
+        else
+        {
+            PointTable t;
+            writer.prepare(t);
+            writer.execute(t);
+        }
+    };
+
+    std::string standardFile(Support::temppath("standard.las"));
+    std::string streamFile(Support::temppath("stream.las"));
+    for (int format : { 0, 1, 2, 3, 6, 7, 8 })
+    {
+        write(standardFile, format, false);
+        write(streamFile, format, true);
+        EXPECT_TRUE(Support::compare_files(standardFile, streamFile)) <<
+            "Point format " << format;
+        compareFiles(standardFile, streamFile);
+    }
+}
+
 TEST(LasWriterTest, stream)
 {
     std::string infile(Support::datapath("las/autzen_trim.las"));
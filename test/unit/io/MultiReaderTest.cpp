@@ -0,0 +1,217 @@
+/******************************************************************************
+* Copyright (c) 2020, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+
+#include <filters/StreamCallbackFilter.hpp>
+#include <io/LasReader.hpp>
+#include <io/MultiReader.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+const std::string pattern(Support::datapath("las/permutations/1.2_*.las"));
+
+StringList files()
+{
+    StringList names = FileUtils::glob(pattern);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+PointViewPtr readLas(const std::string& filename)
+{
+    Options ops;
+    ops.add("filename", filename);
+
+    LasReader reader;
+    reader.setOptions(ops);
+
+    PointTable t;
+    reader.prepare(t);
+    PointViewSet s = reader.execute(t);
+    return *s.begin();
+}
+
+PointViewSet readMulti(const Options& extra)
+{
+    Options ops(extra);
+    ops.add("filenames", pattern);
+    ops.add("threads", 3);
+
+    MultiReader reader;
+    reader.setOptions(ops);
+
+    PointTable t;
+    reader.prepare(t);
+    return reader.execute(t);
+}
+
+void compare(const PointView& v1, PointId i1, const PointView& v2, PointId i2)
+{
+    using namespace Dimension;
+
+    for (Id id : { Id::X, Id::Y, Id::Z, Id::Intensity })
+        EXPECT_EQ(v1.getFieldAs<double>(id, i1), v2.getFieldAs<double>(id, i2));
+}
+
+} // unnamed namespace
+
+TEST(MultiReaderTest, create)
+{
+    StageFactory f;
+    EXPECT_TRUE(f.createStage("readers.multi"));
+}
+
+// Each file gives a view in file order, or all points go to one view.
+TEST(MultiReaderTest, views)
+{
+    StringList names = files();
+    ASSERT_GT(names.size(), 1u);
+
+    PointViewSet s = readMulti(Options());
+    ASSERT_EQ(s.size(), names.size());
+    auto vi = s.begin();
+    for (const std::string& name : names)
+    {
+        PointViewPtr expected = readLas(name);
+        PointViewPtr v = *vi++;
+        ASSERT_EQ(v->size(), expected->size());
+        for (PointId i = 0; i < v->size(); ++i)
+            compare(*v, i, *expected, i);
+    }
+
+    Options ops;
+    ops.add("merge", true);
+    s = readMulti(ops);
+    ASSERT_EQ(s.size(), 1u);
+    PointViewPtr merged = *s.begin();
+    PointId idx = 0;
+    for (const std::string& name : names)
+    {
+        PointViewPtr expected = readLas(name);
+        for (PointId i = 0; i < expected->size(); ++i)
+            compare(*merged, idx++, *expected, i);
+    }
+    EXPECT_EQ(merged->size(), idx);
+
+    ops.add("count", 100);
+    s = readMulti(ops);
+    EXPECT_EQ((*s.begin())->size(), 100u);
+}
+
+// Points of all files are streamed, in whatever order chunks are read.
+TEST(MultiReaderTest, stream)
+{
+    point_count_t expectedCount = 0;
+    double expectedSum = 0;
+    for (const std::string& name : files())
+    {
+        PointViewPtr v = readLas(name);
+        expectedCount += v->size();
+        for (PointId i = 0; i < v->size(); ++i)
+            expectedSum += v->getFieldAs<double>(Dimension::Id::X, i);
+    }
+
+    Options ops;
+    ops.add("filenames", pattern);
+    ops.add("threads", 3);
+    ops.add("chunk_size", 50);
+
+    MultiReader reader;
+    reader.setOptions(ops);
+
+    point_count_t count = 0;
+    double sum = 0;
+    StreamCallbackFilter f;
+    f.setInput(reader);
+    f.setCallback([&count, &sum](PointRef& point)
+    {
+        count++;
+        sum += point.getFieldAs<double>(Dimension::Id::X);
+        return true;
+    });
+
+    FixedPointTable t(100);
+    f.prepare(t);
+    f.execute(t);
+    EXPECT_EQ(count, expectedCount);
+    EXPECT_DOUBLE_EQ(sum, expectedSum);
+}
+
+// A preview sums the headers of the files.
+TEST(MultiReaderTest, preview)
+{
+    point_count_t expectedCount = 0;
+    BOX3D expectedBounds;
+    for (const std::string& name : files())
+    {
+        Options ops;
+        ops.add("filename", name);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        QuickInfo qi = reader.preview();
+        expectedCount += qi.m_pointCount;
+        expectedBounds.grow(qi.m_bounds);
+    }
+
+    Options ops;
+    ops.add("filenames", pattern);
+
+    MultiReader reader;
+    reader.setOptions(ops);
+    QuickInfo qi = reader.preview();
+    EXPECT_TRUE(qi.valid());
+    EXPECT_EQ(qi.m_pointCount, expectedCount);
+    EXPECT_EQ(qi.m_bounds, expectedBounds);
+}
+
+TEST(MultiReaderTest, nomatch)
+{
+    Options ops;
+    ops.add("filenames", Support::datapath("las/permutations/none_*.las"));
+
+    MultiReader reader;
+    reader.setOptions(ops);
+
+    PointTable t;
+    EXPECT_THROW(reader.prepare(t), pdal_error);
+}